@@ -0,0 +1,181 @@
+#!/bin/bash
+# bench.sh decompiler benchmark script
+# Decompiles a fixed corpus of the test/ binaries a number of times, and records the best wall time of each phase
+# (load, decode, decompile, codegen), the peak resident memory, the number of allocations and the number of prover
+# invocations of each, as written by boomerang -Bj. The results are saved as JSON, which can then be used as the
+# baseline for later runs.
+#
+# Usage: ./bench.sh [-r runs] [-b boomerang] [-o results.json] [-c baseline.json] [-t percent] [boomerang switches]
+#   -r  runs per binary (default 3); the minimum of each measurement over the runs is recorded
+#   -b  the boomerang executable (default ./boomerang)
+#   -o  where to save the results (default bench.json)
+#   -c  compare the results with a baseline saved earlier, and fail if anything regressed
+#   -t  threshold for -c, in percent (default 10). Times must also have grown by at least 5 ms to count
+# e.g.
+#   ./bench.sh -r 5 -o baseline.json
+#   ./bench.sh -r 5 -c baseline.json -t 5
+#
+# The mips binaries are left out, as they are in functest.sh.
+#
+
+RUNS=3
+BOOMERANG=./boomerang
+RESULTS=bench.json
+BASELINE=
+THRESHOLD=10
+MINDIFF_MS=5
+
+while getopts "r:b:o:c:t:" OPT
+do
+	case $OPT in
+		r) RUNS=$OPTARG;;
+		b) BOOMERANG=$OPTARG;;
+		o) RESULTS=$OPTARG;;
+		c) BASELINE=$OPTARG;;
+		t) THRESHOLD=$OPTARG;;
+		*) exit 2;;
+	esac
+done
+shift $((OPTIND - 1))
+BOOMSW=$*
+
+CORPUS="
+	test/pentium/hello
+	test/pentium/twoproc
+	test/pentium/fib
+	test/pentium/fibo-O4
+	test/pentium/global1
+	test/pentium/banner
+	test/pentium/printpi
+	test/pentium/recursion
+	test/pentium/sumarray-O4
+	test/pentium/nestedswitch
+	test/pentium/switch_gcc
+	test/sparc/hello
+	test/sparc/fib
+	test/sparc/fibo-O4
+	test/sparc/recursion
+	test/sparc/switch_gcc
+	test/ppc/hello
+	test/ppc/fib
+	test/ppc/global1
+	test/ppc/switch
+	test/OSX/hello
+	test/OSX/fib
+"
+
+if [ ! -x $BOOMERANG ]; then
+	echo "$BOOMERANG not found; use -b to give the boomerang executable"
+	exit 2
+fi
+if [ -n "$BASELINE" -a ! -f "$BASELINE" ]; then
+	echo "baseline $BASELINE not found"
+	exit 2
+fi
+
+SPACES="                                                 "
+rm -rf bench
+mkdir bench
+
+# Turn a results file into lines of "program measurement value"
+flatten() {
+	awk -F'"' '/^    "/ {
+		prog = $2
+		rest = substr($0, index($0, "{") + 1)
+		gsub(/[{} "]/, "", rest)
+		sub(/,$/, "", rest)
+		n = split(rest, kv, ",")
+		for (i = 1; i <= n; i++) {
+			split(kv[i], p, ":")
+			print prog, p[1], p[2]
+		}
+	}' $1
+}
+
+echo "{" > bench/results.tmp
+echo "  \"runs\": $RUNS," >> bench/results.tmp
+echo "  \"switches\": \"$BOOMSW\"," >> bench/results.tmp
+echo "  \"programs\": {" >> bench/results.tmp
+SEP=""
+
+for PROG in $CORPUS
+do
+	[ -f $PROG ] || continue
+
+	RES="$PROG:"
+	WHITE=${SPACES:0:(30 - ${#RES})}
+	echo -n "$RES$WHITE"
+
+	FAILED=""
+	rm -f bench/best.tmp
+	for (( i = 0; i < RUNS; i++ ))
+	do
+		rm -f bench/run.json
+		sh -c "$BOOMERANG -o bench -Bj bench/run.json $BOOMSW $PROG 2>/dev/null >/dev/null"
+		if [[ $? -ne 0 || ! -f bench/run.json ]]; then
+			FAILED=1
+			break
+		fi
+		# Keep the minimum of each measurement over the runs
+		awk -F'[":, ]+' '/_ms"|peak_rss_kb|allocations|prover_calls/ { print $2, $3 }' bench/run.json > bench/this.tmp
+		if [ -f bench/best.tmp ]; then
+			awk 'NR == FNR { best[$1] = $2; next } { if (!($1 in best) || $2 < best[$1]) best[$1] = $2; print $1, best[$1] }' \
+				bench/best.tmp bench/this.tmp > bench/min.tmp
+			mv bench/min.tmp bench/best.tmp
+		else
+			mv bench/this.tmp bench/best.tmp
+		fi
+	done
+
+	if [ -n "$FAILED" ]; then
+		echo "boomerang FAILED"
+		continue
+	fi
+	awk '$1 == "total_ms" { t = $2 } $1 == "peak_rss_kb" { r = $2 } $1 == "allocations" { a = $2 }
+		$1 == "prover_calls" { p = $2 }
+		END { printf "%6d ms %8d KB %10d allocations %6d prover calls\n", t, r, a, p }' bench/best.tmp
+	echo -n "$SEP    \"$PROG\": {" >> bench/results.tmp
+	awk '{ printf "%s\"%s\": %s", NR == 1 ? "" : ", ", $1, $2 }' bench/best.tmp >> bench/results.tmp
+	echo -n "}" >> bench/results.tmp
+	SEP=",
+"
+done
+
+echo >> bench/results.tmp
+echo "  }" >> bench/results.tmp
+echo "}" >> bench/results.tmp
+mv bench/results.tmp $RESULTS
+echo "results saved in $RESULTS"
+
+if [ -z "$BASELINE" ]; then
+	exit 0
+fi
+
+# Compare with the baseline. Anything that is new or missing is reported, but isn't a regression
+flatten $BASELINE > bench/old.tmp
+flatten $RESULTS > bench/new.tmp
+awk -v threshold=$THRESHOLD -v mindiff=$MINDIFF_MS '
+	NR == FNR { old[$1 " " $2] = $3; next }
+	{
+		key = $1 " " $2
+		if (!(key in old)) {
+			print "new:        " key " = " $3
+			next
+		}
+		o = old[key]; n = $3
+		delete old[key]
+		if (n > o * (1 + threshold / 100) && ($2 !~ /_ms$/ || n - o >= mindiff)) {
+			printf "REGRESSION: %s %s -> %s (+%d%%)\n", key, o, n, o ? (n - o) * 100 / o : 100
+			regressions++
+		} else if (n < o * (1 - threshold / 100) && ($2 !~ /_ms$/ || o - n >= mindiff))
+			printf "improved:   %s %s -> %s (-%d%%)\n", key, o, n, (o - n) * 100 / o
+	}
+	END {
+		for (key in old)
+			print "missing:    " key
+		if (regressions) {
+			print regressions " regression(s) beyond " threshold "% compared with the baseline"
+			exit 1
+		}
+		print "no regressions beyond " threshold "% compared with the baseline"
+	}' bench/old.tmp bench/new.tmp
@@ -0,0 +1,53 @@
+#!/bin/bash
+# benchswitch.sh switch statement benchmark script
+# Decompiles each of the test/*/switch_* binaries a number of times and reports the average wall time of each.
+# Mainly exercises the recognition of switch statements (BasicBlock::decodeIndirectJmp)
+# Call with the number of runs per binary (default 3), then any boomerang switches, e.g.
+#   ./benchswitch.sh 5 -nG
+#
+# Results are also appended to benchswitch.out, so that several versions of boomerang can be compared
+#
+
+RUNS=${1:-3}
+shift
+BOOMSW=$*
+
+SPACES="                                                 "
+TOTAL=0
+
+rm -rf benchswitch
+mkdir benchswitch
+echo "=== `date` runs=$RUNS switches=\"$BOOMSW\" ===" >> benchswitch.out
+
+for PROG in test/*/switch_*
+do
+	# Skip sources, expected outputs, etc
+	case $PROG in
+		*.c|*.out*|*.sed|*.in*) continue;;
+	esac
+	[ -f $PROG ] || continue
+
+	RES="$PROG:"
+	WHITE=${SPACES:0:(34 - ${#RES})}
+	echo -n "$RES$WHITE"
+
+	FAILED=""
+	START=`date +%s%N`
+	for (( i = 0; i < RUNS; i++ ))
+	do
+		sh -c "./boomerang -o benchswitch $BOOMSW $PROG 2>/dev/null >/dev/null"
+		if [[ $? -ne 0 ]]; then
+			FAILED=" (boomerang FAILED)"
+		fi
+	done
+	END=`date +%s%N`
+	MS=$(( (END - START) / 1000000 / RUNS ))
+	TOTAL=$(( TOTAL + MS ))
+
+	echo "$MS ms$FAILED"
+	echo "$RES$WHITE$MS ms$FAILED" >> benchswitch.out
+done
+
+echo "total:                            $TOTAL ms"
+echo "total:                            $TOTAL ms" >> benchswitch.out
+echo >> benchswitch.out
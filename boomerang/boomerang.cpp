@@ -23,6 +23,7 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <ctime>
 #include <cstring>
 #include <cstdlib>
@@ -30,7 +31,10 @@
 #include <direct.h>			// mkdir under Windows
 #else
 #include <sys/stat.h>		// For mkdir
-#include <unistd.h>			// For unlink
+#include <sys/wait.h>		// For waitpid
+#include <unistd.h>			// For unlink, fork
+#include <poll.h>			// For poll
+#include <cerrno>
 #include <csignal>
 #endif
 #if defined(_MSC_VER) || defined(__MINGW32__)
@@ -40,11 +44,14 @@
 #include "proc.h"
 #include "BinaryFile.h"
 #include "frontend.h"
+#include "rtl.h"
 #include "hllcode.h"
 #include "codegen/chllcode.h"
 //#include "transformer.h"
 #include "boomerang.h"
 #include "log.h"
+#include "progsnapshot.h"
+#include "budget.h"
 #if USE_XML
 #include "xmlprogparser.h"
 #endif
@@ -58,6 +65,9 @@
 #include "gc.h"
 #endif
 Boomerang *Boomerang::boomerang = NULL;
+Boomerang *Boomerang::current = NULL;
+unsigned long Boomerang::numAllocations = 0;
+unsigned long Boomerang::numAllocatedBytes = 0;
 
 /**
  * Initializes the Boomerang object.
@@ -68,7 +78,7 @@ Boomerang *Boomerang::boomerang = NULL;
  * - The path to the executable is "./"
  * - The output directory is "./output/"
  */
-Boomerang::Boomerang() : logger(NULL), vFlag(false), printRtl(false),
+Boomerang::Boomerang() : logger(NULL), benchPhaseStart(0), vFlag(false), printRtl(false),
   noBranchSimplify(false), noRemoveNull(false), noLocals(false),
   noRemoveLabels(false), noDataflow(false), noDecompile(false), stopBeforeDecompile(false),
   traceDecoder(false), dotFile(NULL), numToPropagate(-1),
@@ -78,12 +88,35 @@ Boomerang::Boomerang() : logger(NULL), vFlag(false), printRtl(false),
   noRemoveReturns(false), debugDecoder(false), decodeThruIndCall(false), ofsIndCallReport(NULL),
   noDecodeChildren(false), debugProof(false), debugUnused(false),
   loadBeforeDecompile(false), saveBeforeDecompile(false),
-  noProve(false), noChangeSignatures(false), conTypeAnalysis(false), dfaTypeAnalysis(true),
+  noProve(false), noProofMemo(false), noChangeSignatures(false), conTypeAnalysis(false), dfaTypeAnalysis(true),
   propMaxDepth(3), generateCallGraph(false), generateSymbols(false), noGlobals(false), assumeABI(false),
-  experimental(false), minsToStopAfter(0)
+  experimental(false), minsToStopAfter(0), procTimeBudget(0), phaseTimeBudget(0), procStmtBudget(0),
+  procMemBudget(0), decoderBenchRuns(0), internTypes(false), batchWorkers(1), keepResident(false)
 {
   progPath = "./";
   outputPath = "./output/";
+  memset(progressCounts, 0, sizeof(progressCounts));
+}
+
+/**
+ * Makes a new context for another decompilation in the same process. It starts with the options of this one
+ * (including the logger, which the caller will usually replace with setLogger()), but with no watchers. Decompile with
+ * the new context's decompile(), or make it current with a ContextScope before making a Prog; the Prog then keeps it
+ * (see Prog::getContext()).
+ *
+ * A context only separates the options, logger, watchers and progress of a decompilation. The named and interned
+ * types, the SSL dictionaries, resident signatures and loaders, and the statement numbering are still shared by the
+ * whole process and are not locked, so decompilations must run one at a time, not in concurrent threads.
+ *
+ * \return The new context.
+ */
+Boomerang *Boomerang::newContext()
+{
+  Boomerang *ctx = new Boomerang(*this);
+  ctx->watchers.clear();
+  ctx->benchPhases.clear();
+  memset(ctx->progressCounts, 0, sizeof(ctx->progressCounts));
+  return ctx;
 }
 
 /**
@@ -127,6 +160,12 @@ void Boomerang::helpcmd()
   //            ____.____1____.____2____.____3____.____4____.____5____.____6____.____7____.____8
   std::cout << "Available commands (for use with -k):\n";
   std::cout << "  decode                             : Loads and decodes the specified binary.\n";
+  std::cout << "  load <file>                        : Loads a saved program.\n";
+  std::cout << "  save [file]                        : Saves the program (default: in the output\n";
+  std::cout << "                                       directory, as <name>.bsnap).\n";
+#if USE_XML
+  std::cout << "  savexml                            : Saves the program as XML.\n";
+#endif
   std::cout << "  decompile [proc]                   : Decompiles the program or specified proc.\n";
   std::cout << "  codegen [cluster]                  : Generates code for the program or a\n";
   std::cout << "                                       specified cluster.\n";
@@ -161,13 +200,22 @@ void Boomerang::help()
   std::cout << "                     Use -e and -E repeatedly for multiple entry points\n";
   std::cout << "  -ic              : Decode through type 0 Indirect Calls\n";
   std::cout << "  -S <min>         : Stop decompilation after specified number of minutes\n";
+  std::cout << "  -bt <sec>        : Budget of wall time for decompiling each procedure\n";
+  std::cout << "  -bp <sec>        : Budget of wall time for each phase of each procedure\n";
+  std::cout << "  -bs <num>        : Budget of statements processed for each procedure\n";
+  std::cout << "  -bm <KB>         : Budget of memory allocated for each procedure\n";
+  std::cout << "                     Procedures over budget are decompiled less thoroughly\n";
+  std::cout << "  -Bd <runs>       : Benchmark the decoder over the code sections, then stop\n";
+  std::cout << "  -Bj <file>       : Write the time of each phase, peak memory and allocations to file (JSON)\n";
+  std::cout << "  -Bf <file>       : Batch: decompile each program listed in file (instead of <program>)\n";
+  std::cout << "  -Bw <num>        : Batch: share the programs among num worker processes\n";
+  std::cout << "  -Bc <dir>        : Save parsed SSL files in dir (e.g. output/cache), and load them from there\n";
   std::cout << "  -t               : Trace (print address of) every instruction decoded\n";
   std::cout << "  -Tc              : Use old constraint-based type analysis\n";
   std::cout << "  -Td              : Use data-flow-based type analysis\n";
-#if USE_XML
-  std::cout << "  -LD              : Load before decompile (<program> becomes xml input file)\n";
+  std::cout << "  -Ti              : Share (intern) simple types in data-flow-based type analysis\n";
+  std::cout << "  -LD              : Load before decompile (<program> becomes a saved program file)\n";
   std::cout << "  -SD              : Save before decompile\n";
-#endif
   std::cout << "  -a               : Assume ABI compliance\n";
   std::cout << "  -W               : Windows specific decompilation mode (requires pdb information)\n";
 //	std::cout << "  -pa              : only propagate if can propagate to all\n";
@@ -203,6 +251,7 @@ void Boomerang::help()
   std::cout << "  -nd              : No (reduced) dataflow analysis\n";
   std::cout << "  -nD              : No decompilation (at all!)\n";
   std::cout << "  -nl              : No creation of local variables\n";
+  std::cout << "  -nM              : No memoisation of proofs (for comparing prover invocations)\n";
 //	std::cout << "  -nm              : No decoding of the 'main' procedure\n";
   std::cout << "  -ng              : No replacement of expressions with Globals\n";
   std::cout << "  -nG              : No garbage collection\n";
@@ -323,7 +372,6 @@ int Boomerang::parseCmd(int argc, const char **argv)
           return 1;
         }
       prog = p;
-#if USE_XML
     }
   else if (!strcmp(argv[0], "load"))
     {
@@ -333,21 +381,35 @@ int Boomerang::parseCmd(int argc, const char **argv)
           return 1;
         }
       const char *fname = argv[1];
-      XMLProgParser *p = new XMLProgParser();
-      Prog *pr = p->parse(fname);
+      Prog *pr = loadProg(fname);
       if (pr == NULL)
         {
           // try guessing
-          pr = p->parse((outputPath + fname + "/" + fname + ".xml").c_str());
+          pr = loadProg((outputPath + fname + "/" + fname + ".bsnap").c_str());
+#if USE_XML
+          if (pr == NULL)
+            pr = loadProg((outputPath + fname + "/" + fname + ".xml").c_str());
+#endif
           if (pr == NULL)
             {
-              std::cerr << "failed to read xml " << fname << "\n";
+              std::cerr << "failed to read " << fname << "\n";
               return 1;
             }
         }
       prog = pr;
     }
   else if (!strcmp(argv[0], "save"))
+    {
+      if (prog == NULL)
+        {
+          std::cerr << "need to load or decode before save!\n";
+          return 1;
+        }
+      if (!saveProg(prog, argc > 1 ? argv[1] : NULL))
+        return 1;
+#if USE_XML
+    }
+  else if (!strcmp(argv[0], "savexml"))
     {
       if (prog == NULL)
         {
@@ -858,6 +920,8 @@ int Boomerang::commandLine(int argc, const char **argv)
             }
           else if (argv[i][2] == 'd')
             dfaTypeAnalysis = true;		// -Td: use data-flow-based type analysis (now default)
+          else if (argv[i][2] == 'i')
+            internTypes = true;			// -Ti: intern types (see Type::intern())
           break;
         case 'g':
           if (argv[i][2]=='d')
@@ -912,6 +976,9 @@ int Boomerang::commandLine(int argc, const char **argv)
             case 'l':
               noLocals = true;
               break;
+            case 'M':
+              noProofMemo = true;
+              break;
             case 'n':
               noRemoveNull = true;
               break;
@@ -1054,19 +1121,11 @@ int Boomerang::commandLine(int argc, const char **argv)
           break;
         case 'L':
           if (argv[i][2] == 'D')
-#if USE_XML
             loadBeforeDecompile = true;
-#else
-            std::cerr << "LD command not enabled since compiled without USE_XML\n";
-#endif
           break;
         case 'S':
           if (argv[i][2] == 'D')
-#if USE_XML
             saveBeforeDecompile = true;
-#else
-            std::cerr << "SD command not enabled since compiled without USE_XML\n";
-#endif
           else
             {
               sscanf(argv[++i], "%i", &minsToStopAfter);
@@ -1075,6 +1134,52 @@ int Boomerang::commandLine(int argc, const char **argv)
         case 'k':
           kmd = 1;
           break;
+        case 'b':
+          if ((argv[i][2] != 't' && argv[i][2] != 'p' && argv[i][2] != 's' && argv[i][2] != 'm') || ++i == argc)
+            {
+              usage();
+              return 1;
+            }
+          switch (argv[i-1][2])
+            {
+            case 't':
+              sscanf(argv[i], "%i", &procTimeBudget);
+              break;
+            case 'p':
+              sscanf(argv[i], "%i", &phaseTimeBudget);
+              break;
+            case 's':
+              sscanf(argv[i], "%i", &procStmtBudget);
+              break;
+            case 'm':
+              sscanf(argv[i], "%i", &procMemBudget);
+              break;
+            }
+          break;
+        case 'B':
+          if ((argv[i][2] != 'd' && argv[i][2] != 'j' && argv[i][2] != 'f' && argv[i][2] != 'w' &&
+               argv[i][2] != 'c') || ++i == argc)
+            {
+              usage();
+              return 1;
+            }
+          if (argv[i-1][2] == 'j')
+            benchStatsFile = argv[i];
+          else if (argv[i-1][2] == 'f')
+            batchFile = argv[i];
+          else if (argv[i-1][2] == 'w')
+            sscanf(argv[i], "%i", &batchWorkers);
+          else if (argv[i-1][2] == 'c')
+            {
+              dictCacheDir = argv[i];
+              if (dictCacheDir[dictCacheDir.length()-1] != '/')
+                dictCacheDir += '/';
+              if (!createDirectory(dictCacheDir))
+                std::cerr << "Warning! Could not create path " << dictCacheDir << "!\n";
+            }
+          else
+            sscanf(argv[i], "%i", &decoderBenchRuns);
+          break;
         case 'P':
           progPath = argv[++i];
           if (progPath[progPath.length()-1] != '\\')
@@ -1101,6 +1206,9 @@ int Boomerang::commandLine(int argc, const char **argv)
   if (kmd)
     return cmdLine();
 
+  if (!batchFile.empty())
+    return batchDecompile(batchFile.c_str());
+
   return decompile(argv[argc-1]);
 }
 
@@ -1177,6 +1285,7 @@ void Boomerang::objcDecode(std::map<std::string, ObjcModule> &modules, Prog *pro
  */
 Prog *Boomerang::loadAndDecode(const char *fname, const char *pname)
 {
+  ContextScope scope(this);
   std::cout << "loading...\n";
   Prog *prog = new Prog();
   FrontEnd *fe = FrontEnd::Load(fname, prog);
@@ -1186,6 +1295,14 @@ Prog *Boomerang::loadAndDecode(const char *fname, const char *pname)
       return NULL;
     }
   prog->setFrontEnd(fe);
+  benchPhase("decode");
+
+  if (decoderBenchRuns)
+    {
+      fe->benchmarkDecoder(std::cout, decoderBenchRuns);
+      stopBeforeDecompile = true;
+      return prog;
+    }
 
   // Add symbols from -s switch(es)
   for (std::map<ADDRESS, std::string>::iterator it = symbols.begin();
@@ -1288,9 +1405,12 @@ void stopProcess(int n)
  */
 int Boomerang::decompile(const char *fname, const char *pname)
 {
+  ContextScope scope(this);
   Prog *prog;
   time_t start;
   time(&start);
+  benchPhases.clear();
+  benchPhase("load");
 
   if (minsToStopAfter)
     {
@@ -1307,34 +1427,36 @@ int Boomerang::decompile(const char *fname, const char *pname)
 //	std::cout << "setting up transformers...\n";
 //	ExpTransformer::loadAll();
 
-#if USE_XML
   if (loadBeforeDecompile)
     {
       std::cout << "loading persisted state...\n";
-      XMLProgParser *p = new XMLProgParser();
-      prog = p->parse(fname);
+      prog = loadProg(fname);
+      if (prog == NULL)
+        return 1;
     }
   else
-#endif
     {
       prog = loadAndDecode(fname, pname);
       if (prog == NULL)
         return 1;
     }
 
-#if USE_XML
   if (saveBeforeDecompile)
     {
       std::cout << "saving persistable state...\n";
-      XMLProgParser *p = new XMLProgParser();
-      p->persistToXML(prog);
+      saveProg(prog);
     }
-#endif
 
   if (stopBeforeDecompile)
-    return 0;
+    {
+      benchPhase(NULL);
+      if (!benchStatsFile.empty())
+        writeBenchStats(fname, prog);
+      return 0;
+    }
 
   std::cout << "decompiling...\n";
+  benchPhase("decompile");
   prog->decompile();
 
   if (dotFile)
@@ -1354,10 +1476,17 @@ int Boomerang::decompile(const char *fname, const char *pname)
     }
 
   std::cout << "generating code...\n";
+  benchPhase("codegen");
   prog->generateCode();
+  benchPhase(NULL);
 
   std::cout << "output written to " << outputPath << prog->getRootCluster()->getName() << "\n";
 
+  std::ostringstream ost;
+  prog->printBudgetSummary(ost);
+  std::cout << ost.str();
+  LOG << ost.str().c_str();
+
   if (Boomerang::get()->ofsIndCallReport)
     ofsIndCallReport->close();
 
@@ -1373,9 +1502,315 @@ int Boomerang::decompile(const char *fname, const char *pname)
     std::cout << mins << " mins ";
   std::cout << secs << " sec" << (secs == 1 ? "" : "s") << ".\n";
 
+  if (!benchStatsFile.empty())
+    writeBenchStats(fname, prog);
+
   return 0;
 }
 
+/**
+ * Decompiles each of the programs listed in a file, one per line (blank lines and lines starting with # are ignored),
+ * as decompile() does. The loader libraries, SSL dictionaries and library signatures are kept for later programs, so
+ * that the cost of starting up is paid once. With -Bw, the programs are shared among that many worker processes. A
+ * worker that dies (crashed, or stopped by -S) is restarted after the program that it was decompiling. With -S, the
+ * programs are decompiled in a worker process even without -Bw, so that the timeout stops only the program that ran
+ * out of time, and not the rest of the batch.
+ *
+ * \param listFile The file with the names of the programs.
+ *
+ * \return Zero if all the programs were decompiled, nonzero otherwise.
+ */
+int Boomerang::batchDecompile(const char *listFile)
+{
+  std::ifstream ifs(listFile);
+  if (!ifs)
+    {
+      std::cerr << "cannot read " << listFile << "\n";
+      return 1;
+    }
+  std::vector<std::string> files;
+  std::string line;
+  while (std::getline(ifs, line))
+    {
+      size_t end = line.find_last_not_of(" \t\r");
+      if (end == std::string::npos || line[0] == '#')
+        continue;
+      files.push_back(line.substr(0, end+1));
+    }
+
+  keepResident = true;
+  BinaryFileFactory::setKeepLoaded(true);
+
+  // The result of each program, as returned by decompile(); -1 if its worker died while decompiling it
+  std::vector<int> results(files.size(), -1);
+  unsigned workers = batchWorkers < 1 ? 1 : batchWorkers;
+  if (workers > files.size())
+    workers = files.size();
+#ifdef _WIN32
+  if (minsToStopAfter)
+    {
+      // -S stops the whole process, and so would stop the rest of the batch
+      std::cerr << "batch: -S is not supported with -Bf under Windows\n";
+      return 1;
+    }
+#else
+  // -S stops the whole process when it expires, so with -S even a single worker is a separate process, and only the
+  // program that ran out of time is lost
+  if (workers > 1 || minsToStopAfter)
+    {
+      // Worker w decompiles programs w, w + workers, w + 2*workers, etc, and reports each result as soon as it has it.
+      // The pipes of all the workers are polled together, so that a worker is restarted as soon as it dies
+      std::vector<int> pids(workers), fds(workers);
+      std::vector<unsigned> next(workers);	// The next program that each worker has not reported
+      std::vector<std::string> pending(workers);	// What has been read of an incomplete line from each worker
+      unsigned w;
+      for (w = 0; w < workers; w++)
+        {
+          pids[w] = forkBatchWorker(files, w, workers, fds[w]);
+          next[w] = w;
+        }
+      for (;;)
+        {
+          std::vector<struct pollfd> pfds;
+          std::vector<unsigned> which;
+          for (w = 0; w < workers; w++)
+            if (pids[w] != -1)
+              {
+                struct pollfd pfd;
+                pfd.fd = fds[w];
+                pfd.events = POLLIN;
+                pfd.revents = 0;
+                pfds.push_back(pfd);
+                which.push_back(w);
+              }
+          if (pfds.empty())
+            break;
+          if (poll(&pfds[0], pfds.size(), -1) == -1)
+            {
+              if (errno == EINTR)
+                continue;
+              perror("batch: poll");
+              break;
+            }
+          for (unsigned k = 0; k < pfds.size(); k++)
+            {
+              if (pfds[k].revents == 0)
+                continue;
+              w = which[k];
+              char buf[256];
+              int n = read(fds[w], buf, sizeof(buf));
+              if (n == -1 && errno == EINTR)
+                continue;
+              if (n > 0)
+                {
+                  pending[w].append(buf, n);
+                  size_t eol;
+                  while ((eol = pending[w].find('\n')) != std::string::npos)
+                    {
+                      unsigned i;
+                      int ret;
+                      if (sscanf(pending[w].c_str(), "%u %d", &i, &ret) == 2 && i < files.size())
+                        {
+                          results[i] = ret;
+                          next[w] = i + workers;
+                        }
+                      pending[w].erase(0, eol+1);
+                    }
+                  continue;
+                }
+              // End of file (or an error): the worker has finished, or died
+              close(fds[w]);
+              waitpid(pids[w], NULL, 0);
+              pids[w] = -1;
+              pending[w].clear();
+              if (next[w] < files.size())
+                {
+                  std::cerr << "batch: worker died decompiling " << files[next[w]] << "\n";
+                  next[w] += workers;
+                  if (next[w] < files.size())
+                    pids[w] = forkBatchWorker(files, next[w], workers, fds[w]);
+                }
+            }
+        }
+    }
+  else
+#endif
+    for (unsigned i = 0; i < files.size(); i++)
+      results[i] = batchDecompileOne(files[i].c_str());
+
+  unsigned failed = 0;
+  for (unsigned i = 0; i < files.size(); i++)
+    if (results[i] != 0)
+      {
+        std::cout << "batch: " << (results[i] == -1 ? "died decompiling " : "failed to decompile ") << files[i] << "\n";
+        failed++;
+      }
+  std::cout << "batch: " << files.size() - failed << " of " << files.size() << " programs decompiled\n";
+
+  // The programs are finished with, so nothing refers to what was kept for them any more
+  keepResident = false;
+  RTLInstDict::freeDicts();
+  FrontEnd::freeResidentSignatures();
+  return failed != 0;
+}
+
+/**
+ * Decompiles one program of a batch with decompile(), and resets what applies to one program only.
+ *
+ * \param fname The name of the program.
+ *
+ * \return As for decompile().
+ */
+int Boomerang::batchDecompileOne(const char *fname)
+{
+  std::cout << "batch: decompiling " << fname << "\n";
+  std::cout.flush();						// In case it crashes
+  int ret = decompile(fname);
+#ifndef _WIN32
+  if (minsToStopAfter)
+    alarm(0);								// -S is for each program
+#endif
+  std::cout.flush();
+  std::cerr.flush();
+  return ret;
+}
+
+/**
+ * Starts a worker process for batchDecompile(), which decompiles files[first], files[first+step], etc. After each
+ * program, the worker writes a line with its index and result to a pipe, so that the parent knows how far the
+ * worker got if it dies.
+ *
+ * \param files The programs of the batch.
+ * \param first The index of the first program for the worker.
+ * \param step The distance between the programs for the worker.
+ * \param fd Set to the end of the pipe from which the parent reads the results.
+ *
+ * \return The process id of the worker, or -1 if it could not be started.
+ */
+int Boomerang::forkBatchWorker(const std::vector<std::string> &files, unsigned first, unsigned step, int &fd)
+{
+#ifdef _WIN32
+  return -1;
+#else
+  int pfd[2];
+  if (pipe(pfd) != 0)
+    {
+      perror("batch: pipe");
+      return -1;
+    }
+  std::cout.flush();						// Else the worker writes what is buffered again
+  std::cerr.flush();
+  int pid = fork();
+  if (pid == 0)
+    {
+      close(pfd[0]);
+      for (unsigned i = first; i < files.size(); i += step)
+        {
+          int ret = batchDecompileOne(files[i].c_str());
+          char line[32];
+          sprintf(line, "%u %d\n", i, ret);
+          write(pfd[1], line, strlen(line));
+        }
+      close(pfd[1]);
+      exit(0);
+    }
+  close(pfd[1]);
+  if (pid == -1)
+    {
+      perror("batch: fork");
+      close(pfd[0]);
+      return -1;
+    }
+  fd = pfd[0];
+  return pid;
+#endif
+}
+
+/**
+ * Ends the phase of the decompilation being timed for -Bj (if any), and starts timing the next one.
+ * \param name The name of the next phase, or NULL if no more phases follow.
+ */
+void Boomerang::benchPhase(const char *name)
+{
+  unsigned now = ProcBudget::wallMillis();
+  if (!benchPhases.empty() && benchPhases.back().second == (unsigned)-1)
+    benchPhases.back().second = now - benchPhaseStart;
+  if (name)
+    benchPhases.push_back(std::pair<const char*, unsigned>(name, (unsigned)-1));
+  benchPhaseStart = now;
+}
+
+/**
+ * Writes the statistics of the last decompilation to the file given with -Bj, as a JSON object with one member per
+ * line, so that scripts (see bench.sh) don't need a full JSON parser to read it.
+ * \param fname The name of the program that was decompiled.
+ * \param prog The program, for the number of prover invocations.
+ */
+void Boomerang::writeBenchStats(const char *fname, Prog *prog)
+{
+  std::ofstream ofs(benchStatsFile.c_str());
+  if (!ofs)
+    {
+      std::cerr << "cannot write " << benchStatsFile << "\n";
+      return;
+    }
+  ofs << "{\n";
+  ofs << "  \"program\": \"";
+  for (const char *p = fname; *p; p++)
+    {
+      if (*p == '"' || *p == '\\')
+        ofs << '\\';
+      ofs << *p;
+    }
+  ofs << "\",\n";
+  unsigned total = 0;
+  for (unsigned i = 0; i < benchPhases.size(); i++)
+    {
+      unsigned ms = benchPhases[i].second == (unsigned)-1 ? 0 : benchPhases[i].second;
+      ofs << "  \"" << benchPhases[i].first << "_ms\": " << ms << ",\n";
+      total += ms;
+    }
+  ofs << "  \"total_ms\": " << total << ",\n";
+  ofs << "  \"peak_rss_kb\": " << ProcBudget::peakResidentKBytes() << ",\n";
+  ofs << "  \"allocations\": " << numAllocations << ",\n";
+  ofs << "  \"prover_calls\": " << prog->getProofCache().getNumProverCalls() << "\n";
+  ofs << "}\n";
+}
+
+/**
+ * Saves the state of the Prog object to a snapshot file.
+ * \param prog The Prog object to save.
+ * \param fname The name of the file, or NULL for <name>.bsnap in the output directory.
+ * \return False if the file could not be written.
+ */
+bool Boomerang::saveProg(Prog *prog, const char *fname)
+{
+  std::string path = fname ? fname : prog->getRootCluster()->getOutPath("bsnap");
+  LOG << "saving persistable state to " << path.c_str() << "\n";
+  ProgSnapshot snap;
+  return snap.save(prog, path.c_str());
+}
+
+/**
+ * Loads the state of a Prog object from a snapshot file (or a XML file, if compiled with USE_XML).
+ * \param fname The name of the file.
+ * \return The loaded Prog object, or NULL if it could not be loaded.
+ */
+Prog *Boomerang::loadProg(const char *fname)
+{
+#if USE_XML
+  if (!ProgSnapshot::isSnapshot(fname))
+    return loadFromXML(fname);
+#endif
+  LOG << "loading persistable state from " << fname << "\n";
+  // The bodies of the procs are read as they are needed; the Prog owns the snapshot from then on
+  ProgSnapshot* snap = new ProgSnapshot();
+  Prog* prog = snap->load(fname, true);
+  if (prog == NULL)
+    delete snap;
+  return prog;
+}
+
 #if USE_XML
 /**
  * Saves the state of the Prog object to a XML file.
@@ -78,16 +78,11 @@ void CHLLCode::indent(std::ostringstream& str, int indLevel)
  *
  * \todo This function is 800+ lines, and should possibly be split up.
  */
-static int progress = 0;
 void CHLLCode::appendExp(std::ostringstream& str, Exp *exp, PREC curPrec, bool uns /* = false */ )
 {
   if (exp == NULL) return;				// ?
 
-  if (++progress > 500)
-    {
-      std::cerr << 'g' << std::flush;
-      progress = 0;
-    }
+  Boomerang::get()->showProgress('g', 500);
 
   OPER op = exp->getOper();
 
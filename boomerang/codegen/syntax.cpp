@@ -7,9 +7,13 @@
 #include "hllcode.h"
 #include "cfg.h"
 #include "statement.h"
+#include "boomerang.h"
 
 static int nodecount = 1000;
 
+// Show the transformations tried by the search of UserProc::getAST()
+#define DEBUG_SUCCESSOR(msg) if (DEBUG_GEN) std::cerr << "successor: " << msg << std::endl
+
 
 #define PRINT_BEFORE_AFTER std::ofstream of("before.dot"); \
 				of << "digraph before {" << std::endl; \
@@ -23,22 +27,80 @@ static int nodecount = 1000;
 				of1.close(); \
 				exit(0);
 
-SyntaxNode::SyntaxNode() : pbb(NULL), score(-1), correspond(NULL),
-    notGoto(false)
+SyntaxNode::SyntaxNode() : pbb(NULL), score(-1), value(-1), correspond(NULL),
+    notGoto(false), depth(0), index(NULL)
 {
   nodenum = nodecount++;
 }
 
 SyntaxNode::~SyntaxNode()
-{}
+{
+  delete index;
+}
 
 int SyntaxNode::getScore()
 {
   if (score == -1)
-    score = evaluate(this);
+    score = getValue();
   return score;
 }
 
+int SyntaxNode::getValue()
+{
+  if (value == -1)
+    value = evaluate(this);
+  return value;
+}
+
+// Evaluating a tree looks up the nodes for the out edges of its BBs over and over, and each lookup is a search of the
+// whole tree, so the root remembers them. Trees don't change, so the results stay right
+SyntaxNode *SyntaxNode::findNode(PBB bb)
+{
+  if (index == NULL)
+    index = new std::map<PBB, SyntaxNode*>;
+  std::map<PBB, SyntaxNode*>::iterator it = index->find(bb);
+  if (it != index->end())
+    return it->second;
+  SyntaxNode *n = findNodeFor(bb);
+  (*index)[bb] = n;
+  return n;
+}
+
+void SyntaxNode::clearIndex()
+{
+  delete index;
+  index = NULL;
+}
+
+void SyntaxNode::deleteTrees(std::vector<SyntaxNode*> &trees, SyntaxNode *keep)
+{
+  // Nodes are shared between trees, so find them all first, and delete each once
+  std::set<SyntaxNode*> kept, all;
+  std::vector<SyntaxNode*> work;
+  if (keep)
+    work.push_back(keep);
+  while (work.size())
+    {
+      SyntaxNode *n = work.back();
+      work.pop_back();
+      if (kept.insert(n).second)
+        n->getChildren(work);
+    }
+  work = trees;
+  while (work.size())
+    {
+      SyntaxNode *n = work.back();
+      work.pop_back();
+      if (kept.find(n) == kept.end() && all.insert(n).second)
+        n->getChildren(work);
+    }
+  for (std::set<SyntaxNode*>::iterator it = all.begin(); it != all.end(); it++)
+    {
+      (*it)->dropChildren();
+      delete *it;
+    }
+}
+
 bool SyntaxNode::isGoto()
 {
   return pbb && pbb->getType() == ONEWAY && !notGoto;
@@ -70,7 +132,7 @@ int BlockSyntaxNode::getNumOutEdges()
 SyntaxNode *BlockSyntaxNode::getOutEdge(SyntaxNode *root, int n)
 {
   if (pbb)
-    return root->findNodeFor(pbb->getOutEdge(n));
+    return root->findNode(pbb->getOutEdge(n));
   if (statements.size() == 0)
     return NULL;
   return statements[statements.size()-1]->getOutEdge(root, n);
@@ -140,7 +202,7 @@ void BlockSyntaxNode::printAST(SyntaxNode *root, std::ostream &os)
         {
           PBB out = pbb->getOutEdge(i);
           os << std::setw(4) << std::dec << nodenum << " ";
-          SyntaxNode *to = root->findNodeFor(out);
+          SyntaxNode *to = root->findNode(out);
           assert(to);
           os << " -> " << to->getNumber() << " [style=dotted";
           if (pbb->getNumOutEdges() > 1)
@@ -213,22 +275,26 @@ int BlockSyntaxNode::evaluate(SyntaxNode *root)
       else if (statements[i]->isBranch())
         {
           SyntaxNode *loop = root->getEnclosingLoop(this);
-          std::cerr << "branch " << statements[i]->getNumber()
-          << " not in loop" << std::endl;
           if (loop)
             {
+#if DEBUG_EVAL
               std::cerr << "branch " << statements[i]->getNumber()
               << " in loop " << loop->getNumber() << std::endl;
+#endif
               // this is a bit C specific
               SyntaxNode *out = loop->getOutEdge(root, 0);
               if (out && statements[i]->getOutEdge(root, 0) == out)
                 {
+#if DEBUG_EVAL
                   std::cerr << "found break" << std::endl;
+#endif
                   n += 10;
                 }
               if (statements[i]->getOutEdge(root, 0) == loop)
                 {
+#if DEBUG_EVAL
                   std::cerr << "found continue" << std::endl;
+#endif
                   n += 10;
                 }
             }
@@ -270,15 +336,14 @@ void BlockSyntaxNode::addSuccessors(SyntaxNode *root,
           // can move previous statements into this block
           if (i > 0)
             {
-              std::cerr << "successor: move previous statement into block"
-              << std::endl;
-              SyntaxNode *n = root->clone();
+              DEBUG_SUCCESSOR("move previous statement into block");
+              BlockSyntaxNode *nb = ((BlockSyntaxNode*)statements[i])->copy();
+              nb->prependStatement(statements[i-1]);
+              BlockSyntaxNode *b1 = copy();
+              b1->statements[i] = nb;
+              b1->statements.erase(b1->statements.begin() + i - 1);
+              SyntaxNode *n = root->substitute(this, b1);
               n->setDepth(root->getDepth() + 1);
-              BlockSyntaxNode *b1 = (BlockSyntaxNode*)this->clone();
-              BlockSyntaxNode *nb = (BlockSyntaxNode*)b1->getStatement(i);
-              b1 = (BlockSyntaxNode*)b1->replace(statements[i-1], NULL);
-              nb->prependStatement(statements[i-1]->clone());
-              n = n->replace(this, b1);
               successors.push_back(n);
               //PRINT_BEFORE_AFTER
             }
@@ -288,13 +353,11 @@ void BlockSyntaxNode::addSuccessors(SyntaxNode *root,
           if (statements.size() != 1)
             {
               // can replace statement with a block containing that statement
-              std::cerr << "successor: replace statement with a block "
-              << "containing the statement" << std::endl;
+              DEBUG_SUCCESSOR("replace statement with a block containing the statement");
               BlockSyntaxNode *b = new BlockSyntaxNode();
-              b->addStatement(statements[i]->clone());
-              SyntaxNode *n = root->clone();
+              b->addStatement(statements[i]);
+              SyntaxNode *n = root->substitute(statements[i], b);
               n->setDepth(root->getDepth() + 1);
-              n = n->replace(statements[i], b);
               successors.push_back(n);
               //PRINT_BEFORE_AFTER
             }
@@ -307,22 +370,19 @@ void BlockSyntaxNode::addSuccessors(SyntaxNode *root,
               (statements[i+1]->getOutEdge(root, 0) == statements[i+2] ||
                statements[i+1]->endsWithGoto()))
             {
-              std::cerr << "successor: jump over style if then"
-              << std::endl;
-              BlockSyntaxNode *b1 =
-                (BlockSyntaxNode*)this->clone();
-              b1 = (BlockSyntaxNode*)b1->replace(statements[i+1], NULL);
+              DEBUG_SUCCESSOR("jump over style if then");
               IfThenSyntaxNode *nif = new IfThenSyntaxNode();
               Exp *cond = b->getBB()->getCond();
               cond = new Unary(opLNot, cond->clone());
               cond = cond->simplify();
               nif->setCond(cond);
-              nif->setThen(statements[i+1]->clone());
+              nif->setThen(statements[i+1]);
               nif->setBB(b->getBB());
-              b1->setStatement(i, nif);
-              SyntaxNode *n = root->clone();
+              BlockSyntaxNode *b1 = copy();
+              b1->statements[i] = nif;
+              b1->statements.erase(b1->statements.begin() + i + 1);
+              SyntaxNode *n = root->substitute(this, b1);
               n->setDepth(root->getDepth() + 1);
-              n = n->replace(this, b1);
               successors.push_back(n);
               //PRINT_BEFORE_AFTER
             }
@@ -343,17 +403,16 @@ void BlockSyntaxNode::addSuccessors(SyntaxNode *root,
 
               if (else_out == then_out)
                 {
-                  std::cerr << "successor: if then else" << std::endl;
-                  SyntaxNode *n = root->clone();
-                  n->setDepth(root->getDepth() + 1);
-                  n = n->replace(tThen, NULL);
-                  n = n->replace(tElse, NULL);
+                  DEBUG_SUCCESSOR("if then else");
                   IfThenElseSyntaxNode *nif = new IfThenElseSyntaxNode();
                   nif->setCond(statements[i]->getBB()->getCond()->clone());
                   nif->setBB(statements[i]->getBB());
-                  nif->setThen(tThen->clone());
-                  nif->setElse(tElse->clone());
-                  n = n->replace(statements[i], nif);
+                  nif->setThen(tThen);
+                  nif->setElse(tElse);
+                  SyntaxNode *n = root->substitute(tThen, NULL);
+                  n = n->substitute(tElse, NULL);
+                  n = n->substitute(statements[i], nif);
+                  n->setDepth(root->getDepth() + 1);
                   successors.push_back(n);
                   //PRINT_BEFORE_AFTER
                 }
@@ -371,15 +430,14 @@ void BlockSyntaxNode::addSuccessors(SyntaxNode *root,
               tBody->getNumOutEdges() == 1 &&
               tBody->getOutEdge(root, 0) == statements[i])
             {
-              std::cerr << "successor: pretested loop" << std::endl;
-              SyntaxNode *n = root->clone();
-              n->setDepth(root->getDepth() + 1);
-              n = n->replace(tBody, NULL);
+              DEBUG_SUCCESSOR("pretested loop");
               PretestedLoopSyntaxNode *nloop = new PretestedLoopSyntaxNode();
               nloop->setCond(statements[i]->getBB()->getCond()->clone());
               nloop->setBB(statements[i]->getBB());
-              nloop->setBody(tBody->clone());
-              n = n->replace(statements[i], nloop);
+              nloop->setBody(tBody);
+              SyntaxNode *n = root->substitute(tBody, NULL);
+              n = n->substitute(statements[i], nloop);
+              n->setDepth(root->getDepth() + 1);
               successors.push_back(n);
               //PRINT_BEFORE_AFTER
             }
@@ -396,16 +454,15 @@ void BlockSyntaxNode::addSuccessors(SyntaxNode *root,
               tBody->getNumOutEdges() == 1 &&
               tBody->getOutEdge(root, 0) == statements[i])
             {
-              std::cerr << "successor: posttested loop" << std::endl;
-              SyntaxNode *n = root->clone();
-              n->setDepth(root->getDepth() + 1);
-              n = n->replace(tBody, NULL);
+              DEBUG_SUCCESSOR("posttested loop");
               PostTestedLoopSyntaxNode *nloop =
                 new PostTestedLoopSyntaxNode();
               nloop->setCond(statements[i]->getBB()->getCond()->clone());
               nloop->setBB(statements[i]->getBB());
-              nloop->setBody(tBody->clone());
-              n = n->replace(statements[i], nloop);
+              nloop->setBody(tBody);
+              SyntaxNode *n = root->substitute(tBody, NULL);
+              n = n->substitute(statements[i], nloop);
+              n->setDepth(root->getDepth() + 1);
               successors.push_back(n);
               //PRINT_BEFORE_AFTER
             }
@@ -415,14 +472,13 @@ void BlockSyntaxNode::addSuccessors(SyntaxNode *root,
       if (statements[i]->getNumOutEdges() == 1 &&
           statements[i]->getOutEdge(root, 0) == statements[i])
         {
-          std::cerr << "successor: infinite loop" << std::endl;
-          SyntaxNode *n = root->clone();
-          n->setDepth(root->getDepth() + 1);
+          DEBUG_SUCCESSOR("infinite loop");
           InfiniteLoopSyntaxNode *nloop = new InfiniteLoopSyntaxNode();
-          nloop->setBody(statements[i]->clone());
-          n = n->replace(statements[i], nloop);
+          nloop->setBody(statements[i]);
+          SyntaxNode *n = root->substitute(statements[i], nloop);
+          n->setDepth(root->getDepth() + 1);
           successors.push_back(n);
-          PRINT_BEFORE_AFTER
+          //PRINT_BEFORE_AFTER
         }
 
       statements[i]->addSuccessors(root, successors);
@@ -441,29 +497,48 @@ SyntaxNode *BlockSyntaxNode::clone()
   return b;
 }
 
-SyntaxNode *BlockSyntaxNode::replace(SyntaxNode *from, SyntaxNode *to)
+BlockSyntaxNode *BlockSyntaxNode::copy()
+{
+  BlockSyntaxNode *b = new BlockSyntaxNode();
+  b->correspond = this;
+  b->pbb = pbb;
+  b->notGoto = notGoto;
+  b->statements = statements;
+  return b;
+}
+
+SyntaxNode *BlockSyntaxNode::substitute(SyntaxNode *from, SyntaxNode *to)
 {
-  if (correspond == from)
+  if (this == from)
     return to;
+  if (pbb)
+    return this;
 
-  if (pbb == NULL)
+  std::vector<SyntaxNode*> news;
+  bool changed = false;
+  for (unsigned i = 0; i < statements.size(); i++)
     {
-      std::vector<SyntaxNode*> news;
-      for (unsigned i = 0; i < statements.size(); i++)
-        {
-          SyntaxNode *n = statements[i];
-          if (statements[i]->getCorrespond() == from)
-            n = to;
-          else
-            n = statements[i]->replace(from, to);
-          if (n)
-            news.push_back(n);
-        }
-      statements.resize(news.size());
-      for (unsigned i = 0; i < news.size(); i++)
-        statements[i] = news[i];
+      SyntaxNode *n = statements[i]->substitute(from, to);
+      if (n != statements[i])
+        changed = true;
+      if (n)
+        news.push_back(n);
     }
-  return this;
+  if (!changed)
+    return this;
+  BlockSyntaxNode *b = copy();
+  b->statements = news;
+  return b;
+}
+
+void BlockSyntaxNode::getChildren(std::vector<SyntaxNode*> &children)
+{
+  children.insert(children.end(), statements.begin(), statements.end());
+}
+
+void BlockSyntaxNode::dropChildren()
+{
+  statements.clear();
 }
 
 IfThenSyntaxNode::IfThenSyntaxNode() : pThen(NULL), cond(NULL)
@@ -478,7 +553,7 @@ IfThenSyntaxNode::~IfThenSyntaxNode()
 
 SyntaxNode *IfThenSyntaxNode::getOutEdge(SyntaxNode *root, int n)
 {
-  SyntaxNode *n1 = root->findNodeFor(pbb->getOutEdge(0));
+  SyntaxNode *n1 = root->findNode(pbb->getOutEdge(0));
   assert(n1 != pThen);
   return n1;
 }
@@ -506,17 +581,30 @@ SyntaxNode *IfThenSyntaxNode::clone()
   return b;
 }
 
-SyntaxNode *IfThenSyntaxNode::replace(SyntaxNode *from, SyntaxNode *to)
+SyntaxNode *IfThenSyntaxNode::substitute(SyntaxNode *from, SyntaxNode *to)
 {
-  assert(correspond != from);
-  if (pThen->getCorrespond() == from)
-    {
-      assert(to);
-      pThen = to;
-    }
-  else
-    pThen = pThen->replace(from, to);
-  return this;
+  if (this == from)
+    return to;
+  SyntaxNode *nThen = pThen->substitute(from, to);
+  if (nThen == pThen)
+    return this;
+  assert(nThen);
+  IfThenSyntaxNode *b = new IfThenSyntaxNode();
+  b->correspond = this;
+  b->pbb = pbb;
+  b->cond = cond->clone();
+  b->pThen = nThen;
+  return b;
+}
+
+void IfThenSyntaxNode::getChildren(std::vector<SyntaxNode*> &children)
+{
+  children.push_back(pThen);
+}
+
+void IfThenSyntaxNode::dropChildren()
+{
+  pThen = NULL;
 }
 
 SyntaxNode *IfThenSyntaxNode::findNodeFor(PBB bb)
@@ -533,7 +621,7 @@ void IfThenSyntaxNode::printAST(SyntaxNode *root, std::ostream &os)
   pThen->printAST(root, os);
   os << std::setw(4) << std::dec << nodenum << " ";
   os << " -> " << pThen->getNumber() << " [label=then];" << std::endl;
-  SyntaxNode *follows = root->findNodeFor(pbb->getOutEdge(0));
+  SyntaxNode *follows = root->findNode(pbb->getOutEdge(0));
   os << std::setw(4) << std::dec << nodenum << " ";
   os << " -> " << follows->getNumber() << " [style=dotted];" << std::endl;
 }
@@ -566,25 +654,21 @@ void IfThenElseSyntaxNode::addSuccessors(SyntaxNode *root,
   // follow
   if (pThen->getNumOutEdges() == 1 && pThen->endsWithGoto())
     {
-      std::cerr << "successor: ignoring goto at end of then of if then else"
-      << std::endl;
-      SyntaxNode *n = root->clone();
-      n->setDepth(root->getDepth() + 1);
+      DEBUG_SUCCESSOR("ignoring goto at end of then of if then else");
       SyntaxNode *nThen = pThen->clone();
       nThen->ignoreGoto();
-      n = n->replace(pThen, nThen);
+      SyntaxNode *n = root->substitute(pThen, nThen);
+      n->setDepth(root->getDepth() + 1);
       successors.push_back(n);
     }
 
   if (pElse->getNumOutEdges() == 1 && pElse->endsWithGoto())
     {
-      std::cerr << "successor: ignoring goto at end of else of if then else"
-      << std::endl;
-      SyntaxNode *n = root->clone();
-      n->setDepth(root->getDepth() + 1);
+      DEBUG_SUCCESSOR("ignoring goto at end of else of if then else");
       SyntaxNode *nElse = pElse->clone();
       nElse->ignoreGoto();
-      n = n->replace(pElse, nElse);
+      SyntaxNode *n = root->substitute(pElse, nElse);
+      n->setDepth(root->getDepth() + 1);
       successors.push_back(n);
     }
 
@@ -603,24 +687,33 @@ SyntaxNode *IfThenElseSyntaxNode::clone()
   return b;
 }
 
-SyntaxNode *IfThenElseSyntaxNode::replace(SyntaxNode *from, SyntaxNode *to)
+SyntaxNode *IfThenElseSyntaxNode::substitute(SyntaxNode *from, SyntaxNode *to)
 {
-  assert(correspond != from);
-  if (pThen->getCorrespond() == from)
-    {
-      assert(to);
-      pThen = to;
-    }
-  else
-    pThen = pThen->replace(from, to);
-  if (pElse->getCorrespond() == from)
-    {
-      assert(to);
-      pElse = to;
-    }
-  else
-    pElse = pElse->replace(from, to);
-  return this;
+  if (this == from)
+    return to;
+  SyntaxNode *nThen = pThen->substitute(from, to);
+  SyntaxNode *nElse = pElse->substitute(from, to);
+  if (nThen == pThen && nElse == pElse)
+    return this;
+  assert(nThen && nElse);
+  IfThenElseSyntaxNode *b = new IfThenElseSyntaxNode();
+  b->correspond = this;
+  b->pbb = pbb;
+  b->cond = cond->clone();
+  b->pThen = nThen;
+  b->pElse = nElse;
+  return b;
+}
+
+void IfThenElseSyntaxNode::getChildren(std::vector<SyntaxNode*> &children)
+{
+  children.push_back(pThen);
+  children.push_back(pElse);
+}
+
+void IfThenElseSyntaxNode::dropChildren()
+{
+  pThen = pElse = NULL;
 }
 
 SyntaxNode *IfThenElseSyntaxNode::findNodeFor(PBB bb)
@@ -659,7 +752,7 @@ PretestedLoopSyntaxNode::~PretestedLoopSyntaxNode()
 
 SyntaxNode *PretestedLoopSyntaxNode::getOutEdge(SyntaxNode *root, int n)
 {
-  return root->findNodeFor(pbb->getOutEdge(1));
+  return root->findNode(pbb->getOutEdge(1));
 }
 
 int PretestedLoopSyntaxNode::evaluate(SyntaxNode *root)
@@ -675,15 +768,13 @@ void PretestedLoopSyntaxNode::addSuccessors(SyntaxNode *root,
   // we can always ignore gotos at the end of the body.
   if (pBody->getNumOutEdges() == 1 && pBody->endsWithGoto())
     {
-      std::cerr << "successor: ignoring goto at end of body of pretested "
-      << "loop" << std::endl;
+      DEBUG_SUCCESSOR("ignoring goto at end of body of pretested loop");
       SyntaxNode *out = pBody->getOutEdge(root, 0);
       assert(out->startsWith(this));
-      SyntaxNode *n = root->clone();
-      n->setDepth(root->getDepth() + 1);
       SyntaxNode *nBody = pBody->clone();
       nBody->ignoreGoto();
-      n = n->replace(pBody, nBody);
+      SyntaxNode *n = root->substitute(pBody, nBody);
+      n->setDepth(root->getDepth() + 1);
       successors.push_back(n);
     }
 
@@ -700,17 +791,30 @@ SyntaxNode *PretestedLoopSyntaxNode::clone()
   return b;
 }
 
-SyntaxNode *PretestedLoopSyntaxNode::replace(SyntaxNode *from, SyntaxNode *to)
+SyntaxNode *PretestedLoopSyntaxNode::substitute(SyntaxNode *from, SyntaxNode *to)
 {
-  assert(correspond != from);
-  if (pBody->getCorrespond() == from)
-    {
-      assert(to);
-      pBody = to;
-    }
-  else
-    pBody = pBody->replace(from, to);
-  return this;
+  if (this == from)
+    return to;
+  SyntaxNode *nBody = pBody->substitute(from, to);
+  if (nBody == pBody)
+    return this;
+  assert(nBody);
+  PretestedLoopSyntaxNode *b = new PretestedLoopSyntaxNode();
+  b->correspond = this;
+  b->pbb = pbb;
+  b->cond = cond->clone();
+  b->pBody = nBody;
+  return b;
+}
+
+void PretestedLoopSyntaxNode::getChildren(std::vector<SyntaxNode*> &children)
+{
+  children.push_back(pBody);
+}
+
+void PretestedLoopSyntaxNode::dropChildren()
+{
+  pBody = NULL;
 }
 
 SyntaxNode *PretestedLoopSyntaxNode::findNodeFor(PBB bb)
@@ -746,7 +850,7 @@ PostTestedLoopSyntaxNode::~PostTestedLoopSyntaxNode()
 
 SyntaxNode *PostTestedLoopSyntaxNode::getOutEdge(SyntaxNode *root, int n)
 {
-  return root->findNodeFor(pbb->getOutEdge(1));
+  return root->findNode(pbb->getOutEdge(1));
 }
 
 int PostTestedLoopSyntaxNode::evaluate(SyntaxNode *root)
@@ -762,14 +866,12 @@ void PostTestedLoopSyntaxNode::addSuccessors(SyntaxNode *root,
   // we can always ignore gotos at the end of the body.
   if (pBody->getNumOutEdges() == 1 && pBody->endsWithGoto())
     {
-      std::cerr << "successor: ignoring goto at end of body of posttested "
-      << "loop" << std::endl;
+      DEBUG_SUCCESSOR("ignoring goto at end of body of posttested loop");
       assert(pBody->getOutEdge(root, 0) == this);
-      SyntaxNode *n = root->clone();
-      n->setDepth(root->getDepth() + 1);
       SyntaxNode *nBody = pBody->clone();
       nBody->ignoreGoto();
-      n = n->replace(pBody, nBody);
+      SyntaxNode *n = root->substitute(pBody, nBody);
+      n->setDepth(root->getDepth() + 1);
       successors.push_back(n);
     }
 
@@ -786,17 +888,30 @@ SyntaxNode *PostTestedLoopSyntaxNode::clone()
   return b;
 }
 
-SyntaxNode *PostTestedLoopSyntaxNode::replace(SyntaxNode *from, SyntaxNode *to)
+SyntaxNode *PostTestedLoopSyntaxNode::substitute(SyntaxNode *from, SyntaxNode *to)
 {
-  assert(correspond != from);
-  if (pBody->getCorrespond() == from)
-    {
-      assert(to);
-      pBody = to;
-    }
-  else
-    pBody = pBody->replace(from, to);
-  return this;
+  if (this == from)
+    return to;
+  SyntaxNode *nBody = pBody->substitute(from, to);
+  if (nBody == pBody)
+    return this;
+  assert(nBody);
+  PostTestedLoopSyntaxNode *b = new PostTestedLoopSyntaxNode();
+  b->correspond = this;
+  b->pbb = pbb;
+  b->cond = cond->clone();
+  b->pBody = nBody;
+  return b;
+}
+
+void PostTestedLoopSyntaxNode::getChildren(std::vector<SyntaxNode*> &children)
+{
+  children.push_back(pBody);
+}
+
+void PostTestedLoopSyntaxNode::dropChildren()
+{
+  pBody = NULL;
 }
 
 SyntaxNode *PostTestedLoopSyntaxNode::findNodeFor(PBB bb)
@@ -844,14 +959,12 @@ void InfiniteLoopSyntaxNode::addSuccessors(SyntaxNode *root,
   // we can always ignore gotos at the end of the body.
   if (pBody->getNumOutEdges() == 1 && pBody->endsWithGoto())
     {
-      std::cerr << "successor: ignoring goto at end of body of infinite "
-      << "loop" << std::endl;
+      DEBUG_SUCCESSOR("ignoring goto at end of body of infinite loop");
       assert(pBody->getOutEdge(root, 0) == this);
-      SyntaxNode *n = root->clone();
-      n->setDepth(root->getDepth() + 1);
       SyntaxNode *nBody = pBody->clone();
       nBody->ignoreGoto();
-      n = n->replace(pBody, nBody);
+      SyntaxNode *n = root->substitute(pBody, nBody);
+      n->setDepth(root->getDepth() + 1);
       successors.push_back(n);
     }
 
@@ -867,17 +980,29 @@ SyntaxNode *InfiniteLoopSyntaxNode::clone()
   return b;
 }
 
-SyntaxNode *InfiniteLoopSyntaxNode::replace(SyntaxNode *from, SyntaxNode *to)
+SyntaxNode *InfiniteLoopSyntaxNode::substitute(SyntaxNode *from, SyntaxNode *to)
 {
-  assert(correspond != from);
-  if (pBody->getCorrespond() == from)
-    {
-      assert(to);
-      pBody = to;
-    }
-  else
-    pBody = pBody->replace(from, to);
-  return this;
+  if (this == from)
+    return to;
+  SyntaxNode *nBody = pBody->substitute(from, to);
+  if (nBody == pBody)
+    return this;
+  assert(nBody);
+  InfiniteLoopSyntaxNode *b = new InfiniteLoopSyntaxNode();
+  b->correspond = this;
+  b->pbb = pbb;
+  b->pBody = nBody;
+  return b;
+}
+
+void InfiniteLoopSyntaxNode::getChildren(std::vector<SyntaxNode*> &children)
+{
+  children.push_back(pBody);
+}
+
+void InfiniteLoopSyntaxNode::dropChildren()
+{
+  pBody = NULL;
 }
 
 SyntaxNode *InfiniteLoopSyntaxNode::findNodeFor(PBB bb)
@@ -13,6 +13,12 @@
 #include "ProgTest.h"
 #include "pentiumfrontend.h"
 #include "BinaryFile.h"
+#include "proc.h"
+#include "cfg.h"
+#include "rtl.h"
+#include "statement.h"
+#include "signature.h"
+#include "progsnapshot.h"
 
 CPPUNIT_TEST_SUITE_REGISTRATION( ProgTest );
 
@@ -62,5 +68,57 @@ void ProgTest::testName ()
   delete pFE;
 }
 
+/*==============================================================================
+ * FUNCTION:		ProgTest::testSnapshot
+ * OVERVIEW:		Test saving a Prog to a snapshot and loading it again. A type
+ *					shared by two locals must come back shared, and a type that
+ *					refers to itself must come back referring to itself
+ *============================================================================*/
+#define SNAPSHOT_FILE		"ProgTest.snap"
+void ProgTest::testSnapshot ()
+{
+  Prog* prog = new Prog();
+  prog->setName("snapshot prog");
+  UserProc* proc = (UserProc*)prog->newProc("foo", 0x1000);
+  proc->setSignature(Signature::instantiate(PLAT_PENTIUM, CONV_C, "foo"));
+  std::list<RTL*>* rtls = new std::list<RTL*>;
+  RTL* rtl = new RTL(0x1000);
+  rtl->appendStmt(new Assign(Location::regOf(24), new Const(5)));
+  rtls->push_back(rtl);
+  proc->getCFG()->newBB(rtls, RET, 0);
+  proc->setEntryBB();
+  Type* shared = new IntegerType(16, 1);
+  proc->addLocal(shared, "local0", Location::memOf(new Binary(opMinus, Location::regOf(28), new Const(4))));
+  proc->addLocal(shared, "local1", Location::memOf(new Binary(opMinus, Location::regOf(28), new Const(8))));
+  CompoundType* node = new CompoundType();
+  node->addType(new IntegerType(32), "val");
+  node->addType(new PointerType(node), "next");
+  proc->addLocal(node, "local2", Location::memOf(new Binary(opMinus, Location::regOf(28), new Const(16))));
+  proc->setDecoded();
+  CPPUNIT_ASSERT(ProgSnapshot().save(prog, SNAPSHOT_FILE));
+
+  Prog* loaded = (new ProgSnapshot)->load(SNAPSHOT_FILE);
+  CPPUNIT_ASSERT(loaded != NULL);
+  UserProc* up = (UserProc*)loaded->findProc("foo");
+  CPPUNIT_ASSERT(up != NULL);
+  CPPUNIT_ASSERT_EQUAL((ADDRESS)0x1000, up->getNativeAddress());
+  StatementList stmts;
+  up->getStatements(stmts);
+  CPPUNIT_ASSERT_EQUAL(1, (int)stmts.size());
+  Type* t0 = up->getLocalType("local0");
+  CPPUNIT_ASSERT(t0 != NULL);
+  CPPUNIT_ASSERT(*t0 == *shared);
+  CPPUNIT_ASSERT(t0 == up->getLocalType("local1"));
+  Type* t2 = up->getLocalType("local2");
+  CPPUNIT_ASSERT(t2 != NULL && t2->isCompound());
+  CompoundType* c = t2->asCompound();
+  CPPUNIT_ASSERT_EQUAL(2, (int)c->getNumTypes());
+  Type* next = c->getType("next");
+  CPPUNIT_ASSERT(next != NULL && next->isPointer());
+  CPPUNIT_ASSERT(next->asPointer()->getPointsTo() == c);
+  CPPUNIT_ASSERT_EQUAL(64, (int)c->getSize());
+  remove(SNAPSHOT_FILE);
+}
+
 // Pathetic: the second test we had (for readLibraryParams) is now obsolete;
 // the front end does this now.
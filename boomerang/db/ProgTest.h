@@ -6,6 +6,7 @@ class ProgTest : public CPPUNIT_NS::TestFixture
   {
     CPPUNIT_TEST_SUITE( ProgTest );
     CPPUNIT_TEST( testName );
+    CPPUNIT_TEST( testSnapshot );
     CPPUNIT_TEST_SUITE_END();
 
   protected:
@@ -17,5 +18,6 @@ class ProgTest : public CPPUNIT_NS::TestFixture
 
   protected:
     void testName ();
+    void testSnapshot ();
   };
 
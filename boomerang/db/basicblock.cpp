@@ -30,6 +30,9 @@
  *============================================================================*/
 
 #include <cassert>
+#include <algorithm>
+#include <map>
+#include <vector>
 #if defined(_MSC_VER) && _MSC_VER <= 1200
 #pragma warning(disable:4786)
 #endif
@@ -1470,8 +1473,7 @@ void BasicBlock::generateCode(HLLCode *hll, int indLevel, PBB latch,
               // FIXME: Not valid for all switch types
               Const caseVal(0);
               if (psi->chForm == 'F')							// "Fortran" style?
-                caseVal.setInt(((int*)psi->uTable)[i]);		// Yes, use the table value itself
-              // Note that uTable has the address of an int array
+                caseVal.setInt(psi->pValues[i]);				// Yes, use the table value itself
               else
                 caseVal.setInt((int)(psi->iLower+i));
               hll->AddCaseCondOption(indLevel, &caseVal);
@@ -2100,6 +2102,81 @@ static Exp* hlVfc[] =
   vfc_funcptr, vfc_both, vfc_vto, vfc_vfo, vfc_none
 };
 
+// A compiled form of a table of patterns such as hlForms. The patterns are indexed by their skeleton, i.e. the
+// operators of the root and of its first subexpression, ignoring subscripts (as operator*= does) and treating opWild
+// as "any operator". Only patterns whose skeleton is compatible with that of the expression are tried with *=, in
+// table order, so the result is the same as that of trying every pattern in turn, but most patterns are never tried.
+class PatternMatcher
+{
+  typedef std::pair<OPER, OPER> Skeleton;
+  std::map<Skeleton, std::vector<int> > index;
+  Exp**		patterns;
+
+  // The operator that the root of e must have to match; wildcards such as opWildMemOf become the operator they
+  // stand for
+  static OPER key(Exp* e)
+  {
+    if (e->isSubscript())
+      e = ((RefExp*)e)->getSubExp1();
+    switch (e->getOper())
+      {
+      case opWildIntConst:
+        return opIntConst;
+      case opWildStrConst:
+        return opStrConst;
+      case opWildMemOf:
+        return opMemOf;
+      case opWildRegOf:
+        return opRegOf;
+      case opWildAddrOf:
+        return opAddrOf;
+      default:
+        return e->getOper();
+      }
+  }
+  static Skeleton skeleton(Exp* e)
+  {
+    if (e->isSubscript())
+      e = ((RefExp*)e)->getSubExp1();
+    OPER root = key(e);
+    if (root == opWild || e->getArity() == 0)
+      return Skeleton(root, opWild);
+    return Skeleton(root, key(((Unary*)e)->getSubExp1()));
+  }
+  void		addCandidates(const Skeleton& sk, std::vector<int>& cands)
+  {
+    std::map<Skeleton, std::vector<int> >::iterator ii = index.find(sk);
+    if (ii != index.end())
+      cands.insert(cands.end(), ii->second.begin(), ii->second.end());
+  }
+
+public:
+  PatternMatcher(Exp** pats, int n) : patterns(pats)
+  {
+    for (int i=0; i < n; i++)
+      index[skeleton(pats[i])].push_back(i);
+  }
+  // Return the index of the first pattern that e matches, or -1 if none
+  int		match(Exp* e)
+  {
+    Skeleton sk = skeleton(e);
+    std::vector<int> cands;
+    addCandidates(sk, cands);
+    if (sk.second != opWild)
+      addCandidates(Skeleton(sk.first, opWild), cands);
+    if (sk.first != opWild)
+      addCandidates(Skeleton(opWild, opWild), cands);
+    std::sort(cands.begin(), cands.end());
+    for (std::vector<int>::iterator it = cands.begin(); it != cands.end(); ++it)
+      if (*e *= *patterns[*it])
+        return *it;
+    return -1;
+  }
+};
+
+static PatternMatcher hlFormMatcher(hlForms, sizeof(hlForms) / sizeof(Exp*));
+static PatternMatcher hlVfcMatcher(hlVfc, sizeof(hlVfc) / sizeof(Exp*));
+
 void findSwParams(char form, Exp* e, Exp*& expr, ADDRESS& T)
 {
   switch (form)
@@ -2299,26 +2376,24 @@ bool BasicBlock::decodeIndirectJmp(UserProc* proc)
       // We used to use ordinary propagation here to get the memory expression, but now it refuses to propagate memofs
       // because of the alias safety issue. Eventually, we should use an alias-safe incremental propagation, but for
       // now we'll assume no alias problems and force the propagation
+      // Note: propagateTo() repeats until nothing more propagates, so there is nothing left to propagate if no form
+      // matches below; the only fallback then is the Fortran style goto
       bool convert;
       lastStmt->propagateTo(convert, NULL, NULL, true /* force */);
       Exp* e = lastStmt->getDest();
-      int n = sizeof(hlForms) / sizeof(Exp*);
       char form = 0;
-      for (int i=0; i < n; i++)
+      int i = hlFormMatcher.match(e);		// Note: ignores subscripts
+      if (i != -1)
         {
-          if (*e *= *hlForms[i])
-            {
-              // *= compare ignores subscripts
-              form = chForms[i];
-              if (DEBUG_SWITCH)
-                LOG << "indirect jump matches form " << form << "\n";
-              break;
-            }
+          form = chForms[i];
+          if (DEBUG_SWITCH)
+            LOG << "indirect jump matches form " << form << "\n";
         }
       if (form)
         {
           SWITCH_INFO* swi = new SWITCH_INFO;
           swi->chForm = form;
+          swi->pValues = NULL;
           ADDRESS T;
           Exp* expr;
           findSwParams(form, e, expr, T);
@@ -2387,7 +2462,8 @@ bool BasicBlock::decodeIndirectJmp(UserProc* proc)
                       SWITCH_INFO* swi = new SWITCH_INFO;
                       swi->chForm = 'F';					// The "Fortran" form
                       swi->pSwitchVar = e;
-                      swi->uTable = (ADDRESS)destArray;	// Abuse the uTable member as a pointer
+                      swi->uTable = 0;					// No table in the program
+                      swi->pValues = destArray;
                       swi->iNumTable = n;
                       swi->iLower = 1;					// Not used, except to compute
                       swi->iUpper = n;					// the number of options
@@ -2424,21 +2500,10 @@ bool BasicBlock::decodeIndirectJmp(UserProc* proc)
       if (DEBUG_SWITCH)
         LOG << "decodeIndirect: propagated and const global converted call expression is " << e << "\n";
 
-      int n = sizeof(hlVfc) / sizeof(Exp*);
-      bool recognised = false;
-      int i;
-      for (i=0; i < n; i++)
-        {
-          if (*e *= *hlVfc[i])
-            {
-              // *= compare ignores subscripts
-              recognised = true;
-              if (DEBUG_SWITCH)
-                LOG << "indirect call matches form " << i << "\n";
-              break;
-            }
-        }
-      if (!recognised) return false;
+      int i = hlVfcMatcher.match(e);		// Note: ignores subscripts
+      if (i == -1) return false;
+      if (DEBUG_SWITCH)
+        LOG << "indirect call matches form " << i << "\n";
       lastStmt->setDest(e);				// Keep the changes to the indirect call expression
       int K1, K2;
       Exp *vtExp, *t1;
@@ -2626,7 +2691,7 @@ void BasicBlock::processSwitch(UserProc* proc)
           uSwitch =prog->readNative4(si->uTable + i*8 + 4);
         }
       else if (si->chForm == 'F')
-        uSwitch = ((int*)si->uTable)[i];
+        uSwitch = si->pValues[i];
       else
         uSwitch = prog->readNative4(si->uTable + i*4);
       if ((si->chForm == 'O') || (si->chForm == 'R') || (si->chForm == 'r'))
@@ -0,0 +1,165 @@
+/*
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+/*==============================================================================
+ * FILE:	   budget.cpp
+ * OVERVIEW:   Implementation of the ProcBudget class, which accounts the resources used while decompiling one
+ *				UserProc against the limits given with the -bt, -bp, -bs and -bm switches.
+ *============================================================================*/
+
+#include <sstream>
+#include <ctime>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/time.h>
+#include <sys/resource.h>		// For getrusage
+#endif
+
+#include "budget.h"
+#include "boomerang.h"
+
+ProcBudget::ProcBudget() : exceeded(false), curPhase(PHASE_NONE), exceededPhase(PHASE_NONE), phaseStartMs(0),
+  phaseStartBytes(0), stmts(0)
+{
+  for (int i=0; i < NUM_BUDGET_PHASES; i++)
+    {
+      phaseMs[i] = 0;
+      phaseBytes[i] = 0;
+    }
+}
+
+unsigned ProcBudget::wallMillis()
+{
+#if defined(_WIN32)
+  return GetTickCount();
+#else
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (unsigned)(tv.tv_sec * 1000 + tv.tv_usec / 1000);
+#endif
+}
+
+unsigned long ProcBudget::bytesAllocated()
+{
+  return Boomerang::numAllocatedBytes;		// Stays 0 if not counted; the memory budget is then never exceeded
+}
+
+long ProcBudget::peakResidentKBytes()
+{
+#if defined(_WIN32)
+  return 0;
+#else
+  struct rusage ru;
+  if (getrusage(RUSAGE_SELF, &ru) != 0)
+    return 0;
+#if defined(__APPLE__)
+  return (long)(ru.ru_maxrss / 1024);		// In bytes on OS X
+#else
+  return (long)ru.ru_maxrss;
+#endif
+#endif
+}
+
+const char* ProcBudget::getPhaseName(BudgetPhase ph)
+{
+  switch (ph)
+    {
+    case PHASE_EARLY:
+      return "early";
+    case PHASE_MIDDLE:
+      return "middle";
+    case PHASE_FINAL:
+      return "final";
+    case PHASE_GLOBAL:
+      return "global";
+    default:
+      return "none";
+    }
+}
+
+bool ProcBudget::isLimited()
+{
+  Boomerang* boom = Boomerang::get();
+  return boom->procTimeBudget || boom->phaseTimeBudget || boom->procStmtBudget || boom->procMemBudget;
+}
+
+BudgetPhase ProcBudget::enterPhase(BudgetPhase ph)
+{
+  BudgetPhase prev = curPhase;
+  leavePhase();
+  curPhase = ph;
+  phaseStartMs = wallMillis();
+  phaseStartBytes = bytesAllocated();
+  return prev;
+}
+
+void ProcBudget::leavePhase()
+{
+  if (curPhase == PHASE_NONE)
+    return;
+  phaseMs[curPhase] += wallMillis() - phaseStartMs;
+  phaseBytes[curPhase] += bytesAllocated() - phaseStartBytes;
+  curPhase = PHASE_NONE;
+}
+
+// Totals include the part of the current phase consumed so far
+unsigned ProcBudget::getTotalMs()
+{
+  unsigned ms = 0;
+  for (int i=0; i < NUM_BUDGET_PHASES; i++)
+    ms += phaseMs[i];
+  if (curPhase != PHASE_NONE)
+    ms += wallMillis() - phaseStartMs;
+  return ms;
+}
+
+unsigned long ProcBudget::getTotalBytes()
+{
+  unsigned long bytes = 0;
+  for (int i=0; i < NUM_BUDGET_PHASES; i++)
+    bytes += phaseBytes[i];
+  if (curPhase != PHASE_NONE)
+    bytes += bytesAllocated() - phaseStartBytes;
+  return bytes;
+}
+
+bool ProcBudget::isExceeded()
+{
+  if (exceeded)
+    return true;
+  Boomerang* boom = Boomerang::get();
+  std::ostringstream ost;
+  if (boom->procTimeBudget && getTotalMs() > (unsigned)boom->procTimeBudget * 1000)
+    ost << "wall time exceeded " << boom->procTimeBudget << " s";
+  else if (boom->phaseTimeBudget && curPhase != PHASE_NONE &&
+           phaseMs[curPhase] + (wallMillis() - phaseStartMs) > (unsigned)boom->phaseTimeBudget * 1000)
+    ost << "wall time of " << getPhaseName(curPhase) << " phase exceeded " << boom->phaseTimeBudget << " s";
+  else if (boom->procStmtBudget && stmts > boom->procStmtBudget)
+    ost << "processed more than " << boom->procStmtBudget << " statements";
+  else if (boom->procMemBudget && getTotalBytes() > (unsigned long)boom->procMemBudget * 1024)
+    ost << "allocated more than " << boom->procMemBudget << " KB";
+  else
+    return false;
+  exceeded = true;
+  exceededPhase = curPhase;
+  reason = ost.str();
+  return true;
+}
+
+void ProcBudget::print(std::ostream& os)
+{
+  os << getTotalMs() << " ms, " << stmts << " statements, " << getTotalBytes() / 1024 << " KB (";
+  for (int i=0; i < NUM_BUDGET_PHASES; i++)
+    {
+      if (i) os << ", ";
+      os << getPhaseName((BudgetPhase)i) << " " << phaseMs[i] << " ms";
+    }
+  os << ")";
+  if (exceeded)
+    os << "; " << reason << " in " << getPhaseName(exceededPhase) << " phase";
+}
@@ -109,6 +109,7 @@ void Cfg::clear()
   // for (std::list<PBB>::iterator it = m_listBB.begin(); it != m_listBB.end(); it++)
   //	delete *it;
   m_listBB.clear();
+  m_indirectBBs.clear();
   m_mapBB.clear();
   implicitMap.clear();
   entryBB = NULL;
@@ -127,6 +128,7 @@ void Cfg::clear()
 const Cfg& Cfg::operator=(const Cfg& other)
 {
   m_listBB = other.m_listBB;
+  m_indirectBBs = other.m_indirectBBs;
   m_mapBB = other.m_mapBB;
   m_bWellFormed = other.m_bWellFormed;
   return *this;
@@ -254,6 +256,10 @@ PBB Cfg::newBB(std::list<RTL*>* pRtls, BBTYPE bbType, int iNumOutEdges) throw(BB
         }
     }
 
+  // Computed jumps and calls are analysed later, by decodeIndirectJmp()
+  if (bbType == COMPJUMP || bbType == COMPCALL)
+    m_indirectBBs.push_back(pBB);
+
   if (addr != 0 && (mi != m_mapBB.end()))
     {
       // Existing New			+---+ Top of new
@@ -458,6 +464,11 @@ PBB Cfg::splitBB (PBB pBB, ADDRESS uNativeAddr, PBB pNewBB /* = 0 */, bool bDelR
   // else pNewBB exists and is complete. We don't want to change the complete BB in any way, except to later add one
   // in-edge
 
+  // A computed jump or call has moved to the bottom BB
+  if ((pNewBB->m_nodeType == COMPJUMP || pNewBB->m_nodeType == COMPCALL) &&
+      std::find(m_indirectBBs.begin(), m_indirectBBs.end(), pNewBB) == m_indirectBBs.end())
+    m_indirectBBs.push_back(pNewBB);
+
   // Update original ("top") basic block's info and make it a fall-through
   pBB->m_nodeType = FALL;
   // Fix the in-edges of pBB's descendants. They are now pNewBB
@@ -851,6 +862,7 @@ void Cfg::completeMerge(PBB pb1, PBB pb2, bool bDelete = false)
           if (*it == pb1)
             {
               m_listBB.erase(it);
+              m_indirectBBs.remove(pb1);
               break;
             }
         }
@@ -882,6 +894,7 @@ bool Cfg::joinBB(PBB pb1, PBB pb2)
   // but that's good because we only did shallow copies to *pb2
   BB_IT bbit = std::find(m_listBB.begin(), m_listBB.end(), pb1);
   m_listBB.erase(bbit);
+  m_indirectBBs.remove(pb1);
   return true;
 }
 
@@ -889,6 +902,7 @@ void Cfg::removeBB( PBB bb)
 {
   BB_IT bbit = std::find(m_listBB.begin(), m_listBB.end(), bb);
   m_listBB.erase(bbit);
+  m_indirectBBs.remove(bb);
 }
 
 /*==============================================================================
@@ -959,6 +973,7 @@ bool Cfg::compressCfg()
                       if (*it3==pSucc)
                         {
                           m_listBB.erase(it3);
+                          m_indirectBBs.remove(pSucc);
                           // And delete the BB
                           delete pSucc;
                           break;
@@ -1424,7 +1439,7 @@ void Cfg::structConds()
 
 // Pre: The loop induced by (head,latch) has already had all its member nodes tagged
 // Post: The type of loop has been deduced
-void Cfg::determineLoopType(PBB header, bool* &loopNodes)
+void Cfg::determineLoopType(PBB header, LoopNodes& loopNodes)
 {
   assert(header->getLatchNode());
 
@@ -1462,7 +1477,7 @@ void Cfg::determineLoopType(PBB header, bool* &loopNodes)
 
 // Pre: The loop headed by header has been induced and all it's member nodes have been tagged
 // Post: The follow of the loop has been determined.
-void Cfg::findLoopFollow(PBB header, bool* &loopNodes)
+void Cfg::findLoopFollow(PBB header, LoopNodes& loopNodes)
 {
   assert(header->getStructType() == Loop || header->getStructType() == LoopCond);
   loopType lType = header->getLoopType();
@@ -1538,7 +1553,7 @@ void Cfg::findLoopFollow(PBB header, bool* &loopNodes)
 // Pre: header has been detected as a loop header and has the details of the
 //		latching node
 // Post: the nodes within the loop have been tagged
-void Cfg::tagNodesInLoop(PBB header, bool* &loopNodes)
+void Cfg::tagNodesInLoop(PBB header, LoopNodes& loopNodes)
 {
   assert(header->getLatchNode());
 
@@ -1551,11 +1566,12 @@ void Cfg::tagNodesInLoop(PBB header, bool* &loopNodes)
   //	iii) curNode is the latch node
 
   PBB latch = header->getLatchNode();
+  loopNodes.reset(latch->ord, header->ord - 1);
   for (int i = header->ord - 1; i >= latch->ord; i--)
     if (Ordering[i]->inLoop(header, latch))
       {
         // update the membership map to reflect that this node is within the loop
-        loopNodes[i] = true;
+        loopNodes.insert(i);
 
         Ordering[i]->setLoopHead(header);
       }
@@ -1566,6 +1582,7 @@ void Cfg::tagNodesInLoop(PBB header, bool* &loopNodes)
 // The header of each loop stores information on the latching node as well as the type of loop it heads.
 void Cfg::structLoops()
 {
+  LoopNodes loopNodes;		// The members of the current loop; see tagNodesInLoop()
   for (int i = Ordering.size() - 1; i >= 0; i--)
     {
       PBB curNode = Ordering[i];	// the current node under investigation
@@ -1598,11 +1615,6 @@ void Cfg::structLoops()
       // if a latching node was found for the current node then it is a loop header.
       if (latch)
         {
-          // define the map that maps each node to whether or not it is within the current loop
-          bool* loopNodes = new bool[Ordering.size()];
-          for (unsigned int j = 0; j < Ordering.size(); j++)
-            loopNodes[j] = false;
-
           curNode->setLatchNode(latch);
 
           // the latching node may already have been structured as a conditional header. If it is not also the loop
@@ -1622,9 +1634,6 @@ void Cfg::structLoops()
 
           // calculate the follow node of this loop
           findLoopFollow(curNode, loopNodes);
-
-          // delete the space taken by the loopnodes map
-          //delete[] loopNodes;
         }
     }
 }
@@ -1931,7 +1940,6 @@ void updateWorkListRev(PBB currBB, std::list<PBB>&workList, std::set<PBB>& workS
     }
 }
 
-static int progress = 0;
 void Cfg::findInterferences(ConnectionGraph& cg)
 {
   if (m_listBB.size() == 0) return;
@@ -1946,11 +1954,7 @@ void Cfg::findInterferences(ConnectionGraph& cg)
   while (workList.size() && count < 100000)
     {
       count++;  // prevent infinite loop
-      if (++progress > 20)
-        {
-          std::cout << "i" << std::flush;
-          progress = 0;
-        }
+      Boomerang::get()->showProgress('i', 20, std::cout);
       PBB currBB = workList.back();
       workList.erase(--workList.end());
       workSet.erase(currBB);
@@ -2192,6 +2196,7 @@ PBB Cfg::splitForBranch(PBB pBB, RTL* rtl, BranchStatement* br1, BranchStatement
 #endif
 
       // Must delete pBB. Note that this effectively "increments" iterator it
+      m_indirectBBs.remove(pBB);
       it = m_listBB.erase(it);
       pBB = NULL;
     }
@@ -2209,14 +2214,30 @@ PBB Cfg::splitForBranch(PBB pBB, RTL* rtl, BranchStatement* br1, BranchStatement
   return newBb;
 }
 
-// Check for indirect jumps and calls in all my BBs; decode any new code
+// Check for indirect jumps and calls in the BBs; decode any new code
 bool Cfg::decodeIndirectJmp(UserProc* proc)
 {
-  std::list<PBB>::iterator it;
+  // Drop the BBs on the worklist that have been resolved, or split so that the computed jump or call is now in
+  // another BB. If none are left, there is no need to look at the BBs at all
+  std::list<PBB>::iterator it = m_indirectBBs.begin();
+  while (it != m_indirectBBs.end())
+    {
+      BBTYPE ty = (*it)->getType();
+      if (ty != COMPJUMP && ty != COMPCALL)
+        it = m_indirectBBs.erase(it);
+      else
+        ++it;
+    }
+  if (m_indirectBBs.empty())
+    return false;
+  // The BBs are analysed in the order of m_listBB, since that decides which code is decoded first. Decoding may
+  // append more BBs (possibly with more computed jumps) to m_listBB; they are visited as well
   bool res = false;
   for (it = m_listBB.begin(); it != m_listBB.end(); it++)
     {
-      res |= (*it)->decodeIndirectJmp(proc);
+      BBTYPE ty = (*it)->getType();
+      if (ty == COMPJUMP || ty == COMPCALL)
+        res |= (*it)->decodeIndirectJmp(proc);
     }
   return res;
 }
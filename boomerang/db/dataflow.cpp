@@ -371,6 +371,8 @@ bool DataFlow::placePhiFunctions(UserProc* proc)
             }
         }
     }
+  if (change)
+    proc->ssaChanged();
   return change;
 }		// end placePhiFunctions
 
@@ -388,14 +390,9 @@ static Exp* defineAll = new Terminal(opDefineAll);		// An expression representin
 #define STACKS_EMPTY(q) (Stacks.find(q) == Stacks.end() || Stacks[q].empty())
 
 // Subscript dataflow variables
-static int progress = 0;
 bool DataFlow::renameBlockVars(UserProc* proc, int n, bool clearStacks /* = false */ )
 {
-  if (++progress > 200)
-    {
-      std::cerr << 'r' << std::flush;
-      progress = 0;
-    }
+  Boomerang::get()->showProgress('r', 200);
   bool changed = false;
 
   // Need to clear the Stacks of old, renamed locations like m[esp-4] (these will be deleted, and will cause compare
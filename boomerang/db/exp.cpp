@@ -1967,53 +1967,55 @@ bool Location::match(const char *pattern, std::map<std::string, Exp*> &bindings)
  *============================================================================*/
 void Exp::doSearch(Exp* search, Exp*& pSrc, std::list<Exp**>& li, bool once)
 {
-  bool compare;
-  compare = (*search == *pSrc);
-  if (compare)
-    {
-      li.push_back(&pSrc);				// Success
-      if (once)
-        return;							// No more to do
+  // The subexpressions are searched in the same order as a recursive search would: each one before its children,
+  // and the children in order
+  std::vector<Exp**> todo;
+  todo.push_back(&pSrc);
+  while (todo.size())
+    {
+      Exp** pp = todo.back();
+      todo.pop_back();
+      bool compare = (*search == **pp);
+      if (compare)
+        {
+          li.push_back(pp);				// Success
+          if (once)
+            return;						// No more to do
+        }
+      // Either want to find all occurrences, or did not match at this level
+      // Search the children, unless a matching opSubscript
+      if (!compare || (*pp)->op != opSubscript)
+        (*pp)->pushSearchChildren(todo);
     }
-  // Either want to find all occurrences, or did not match at this level
-  // Recurse into children, unless a matching opSubscript
-  if (!compare || pSrc->op != opSubscript)
-    pSrc->doSearchChildren(search, li, once);
 }
 
 /*==============================================================================
- * FUNCTION:		Exp::doSearchChildren
- * OVERVIEW:		Search for the given subexpression in all children
+ * FUNCTION:		Exp::pushSearchChildren
+ * OVERVIEW:		Push references to the children to be searched by doSearch, last child first
  * NOTE:			Virtual function; different implementation for each subclass of Exp
- * NOTE:			Will recurse via doSearch
- * PARAMETERS:		search: ptr to Exp we are searching for
- *					li: list of Exp** where pointers to the matches are found
- *					once: true if not all occurrences to be found, false for all
+ * PARAMETERS:		todo: the stack of doSearch
  * RETURNS:			<nothing>
  *============================================================================*/
-void Exp::doSearchChildren(Exp* search, std::list<Exp**>& li, bool once)
+void Exp::pushSearchChildren(std::vector<Exp**>& todo)
 {
   return;			// Const and Terminal do not override this
 }
-void Unary::doSearchChildren(Exp* search, std::list<Exp**>& li, bool once)
+void Unary::pushSearchChildren(std::vector<Exp**>& todo)
 {
   if (op != opInitValueOf)		// don't search child
-    doSearch(search, subExp1, li, once);
+    todo.push_back(&subExp1);
 }
-void Binary::doSearchChildren(Exp* search, std::list<Exp**>& li, bool once)
+void Binary::pushSearchChildren(std::vector<Exp**>& todo)
 {
   assert(subExp1 && subExp2);
-  doSearch(search, subExp1, li, once);
-  if (once && li.size()) return;
-  doSearch(search, subExp2, li, once);
+  todo.push_back(&subExp2);
+  todo.push_back(&subExp1);
 }
-void Ternary::doSearchChildren(Exp* search, std::list<Exp**>& li, bool once)
+void Ternary::pushSearchChildren(std::vector<Exp**>& todo)
 {
-  doSearch(search, subExp1, li, once);
-  if (once && li.size()) return;
-  doSearch(search, subExp2, li, once);
-  if (once && li.size()) return;
-  doSearch(search, subExp3, li, once);
+  todo.push_back(&subExp3);
+  todo.push_back(&subExp2);
+  todo.push_back(&subExp1);
 }
 
 
@@ -2080,8 +2082,9 @@ bool Exp::search(Exp* search, Exp*& result)
   result = 0;				// In case it fails; don't leave it unassigned
   // The search requires a reference to a pointer to this object.
   // This isn't needed for searches, only for replacements, but we want to re-use the same search routine
+  // Only the first match is wanted, so stop there
   Exp* top = this;
-  doSearch(search, top, li, false);
+  doSearch(search, top, li, true);
   if (li.size())
     {
       result = *li.front();
@@ -4290,76 +4293,103 @@ Exp* Binary::simplifyConstraint()
 //	   V i s i t i n g		//
 //							//
 //	//	//	//	//	//	//	//
-bool Unary::accept(ExpVisitor* v)
+bool Exp::accept(ExpVisitor* v)
+{
+  // One stack for all walks in the process, so that there is no allocation per walk. It is not thread safe: walks
+  // from two threads at once would push onto the same stack. A visitor may start another walk from inside this one;
+  // it uses the part of the stack above where it started, and leaves it as it found it
+  static std::vector<Exp*>* todo = NULL;
+  if (todo == NULL)
+    todo = new std::vector<Exp*>;
+  unsigned base = todo->size();
+  todo->push_back(this);
+  while (todo->size() > base)
+    {
+      Exp* e = todo->back();
+      todo->pop_back();
+      if (!e->visitNode(v, *todo))
+        {
+          todo->resize(base);
+          return false;
+        }
+    }
+  return true;
+}
+
+bool Unary::visitNode(ExpVisitor* v, std::vector<Exp*>& todo)
 {
   bool override, ret = v->visit(this, override);
-  if (override) return ret;	// Override the rest of the accept logic
-  if (ret) ret = subExp1->accept(v);
+  if (ret && !override)		// Override the rest of the accept logic
+    todo.push_back(subExp1);
   return ret;
 }
 
-bool Binary::accept(ExpVisitor* v)
+bool Binary::visitNode(ExpVisitor* v, std::vector<Exp*>& todo)
 {
   assert(subExp1 && subExp2);
 
   bool override, ret = v->visit(this, override);
-  if (override) return ret;
-  if (ret) ret = subExp1->accept(v);
-  if (ret) ret = subExp2->accept(v);
+  if (ret && !override)
+    {
+      todo.push_back(subExp2);
+      todo.push_back(subExp1);
+    }
   return ret;
 }
 
-bool Ternary::accept(ExpVisitor* v)
+bool Ternary::visitNode(ExpVisitor* v, std::vector<Exp*>& todo)
 {
   bool override, ret = v->visit(this, override);
-  if (override) return ret;
-  if (ret) ret = subExp1->accept(v);
-  if (ret) ret = subExp2->accept(v);
-  if (ret) ret = subExp3->accept(v);
+  if (ret && !override)
+    {
+      todo.push_back(subExp3);
+      todo.push_back(subExp2);
+      todo.push_back(subExp1);
+    }
   return ret;
 }
 
-// All the Unary derived accept functions look the same, but they have to be repeated because the particular visitor
+// All the Unary derived visitNode functions look the same, but they have to be repeated because the particular visitor
 // function called each time is different for each class (because "this" is different each time)
-bool TypedExp::accept(ExpVisitor* v)
+bool TypedExp::visitNode(ExpVisitor* v, std::vector<Exp*>& todo)
 {
   bool override, ret = v->visit(this, override);
-  if (override) return ret;
-  if (ret) ret = subExp1->accept(v);
+  if (ret && !override)
+    todo.push_back(subExp1);
   return ret;
 }
-bool  FlagDef::accept(ExpVisitor* v)
+bool  FlagDef::visitNode(ExpVisitor* v, std::vector<Exp*>& todo)
 {
   bool override, ret = v->visit(this, override);
-  if (override) return ret;
-  if (ret) ret = subExp1->accept(v);
+  if (ret && !override)
+    todo.push_back(subExp1);
   return ret;
 }
-bool RefExp::accept(ExpVisitor* v)
+bool RefExp::visitNode(ExpVisitor* v, std::vector<Exp*>& todo)
 {
   bool override, ret = v->visit(this, override);
-  if (override) return ret;
-  if (ret) ret = subExp1->accept(v);
+  if (ret && !override)
+    todo.push_back(subExp1);
   return ret;
 }
-bool Location::accept(ExpVisitor* v)
+bool Location::visitNode(ExpVisitor* v, std::vector<Exp*>& todo)
 {
   bool override = false, ret = v->visit(this, override);
-  if (override) return ret;
-  if (ret) ret &= subExp1->accept(v);
+  if (ret && !override)
+    todo.push_back(subExp1);
   return ret;
 }
 
 // The following are similar, but don't have children that have to accept visitors
-bool Terminal::accept(ExpVisitor* v)
+bool Terminal::visitNode(ExpVisitor* v, std::vector<Exp*>& todo)
 {
   return v->visit(this);
 }
-bool	Const::accept(ExpVisitor* v)
+bool	Const::visitNode(ExpVisitor* v, std::vector<Exp*>& todo)
 {
   return v->visit(this);
 }
-bool  TypeVal::accept(ExpVisitor* v)
+bool  TypeVal::visitNode(ExpVisitor* v, std::vector<Exp*>& todo)
 {
   return v->visit(this);
 }
@@ -145,6 +145,7 @@ bool LibProc::isNoReturn()
 
 bool UserProc::isNoReturn()
 {
+  loadBody();
   // undecoded procs are assumed to always return (and define everything)
   if (!this->isDecoded())
     return false;
@@ -170,6 +171,7 @@ bool UserProc::isNoReturn()
  *============================================================================*/
 bool UserProc::containsAddr(ADDRESS uAddr)
 {
+  loadBody();
   BB_IT it;
   for (PBB bb = cfg->getFirstBB(it); bb; bb = cfg->getNextBB(it))
     if (bb->getRTLs() && bb->getLowAddr() <= uAddr && bb->getHiAddr() >= uAddr)
@@ -213,8 +215,8 @@ void UserProc::renameLocal(const char *oldName, const char *newName)
 {
   Type *ty = locals[oldName];
   Exp *oldExp = expFromSymbol(oldName);
+  Exp *oldLoc = getSymbolFor(oldExp, ty);		// Needs the old local's type
   locals.erase(oldName);
-  Exp *oldLoc = getSymbolFor(oldExp, ty);
   Exp *newLoc = Location::local(strdup(newName), this);
   mapSymbolToRepl(oldExp, oldLoc, newLoc);
   locals[strdup(newName)] = ty;
@@ -238,6 +240,7 @@ void Proc::printCallGraphXML(std::ostream &os, int depth, bool recurse)
 
 void UserProc::printCallGraphXML(std::ostream &os, int depth, bool recurse)
 {
+  loadBody();
   if (!DUMP_XML)
     return;
   bool wasVisited = visited;
@@ -440,10 +443,10 @@ bool LibProc::isPreserved(Exp* e)
  *					uNative - Native address of entry point of procedure
  * RETURNS:			<nothing>
  *============================================================================*/
-UserProc::UserProc() : Proc(), cfg(NULL), status(PROC_UNDECODED),
+UserProc::UserProc() : Proc(), cfg(NULL), status(PROC_UNDECODED), bodyPending(false),
   // decoded(false), analysed(false),
   nextLocal(0), nextParam(0),	// decompileSeen(false), decompiled(false), isRecursive(false)
-  cycleGrp(NULL), theReturnStatement(NULL)
+  cycleGrp(NULL), ssaGeneration(0), theReturnStatement(NULL)
 {
   localTable.setProc(this);
 }
@@ -451,9 +454,9 @@ UserProc::UserProc(Prog *prog, std::string& name, ADDRESS uNative) :
   // Not quite ready for the below fix:
   // Proc(prog, uNative, prog->getDefaultSignature(name.c_str())),
   Proc(prog, uNative, new Signature(name.c_str())),
-  cfg(new Cfg()), status(PROC_UNDECODED),
+  cfg(new Cfg()), status(PROC_UNDECODED), bodyPending(false),
   nextLocal(0),  nextParam(0),// decompileSeen(false), decompiled(false), isRecursive(false),
-  cycleGrp(NULL), theReturnStatement(NULL), DFGcount(0)
+  cycleGrp(NULL), ssaGeneration(0), theReturnStatement(NULL), DFGcount(0)
 {
   cfg->setProc(this);				 // Initialise cfg.myProc
   localTable.setProc(this);
@@ -474,6 +477,7 @@ UserProc::~UserProc()
  *============================================================================*/
 void UserProc::deleteCFG()
 {
+  bodyPending = false;						// Any body still in the snapshot goes too
   delete cfg;
   cfg = NULL;
 }
@@ -500,9 +504,12 @@ SyntaxNode *UserProc::getAST()
       numBBs++;
     }
 
-  // perform a best first search for the nicest AST
+  // perform a best first search for the nicest AST. Successors share the subtrees they don't change with their
+  // parent, so no tree is deleted until the search is over; trees keeps them all for that
   std::priority_queue<SyntaxNode*, std::vector<SyntaxNode*>, lessEvaluate > ASTs;
+  std::vector<SyntaxNode*> trees;
   ASTs.push(init);
+  trees.push_back(init);
 
   SyntaxNode *best = init;
   int best_score = init->getScore();
@@ -517,14 +524,13 @@ SyntaxNode *UserProc::getAST()
 
       SyntaxNode *top = ASTs.top();
       ASTs.pop();
-      int score = top->evaluate(top);
+      int score = top->getValue();
 
-      printAST(top); // debug
+      if (DEBUG_GEN)
+        printAST(top);
 
       if (score < best_score)
         {
-          if (best && top != best)
-            delete best;
           best = top;
           best_score = score;
         }
@@ -540,21 +546,16 @@ SyntaxNode *UserProc::getAST()
         {
           //successors[i]->addToScore(top->getScore());	// uncomment for A*
           successors[i]->addToScore(successors[i]->getDepth()); // or this
+          // The index is only needed while a tree is evaluated
+          successors[i]->clearIndex();
           ASTs.push(successors[i]);
+          trees.push_back(successors[i]);
         }
-
-      if (top != best)
-        delete top;
+      top->clearIndex();
     }
 
   // clean up memory
-  while (ASTs.size())
-    {
-      SyntaxNode *top = ASTs.top();
-      ASTs.pop();
-      if (top != best)
-        delete top;
-    }
+  SyntaxNode::deleteTrees(trees, best);
 
   return best;
 }
@@ -569,7 +570,7 @@ void UserProc::printAST(SyntaxNode *a)
   sprintf(s, "ast%i-%s.dot", count++, getName());
   std::ofstream of(s);
   of << "digraph " << getName() << " {" << std::endl;
-  of << "	 label=\"score: " << a->evaluate(a) << "\";" << std::endl;
+  of << "	 label=\"score: " << a->getValue() << "\";" << std::endl;
   a->printAST(a, of);
   of << "}" << std::endl;
   of.close();
@@ -595,6 +596,8 @@ void UserProc::setDecoded()
  *============================================================================*/
 void UserProc::unDecode()
 {
+  bodyPending = false;						// Any body still in the snapshot goes too
+  ssaChanged();
   cfg->clear();
   setStatus(PROC_UNDECODED);
 }
@@ -607,6 +610,7 @@ void UserProc::unDecode()
  *============================================================================*/
 PBB UserProc::getEntryBB()
 {
+  loadBody();
   return cfg->getEntryBB();
 }
 
@@ -645,8 +649,16 @@ void UserProc::addCallee(Proc* callee)
   calleeList.push_back(callee);
 }
 
+// Read the body of this proc from the snapshot that it was loaded from lazily
+void UserProc::readBody()
+{
+  bodyPending = false;
+  prog->loadProcBody(this);
+}
+
 void UserProc::generateCode(HLLCode *hll)
 {
+  loadBody();
   assert(cfg);
   assert(getEntryBB());
 
@@ -661,6 +673,23 @@ void UserProc::generateCode(HLLCode *hll)
 
   hll->AddProcStart(this);
 
+  if (budget.wasExceeded())
+    {
+      std::string cmt = std::string("decompilation budget exceeded: ") + budget.getReason() + " ";
+      hll->AddLineComment((char*)cmt.c_str());
+      if (budget.getDecodedRTL().size())
+        {
+          // Emit the RTL that was current when the budget ran out, one comment per line
+          std::istringstream ist(budget.getDecodedRTL());
+          std::string line;
+          while (std::getline(ist, line))
+            {
+              line += " ";
+              hll->AddLineComment((char*)line.c_str());
+            }
+        }
+    }
+
   // Local variables; print everything in the locals map
   std::map<std::string, Type*>::iterator last = locals.end();
   if (locals.size()) last--;
@@ -695,6 +724,7 @@ void UserProc::generateCode(HLLCode *hll)
 // print this userproc, maining for debugging
 void UserProc::print(std::ostream &out, bool html)
 {
+  loadBody();
   signature->print(out, html);
   if (html)
     out << "<br>";
@@ -727,6 +757,17 @@ void UserProc::setStatus(ProcStatus s)
   Boomerang::get()->alert_proc_status_change(this);
 }
 
+bool UserProc::isOverBudget()
+{
+  if (budget.wasExceeded())
+    return true;
+  if (!budget.isExceeded())
+    return false;
+  LOG << "budget for " << getName() << " exceeded: " << budget.getReason() << " in " <<
+      ProcBudget::getPhaseName(budget.getExceededPhase()) << " phase\n";
+  return true;
+}
+
 void UserProc::printParams(std::ostream& out, bool html)
 {
   if (html)
@@ -863,6 +904,7 @@ void UserProc::numberStatements()
 // Get to a statement list, so they come out in a reasonable and consistent order
 void UserProc::getStatements(StatementList &stmts)
 {
+  loadBody();
   BB_IT it;
   for (PBB bb = cfg->getFirstBB(it); bb; bb = cfg->getNextBB(it))
     bb->getStatements(stmts);
@@ -876,6 +918,7 @@ void UserProc::getStatements(StatementList &stmts)
 // Should use iterators or other context to find out how to erase "in place" (without having to linearly search)
 void UserProc::removeStatement(Statement *stmt)
 {
+  ssaChanged();
   // remove anything proven about this statement
   for (std::map<Exp*, Exp*, lessExpStar>::iterator it = provenTrue.begin(); it != provenTrue.end(); )
     {
@@ -924,6 +967,7 @@ void UserProc::removeStatement(Statement *stmt)
 
 void UserProc::insertAssignAfter(Statement* s, Exp* left, Exp* right)
 {
+  ssaChanged();
   std::list<Statement*>::iterator it;
   std::list<Statement*>* stmts;
   if (s == NULL)
@@ -955,6 +999,7 @@ void UserProc::insertAssignAfter(Statement* s, Exp* left, Exp* right)
 // So this is an inefficient linear search!
 void UserProc::insertStatementAfter(Statement* s, Statement* a)
 {
+  ssaChanged();
   BB_IT bb;
   for (bb = cfg->begin(); bb != cfg->end(); bb++)
     {
@@ -1032,6 +1077,9 @@ void UserProc::insertStatementAfter(Statement* s, Statement* a)
 // Decompile this UserProc
 ProcSet* UserProc::decompile(ProcList* path, int& indent)
 {
+  // Only this body is read here. Callees read theirs when they are decompiled below, and callers when getCallers()
+  // is asked for them
+  loadBody();
   Boomerang::get()->alert_considering(path->empty() ? NULL : path->back(), this);
   std::cout << std::setw(++indent) << " " << (status >= PROC_VISITED ? "re" : "") << "considering " << getName() <<
             "\n";
@@ -1222,6 +1270,7 @@ ProcSet* UserProc::decompile(ProcList* path, int& indent)
 
 void UserProc::initialiseDecompile()
 {
+  BudgetPhaseScope scope(budget, PHASE_EARLY);
 
   Boomerang::get()->alert_start_decompile(this);
 
@@ -1265,6 +1314,14 @@ void UserProc::initialiseDecompile()
       LOG << "=== end initial debug print after decoding for " << getName() << " ===\n\n";
     }
 
+  if (ProcBudget::isLimited())
+    {
+      // The budget may run out in any later phase; keep the RTL as decoded, so that it can be emitted with the code
+      std::ostringstream ost;
+      cfg->print(ost);
+      budget.setDecodedRTL(ost.str());
+    }
+
   Boomerang::get()->alert_decompile_debug_point(this, "after initialise");
 }
 // Can merge these two now
@@ -1274,6 +1331,8 @@ void UserProc::earlyDecompile()
   if (status >= PROC_EARLYDONE)
     return;
 
+  BudgetPhaseScope scope(budget, PHASE_EARLY);
+
   Boomerang::get()->alert_decompile_debug_point(this, "before early");
   if (VERBOSE) LOG << "early decompile for " << getName() << "\n";
 
@@ -1324,9 +1383,22 @@ void UserProc::earlyDecompile()
 
 ProcSet* UserProc::middleDecompile(ProcList* path, int indent)
 {
+  BudgetPhaseScope scope(budget, PHASE_MIDDLE);
 
   Boomerang::get()->alert_decompile_debug_point(this, "before middle");
 
+  if (isOverBudget())
+    {
+      // Don't even start; the proc will be finished off with the cheap versions of the later analyses. The
+      // preservations and the duplicate arguments are still needed by the callers and the code generator
+      LOG << "skipping middle decompile for " << getName() << " (over budget)\n";
+      findSpPreservation();
+      findPreserveds();
+      eliminateDuplicateArgs();
+      setStatus(PROC_EARLYDONE);
+      return new ProcSet;
+    }
+
   // The call bypass logic should be staged as well. For example, consider m[r1{11}]{11} where 11 is a call.
   // The first stage bypass yields m[r1{2}]{11}, which needs another round of propagation to yield m[r1{-}-32]{11}
   // (which can safely be processed at depth 1).
@@ -1515,6 +1587,12 @@ ProcSet* UserProc::middleDecompile(ProcList* path, int indent)
 
       if (!change)
         break;				// Until no change
+
+      if (isOverBudget())
+        {
+          LOG << "abandoning further passes for " << getName() << " at pass " << pass << " (over budget)\n";
+          break;
+        }
     }
 
   // At this point, there will be some memofs that have still not been renamed. They have been prevented from
@@ -1565,7 +1643,8 @@ ProcSet* UserProc::middleDecompile(ProcList* path, int indent)
     }
 
   // Check for indirect jumps or calls not already removed by propagation of constants
-  if (cfg->decodeIndirectJmp(this))
+  // Don't do this when over budget, since success means restarting the decompilation of this proc
+  if (!isOverBudget() && cfg->decodeIndirectJmp(this))
     {
       // There was at least one indirect jump or call found and decoded. That means that most of what has been done
       // to this function so far is invalid. So redo everything. Very expensive!!
@@ -1579,6 +1658,7 @@ ProcSet* UserProc::middleDecompile(ProcList* path, int indent)
       processDecodedICTs();
       // Now, decode from scratch
       theReturnStatement = NULL;
+      ssaChanged();
       cfg->clear();
       std::ofstream os;
       prog->reDecode(this);
@@ -1635,6 +1715,8 @@ void UserProc::remUnusedStmtEtc()
   //if (status >= PROC_FINAL)
   //	return;
 
+  BudgetPhaseScope scope(budget, PHASE_FINAL);
+
   Boomerang::get()->alert_decompiling(this);
   Boomerang::get()->alert_decompile_debug_point(this, "before final");
 
@@ -1924,6 +2006,7 @@ void UserProc::updateCalls()
 
 void UserProc::branchAnalysis()
 {
+  ssaChanged();
   Boomerang::get()->alert_decompile_debug_point(this, "before branch analysis.");
 
   StatementList stmts;
@@ -1995,6 +2078,7 @@ void UserProc::branchAnalysis()
 
 void UserProc::fixUglyBranches()
 {
+  ssaChanged();
   if (VERBOSE)
     LOG << "### fixUglyBranches for " << getName() << " ###\n";
 
@@ -2047,6 +2131,8 @@ bool UserProc::doRenameBlockVars(int pass, bool clearStacks)
   if (VERBOSE)
     LOG << "### rename block vars for " << getName() << " pass " << pass << ", clear = " << clearStacks << " ###\n";
   bool b = df.renameBlockVars(this, 0, clearStacks);
+  if (b)
+    ssaChanged();
   if (VERBOSE)
     LOG << "df.renameBlockVars return " << (b ? "true" : "false") << "\n";
   return b;
@@ -2264,6 +2350,7 @@ void UserProc::removeMatchingAssignsIfPossible(Exp *e)
  */
 void UserProc::assignProcsToCalls()
 {
+  ssaChanged();
   std::list<PBB>::iterator it;
   PBB pBB = cfg->getFirstBB(it);
   while (pBB)
@@ -2302,6 +2389,7 @@ void UserProc::assignProcsToCalls()
  */
 void UserProc::finalSimplify()
 {
+  ssaChanged();
   std::list<PBB>::iterator it;
   PBB pBB = cfg->getFirstBB(it);
   while (pBB)
@@ -2572,6 +2660,7 @@ void UserProc::trimParameters(int depth)
 
 void UserProc::removeReturn(Exp *e)
 {
+  ssaChanged();
   if (theReturnStatement)
     theReturnStatement->removeReturn(e);
 }
@@ -2582,7 +2671,8 @@ void Proc::removeParameter(Exp *e)
   if (n != -1)
     {
       signature->removeParameter(n);
-      for (std::set<CallStatement*>::iterator it = callerSet.begin(); it != callerSet.end(); it++)
+      std::set<CallStatement*>& callers = getCallers();
+      for (std::set<CallStatement*>::iterator it = callers.begin(); it != callers.end(); it++)
         {
           if (DEBUG_UNUSED)
             LOG << "removing argument " << e << " in pos " << n << " from " << *it << "\n";
@@ -2671,35 +2761,30 @@ Exp *UserProc::getSymbolExp(Exp *le, Type *ty, bool lastPass)
         le->getSubExp1()->getSubExp1()->getSubExp1()->isRegN(signature->getStackRegister()) &&
         le->getSubExp1()->getSubExp2()->isIntConst())
     {
-      for (SymbolMap::iterator it = symbolMap.begin(); it != symbolMap.end(); it++)
+      // Only the stack locals that start below le can contain it; try the closest first
+      int m = -((Const*)le->getSubExp1()->getSubExp2())->getInt();
+      std::multimap<int, std::pair<Exp*, Exp*> >::iterator it = symbolsByOffset.lower_bound(m);
+      while (it != symbolsByOffset.begin())
         {
-          if ((*it).second->isLocal())
+          --it;
+          Exp *loc = it->second.first;
+          Exp *sym = it->second.second;
+          if (!sym->isLocal() || !loc->getSubExp1()->getSubExp1()->getSubExp1()->isRegN(signature->getStackRegister()))
+            continue;
+          const char *nam = ((Const*)sym->getSubExp1())->getStr();
+          std::map<std::string, Type*>::iterator lt = locals.find(nam);
+          if (lt == locals.end())
+            continue;
+          int n = it->first;
+          if (m < n + (int)(lt->second->getSize() / 8))
             {
-              const char *nam = ((Const*)(*it).second->getSubExp1())->getStr();
-              if (locals.find(nam) != locals.end())
-                {
-                  Type *lty = locals[nam];
-                  Exp *loc = (*it).first;
-                  if (	loc->isMemOf() &&
-                        loc->getSubExp1()->getOper() == opMinus &&
-                        loc->getSubExp1()->getSubExp1()->isSubscript() &&
-                        loc->getSubExp1()->getSubExp1()->getSubExp1()->isRegN(signature->getStackRegister()) &&
-                        loc->getSubExp1()->getSubExp2()->isIntConst())
-                    {
-                      int n = -((Const*)loc->getSubExp1()->getSubExp2())->getInt();
-                      int m = -((Const*)le->getSubExp1()->getSubExp2())->getInt();
-                      if (m > n && m < n + (int)(lty->getSize() / 8))
-                        {
-                          e = Location::memOf(
-                                new Binary(opPlus,
-                                           new Unary(opAddrOf, (*it).second->clone()),
-                                           new Const(m - n)));
-                          if (VERBOSE)
-                            LOG << "seems " << le << " is in the middle of " << loc << " returning " << e << "\n";
-                          return e;
-                        }
-                    }
-                }
+              e = Location::memOf(
+                    new Binary(opPlus,
+                               new Unary(opAddrOf, sym->clone()),
+                               new Const(m - n)));
+              if (VERBOSE)
+                LOG << "seems " << le << " is in the middle of " << loc << " returning " << e << "\n";
+              return e;
             }
         }
     }
@@ -2765,6 +2850,7 @@ Exp *UserProc::getSymbolExp(Exp *le, Type *ty, bool lastPass)
 // Not used with DFA Type Analysis; the equivalent thing happens in mapLocalsAndParams() now
 void UserProc::mapExpressionsToLocals(bool lastPass)
 {
+  ssaChanged();
   StatementList stmts;
   getStatements(stmts);
 
@@ -2895,52 +2981,71 @@ void UserProc::mapExpressionsToLocals(bool lastPass)
 
   Boomerang::get()->alert_decompile_debug_point(this, "after processing array locals");
 
-  // Stack offsets for local variables could be negative (most machines), positive (PA/RISC), or both (SPARC)
-  if (signature->isLocalOffsetNegative())
-    searchRegularLocals(opMinus, lastPass, sp, stmts);
-  if (signature->isLocalOffsetPositive())
-    searchRegularLocals(opPlus, lastPass, sp, stmts);
-  // Ugh - m[sp] is a special case: neither positive or negative.  SPARC uses this to save %i0
-  if (signature->isLocalOffsetPositive() && signature->isLocalOffsetNegative())
-    searchRegularLocals(opWild, lastPass, sp, stmts);
+  searchRegularLocals(lastPass, sp, stmts);
 
   Boomerang::get()->alert_decompile_debug_point(this, "after mapping expressions to locals");
 }
 
-void UserProc::searchRegularLocals(OPER minusOrPlus, bool lastPass, int sp, StatementList& stmts)
+// If e is m[sp{-} - K], m[sp{-} + K] or m[sp{-}], set kind to opMinus, opPlus or opWild respectively and return true
+static bool isStackLocation(Exp* e, int sp, OPER& kind)
 {
-  // replace expressions in regular statements with locals
-  Location* l;
-  if (minusOrPlus == opWild)
-    // l = m[sp{0}]
-    l = Location::memOf(
-          new RefExp(Location::regOf(sp), NULL));
+  if (!e->isMemOf()) return false;
+  Exp* addr = e->getSubExp1();
+  if (addr->isSubscript())
+    kind = opWild;
   else
-    // l = m[sp{0} +/- K]
-    l = Location::memOf(
-          new Binary(minusOrPlus,
-                     new RefExp(Location::regOf(sp), NULL),
-                     new Terminal(opWildIntConst)));
+    {
+      kind = addr->getOper();
+      if ((kind != opMinus && kind != opPlus) || !addr->getSubExp2()->isIntConst())
+        return false;
+      addr = addr->getSubExp1();
+      if (!addr->isSubscript())
+        return false;
+    }
+  return ((RefExp*)addr)->isImplicitDef() && addr->getSubExp1()->isRegN(sp);
+}
+
+void UserProc::searchRegularLocals(bool lastPass, int sp, StatementList& stmts)
+{
+  // Stack offsets for local variables could be negative (most machines), positive (PA/RISC), or both (SPARC)
+  bool negative = signature->isLocalOffsetNegative();
+  bool positive = signature->isLocalOffsetPositive();
+  // Ugh - m[sp] is a special case: neither positive or negative.  SPARC uses this to save %i0
+  bool zero = negative && positive;
+
+  // Find all the stack locations in one pass over the statements, then map them in the order that a search for each
+  // kind in turn would find them: first the negative offsets, then the positive ones, then m[sp{0}]. The order
+  // decides the numbering of the locals
+  std::vector<std::pair<Statement*, Exp*> > found[3];
+  Exp* memOf = Location::memOf(new Terminal(opWild));
   StatementList::iterator it;
   for (it = stmts.begin(); it != stmts.end(); it++)
     {
       Statement* s = *it;
       std::list<Exp*> results;
-      s->searchAll(l, results);
+      s->searchAll(memOf, results);
       for (std::list<Exp*>::iterator it1 = results.begin(); it1 != results.end(); it1++)
         {
-          Exp *result = *it1;
+          OPER kind;
+          if (!isStackLocation(*it1, sp, kind))
+            continue;
+          if (kind == opMinus ? negative : kind == opPlus ? positive : zero)
+            found[kind == opMinus ? 0 : kind == opPlus ? 1 : 2].push_back(std::pair<Statement*, Exp*>(s, *it1));
+        }
+    }
+
+  for (int i=0; i < 3; i++)
+    {
+      std::vector<std::pair<Statement*, Exp*> >::iterator ff;
+      for (ff = found[i].begin(); ff != found[i].end(); ff++)
+        {
+          Statement* s = ff->first;
+          Exp *result = ff->second;
           Type* ty = s->getTypeFor(result);
           Exp *e = getSymbolExp(result, ty, lastPass);
-          if (e)
-            {
-              Exp* search = result->clone();
-              if (VERBOSE)
-                LOG << "mapping " << search << " to " << e << " in " << s << "\n";
-              //s->searchAndReplace(search, e);
-            }
+          if (e && VERBOSE)
+            LOG << "mapping " << result << " to " << e << " in " << s << "\n";
         }
-      //s->simplify();
     }
 }
 
@@ -2977,6 +3082,7 @@ bool UserProc::propagateStatements(bool& convert, int pass)
     LOG << "--- begin propagating statements pass " << pass << " ---\n";
   StatementList stmts;
   getStatements(stmts);
+  budget.addStatements(stmts.size());
   // propagate any statements that can be
   StatementList::iterator it;
   // Find the locations that are used by a live, dominating phi-function
@@ -3014,6 +3120,8 @@ bool UserProc::propagateStatements(bool& convert, int pass)
     }
   simplify();
   propagateToCollector();
+  if (change)
+    ssaChanged();
   if (VERBOSE)
     LOG << "=== end propagating statements at pass " << pass << " ===\n";
   return change;
@@ -3106,10 +3214,10 @@ void UserProc::setLocalType(const char *nam, Type *ty)
 
 Type *UserProc::getParamType(const char *nam)
 {
-  for (unsigned int i = 0; i < signature->getNumParams(); i++)
-    if (std::string(nam) == signature->getParamName(i))
-      return signature->getParamType(i);
-  return NULL;
+  int n = signature->findParam(nam);
+  if (n == -1)
+    return NULL;
+  return signature->getParamType(n);
 }
 
 void UserProc::setExpSymbol(const char *nam, Exp *e, Type* ty)
@@ -3133,10 +3241,68 @@ void UserProc::mapSymbolTo(Exp* from, Exp* to)
         return;				// Already in the multimap
       ++it;
     }
-  std::pair<Exp*, Exp*> pr;
-  pr.first = from;
-  pr.second = to;
-  symbolMap.insert(pr);
+  insertSymbol(from, to);
+}
+
+// If e is of the form m[x{-} - K], set offset to -K and return true
+static bool isStackOffset(Exp* e, int& offset)
+{
+  if (!e->isMemOf())
+    return false;
+  Exp* addr = e->getSubExp1();
+  if (addr->getOper() != opMinus || !addr->getSubExp1()->isSubscript() || !addr->getSubExp2()->isIntConst())
+    return false;
+  offset = -((Const*)addr->getSubExp2())->getInt();
+  return true;
+}
+
+void UserProc::insertSymbol(Exp* from, Exp* to)
+{
+  symbolMap.insert(std::pair<Exp*, Exp*>(from, to));
+  if (to->isLocal())
+    symbolsByName[((Const*)to->getSubExp1())->getStr()].push_back(from);
+  int offset;
+  if (isStackOffset(from, offset))
+    symbolsByOffset.insert(std::pair<int, std::pair<Exp*, Exp*> >(offset, std::pair<Exp*, Exp*>(from, to)));
+}
+
+void UserProc::eraseSymbol(SymbolMap::iterator it)
+{
+  Exp* from = it->first;
+  Exp* to = it->second;
+  if (to->isLocal())
+    {
+      std::map<std::string, std::vector<Exp*> >::iterator ff =
+        symbolsByName.find(((Const*)to->getSubExp1())->getStr());
+      if (ff != symbolsByName.end())
+        {
+          std::vector<Exp*>& froms = ff->second;
+          std::vector<Exp*>::iterator ee = std::find(froms.begin(), froms.end(), from);
+          if (ee != froms.end())
+            froms.erase(ee);
+          if (froms.empty())
+            symbolsByName.erase(ff);
+        }
+    }
+  int offset;
+  if (isStackOffset(from, offset))
+    {
+      std::multimap<int, std::pair<Exp*, Exp*> >::iterator oo;
+      for (oo = symbolsByOffset.lower_bound(offset); oo != symbolsByOffset.upper_bound(offset); ++oo)
+        if (oo->second.first == from && oo->second.second == to)
+          {
+            symbolsByOffset.erase(oo);
+            break;
+          }
+    }
+  symbolMap.erase(it);
+}
+
+void UserProc::clearSymbols()
+{
+  symbolMap.clear();
+  symbolsByName.clear();
+  symbolsByOffset.clear();
 }
 
 // FIXME: is this the same as lookupSym() now?
@@ -3164,7 +3330,7 @@ void UserProc::removeSymbolMapping(Exp* from, Exp* to)
     {
       if (*it->second == *to)
         {
-          symbolMap.erase(it);
+          eraseSymbol(it);
           return;
         }
       it++;
@@ -3173,16 +3339,18 @@ void UserProc::removeSymbolMapping(Exp* from, Exp* to)
 
 
 
-// NOTE: linear search!!
 Exp *UserProc::expFromSymbol(const char *nam)
 {
-  for (SymbolMap::iterator it = symbolMap.begin(); it != symbolMap.end(); it++)
-    {
-      Exp* e = it->second;
-      if (e->isLocal() && !strcmp(((Const*)((Location*)e)->getSubExp1())->getStr(), nam))
-        return it->first;
-    }
-  return NULL;
+  std::map<std::string, std::vector<Exp*> >::iterator ff = symbolsByName.find(nam);
+  if (ff == symbolsByName.end())
+    return NULL;
+  // The first one in the symbol map, i.e. the least
+  std::vector<Exp*>& froms = ff->second;
+  Exp* ret = froms[0];
+  for (unsigned i=1; i < froms.size(); i++)
+    if (*froms[i] < *ret)
+      ret = froms[i];
+  return ret;
 }
 
 const char* UserProc::getLocalName(int n)
@@ -3353,7 +3521,7 @@ void UserProc::removeUnusedLocals()
           const char* tmpName = ((Const*)((Location*)mapsTo)->getSubExp1())->getStr();
           if (removes.find(tmpName) != removes.end())
             {
-              symbolMap.erase(sm++);
+              eraseSymbol(sm++);
               continue;
             }
         }
@@ -3368,6 +3536,7 @@ void UserProc::removeUnusedLocals()
 
 void UserProc::fromSSAform()
 {
+  ssaChanged();
   Boomerang::get()->alert_decompiling(this);
 
   if (VERBOSE)
@@ -3723,7 +3892,7 @@ void UserProc::removeSubscriptsFromSymbols()
   // Since this will potentially change the ordering of entries, need to copy the map
   SymbolMap sm2 = symbolMap;				// Object copy
   SymbolMap::iterator it;
-  symbolMap.clear();
+  clearSymbols();
   ExpSsaXformer esx(this);
   for (it = sm2.begin(); it != sm2.end(); ++it)
     {
@@ -3780,6 +3949,17 @@ bool UserProc::prove(Exp *query, bool conditional /* = false */)
   if (Boomerang::get()->noProve)
     return false;
 
+  // Conditional proofs, and proofs in a recursion group, depend on premises that come and go, so don't memoise them
+  ProofCache& memo = prog->getProofCache();
+  bool useMemo = !conditional && cycleGrp == NULL && !Boomerang::get()->noProofMemo;
+  if (useMemo && memo.lookup(this, query))
+    {
+      if (DEBUG_PROOF) LOG << "found true in proof memo " << query << " in " << getName() << "\n";
+      return true;
+    }
+
+  // query is modified below, so keep a copy of it as it was asked. The copy is never changed: its sides go into
+  // provenTrue, and the memo keeps the copy itself
   Exp *original = query->clone();
   Exp* origLeft = ((Binary*)original)->getSubExp1();
   Exp* origRight = ((Binary*)original)->getSubExp2();
@@ -3820,6 +4000,7 @@ bool UserProc::prove(Exp *query, bool conditional /* = false */)
               if (DEBUG_PROOF)
                 LOG << "Using all=all for " << query->getSubExp1() << "\n" << "prove returns true\n";
               provenTrue[origLeft->clone()] = right;
+              if (useMemo) memo.store(this, original);
               return true;
             }
           if (DEBUG_PROOF)
@@ -3834,6 +4015,7 @@ bool UserProc::prove(Exp *query, bool conditional /* = false */)
 
   std::set<PhiAssign*> lastPhis;
   std::map<PhiAssign*, Exp*> cache;
+  memo.countProverCall();
   bool result = prover(query, lastPhis, cache, original);
   if (cycleGrp)
     recurPremises.erase(origLeft);			// Remove the premise, regardless of result
@@ -3843,11 +4025,15 @@ bool UserProc::prove(Exp *query, bool conditional /* = false */)
   if (!conditional)
     {
       if (result)
-        provenTrue[origLeft] = origRight;	// Save the now proven equation
+        {
+          provenTrue[origLeft] = origRight;	// Save the now proven equation
+        }
 #if PROVEN_FALSE
       else
         provenFalse[origLeft] = origRight;	// Save the now proven-to-be-false equation
 #endif
+      if (useMemo && result)
+        memo.store(this, original);			// Unlike provenTrue, invalidated when the SSA form changes
     }
   return result;
 }
@@ -4031,9 +4217,10 @@ bool UserProc::prover(Exp *query, std::set<PhiAssign*>& lastPhis, std::map<PhiAs
                         LOG << "found " << s << " prove for each\n";
                       for (it = pa->begin(); it != pa->end(); it++)
                         {
-                          Exp *e = query->clone();
-                          RefExp *r1 = (RefExp*)e->getSubExp1();
-                          r1->setDef(it->def);
+                          // The query with the left side referring to this phi operand instead. Only the top two
+                          // nodes are new: prover() copies its query before changing it
+                          Exp *e = new Binary(query->getOper(), new RefExp(r->getSubExp1(), it->def),
+                                              query->getSubExp2());
                           if (DEBUG_PROOF)
                             LOG << "proving for " << e << "\n";
                           lastPhis.insert(lastPhi);
@@ -4133,11 +4320,13 @@ bool UserProc::prover(Exp *query, std::set<PhiAssign*>& lastPhis, std::map<PhiAs
           query = new Terminal(c->getInt() ? opTrue : opFalse);
         }
 
-      Exp *old = query->clone();
+      // query is this prover's own copy (see above), and everything put into it is a copy, so it can be simplified in
+      // place
+      Exp *old = DEBUG_PROOF ? query->clone() : NULL;
 
-      query = query->clone()->simplify();
+      query = query->simplify();
 
-      if (change && !(*old == *query) && DEBUG_PROOF)
+      if (change && old && !(*old == *query))
         {
           LOG << old << "\n";
         }
@@ -4157,6 +4346,19 @@ void UserProc::getDefinitions(LocationSet& ls)
     }
 }
 
+std::set<CallStatement*>& Proc::getCallers()
+{
+  // The calls are changed by the callee (e.g. arguments removed), so they must be filled in first if their procs
+  // were loaded lazily
+  for (std::set<CallStatement*>::iterator it = callerSet.begin(); it != callerSet.end(); it++)
+    {
+      UserProc* callerProc = (*it)->getProc();
+      if (callerProc)
+        callerProc->loadBody();
+    }
+  return callerSet;
+}
+
 void Proc::addCallers(std::set<UserProc*>& callers)
 {
   std::set<CallStatement*>::iterator it;
@@ -4384,6 +4586,7 @@ bool UserProc::ellipsisProcessing()
 // pieces of code add r28{0}
 void UserProc::addImplicitAssigns()
 {
+  ssaChanged();
   Boomerang::get()->alert_decompile_debug_point(this, "before adding implicit assigns");
 
   StatementList stmts;
@@ -4451,7 +4654,7 @@ const char* UserProc::lookupSym( Exp* e, Type* ty )
       assert(sym->isLocal() || sym->isParam());
       const char* name = ((Const*)((Location*)sym)->getSubExp1())->getStr();
       Type* type = getLocalType(name);
-      if (type == NULL) type = getParamType(name);	// Ick currently linear search
+      if (type == NULL) type = getParamType(name);
       if (type && type->isCompatibleWith(ty))
         return name;
       ++it;
@@ -4561,6 +4764,7 @@ void UserProc::dumpLocals()
 
 void UserProc::updateArguments()
 {
+  ssaChanged();
   Boomerang::get()->alert_decompiling(this);
   if (VERBOSE)
     LOG << "### update arguments for " << getName() << " ###\n";
@@ -4589,6 +4793,7 @@ void UserProc::updateArguments()
 
 void UserProc::updateCallDefines()
 {
+  ssaChanged();
   if (VERBOSE)
     LOG << "### update call defines for " << getName() << " ###\n";
   StatementList stmts;
@@ -4878,6 +5083,7 @@ const char* UserProc::findFirstSymbol( Exp* e )
 
 void UserProc::fixCallAndPhiRefs()
 {
+  ssaChanged();
   if (VERBOSE)
     LOG << "### start fix call and phi bypass analysis for " << getName() << " ###\n";
 
@@ -5179,18 +5385,9 @@ bool UserProc::isLocalOrParam(Exp* e)
 bool UserProc::isLocalOrParamPattern(Exp* e)
 {
   if (!e->isMemOf()) return false;			// Don't want say a register
-  Exp* addr = ((Location*)e)->getSubExp1();
   if (!signature->isPromoted()) return false;	// Prevent an assert failure if using -E
-  int sp = signature->getStackRegister();
-  Exp* initSp = new RefExp(Location::regOf(sp), NULL);	// sp{-}
-  if (*addr == *initSp) return true;			// Accept m[sp{-}]
-  if (addr->getArity() != 2) return false;	// Require sp +/- K
-  OPER op = ((Binary*)addr)->getOper();
-  if (op != opPlus && op != opMinus) return false;
-  Exp* left =  ((Binary*)addr)->getSubExp1();
-  if (!(*left == *initSp)) return false;
-  Exp* right = ((Binary*)addr)->getSubExp2();
-  return right->isIntConst();
+  OPER kind;
+  return isStackLocation(e, signature->getStackRegister(), kind);
 }
 
 // Remove the unused parameters. Check for uses for each parameter as param{0}.
@@ -5429,7 +5626,7 @@ bool UserProc::removeRedundantParameters()
           // Check if it is in the symbol map. If so, delete it; a local will be created later
           SymbolMap::iterator ss = symbolMap.find(param);
           if (ss != symbolMap.end())
-            symbolMap.erase(ss);			// Kill the symbol
+            eraseSymbol(ss);			// Kill the symbol
           signature->removeParameter(param);	// Also remove from the signature
           cfg->removeImplicitAssign(param);	// Remove the implicit assignment so it doesn't come back
         }
@@ -5557,8 +5754,9 @@ bool UserProc::removeRedundantReturns(std::set<UserProc*>& removeRetSet)
   if (removedParams || removedRets)
     {
       // Update the statements that call us
+      std::set<CallStatement*>& callers = getCallers();
       std::set<CallStatement*>::iterator it;
-      for (it = callerSet.begin(); it != callerSet.end() ; it++)
+      for (it = callers.begin(); it != callers.end() ; it++)
         {
           (*it)->updateArguments();				// Update caller's arguments
           updateSet.insert((*it)->getProc());		// Make sure we redo the dataflow
@@ -5712,7 +5910,7 @@ void UserProc::typeAnalysis()
           // so do it just before translating from SSA form (which is the where type information becomes inaccessible)
 
         }
-      while (ellipsisProcessing());
+      while (!isOverBudget() && ellipsisProcessing());		// Ellipsis processing is skipped when over budget
       simplify();						// In case there are new struct members
       if (VERBOSE || DEBUG_TA)
         LOG << "=== end type analysis for " << getName() << " ===\n";
@@ -5805,6 +6003,11 @@ void UserProc::rangeAnalysis()
           LOG << "  watchdog expired\n";
           break;
         }
+      if (isOverBudget())
+        {
+          LOG << "  abandoning range analysis for " << getName() << " (over budget)\n";
+          break;
+        }
     }
 
   LOG << "=== After range analysis for " << getName() << " ===\n";
@@ -5849,6 +6052,7 @@ void UserProc::logSuspectMemoryDefs()
 RTL* globalRtl = 0;
 void UserProc::processDecodedICTs()
 {
+  ssaChanged();
   BB_IT it;
   BasicBlock::rtlrit rrit;
   StatementList::reverse_iterator srit;
@@ -5949,6 +6153,7 @@ void UserProc::setImplicitRef(Statement* s, Exp* a, Type* ty)
 
 void UserProc::eliminateDuplicateArgs()
 {
+  ssaChanged();
   if (VERBOSE)
     LOG << "### eliminate duplicate args for " << getName() << " ###\n";
   BB_IT it;
@@ -5965,6 +6170,7 @@ void UserProc::eliminateDuplicateArgs()
 
 void UserProc::removeCallLiveness()
 {
+  ssaChanged();
   if (VERBOSE)
     LOG << "### removing call livenesses for " << getName() << " ###\n";
   BB_IT it;
@@ -6039,7 +6245,7 @@ void UserProc::makeSymbolsImplicit()
 {
   SymbolMap::iterator it;
   SymbolMap sm2 = symbolMap;			// Copy the whole map; necessary because the keys (Exps) change
-  symbolMap.clear();
+  clearSymbols();
   ImplicitConverter ic(cfg);
   for (it = sm2.begin(); it != sm2.end(); ++it)
     {
@@ -6331,6 +6537,7 @@ Memo *UserProc::makeMemo(int mId)
 
 void UserProc::readMemo(Memo *mm, bool dec)
 {
+  bodyPending = false;						// The memo replaces the body
   UserProcMemo *m = dynamic_cast<UserProcMemo*>(mm);
   visited = m->visited;
   prog = m->prog;
@@ -6360,5 +6567,10 @@ void UserProc::readMemo(Memo *mm, bool dec)
       (*it).first->restoreMemo(m->mId, dec);
       (*it).second->restoreMemo(m->mId, dec);
     }
+  // The indexes of the symbol map are not in the memo, and the restored expressions may have changed
+  SymbolMap sm2 = symbolMap;
+  clearSymbols();
+  for (SymbolMap::iterator it = sm2.begin(); it != sm2.end(); it++)
+    insertSymbol(it->first, it->second);
 }
 #endif		// #ifdef USING_MEMOS
@@ -44,6 +44,7 @@
 #include <fstream>
 #include <sstream>
 #include <vector>
+#include <algorithm>
 #include <cmath>
 #ifdef _WIN32
 #include <direct.h>					// For Windows mkdir()
@@ -67,6 +68,7 @@
 #include "ansi-c-parser.h"
 #include "config.h"
 #include "managed.h"
+#include "progsnapshot.h"
 #include "log.h"
 
 #ifdef _WIN32
@@ -85,11 +87,15 @@ namespace dbghelp
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#define GLOBAL_TA_ITER_LIMIT 10		// Times a proc is analysed again by globalTypeAnalysis()
+
 Prog::Prog() :
     pBF(NULL),
     pFE(NULL),
     m_iNumberedProc(1),
-    m_rootCluster(new Cluster("prog"))
+    m_rootCluster(new Cluster("prog")),
+    lazyLoader(NULL),
+    context(Boomerang::get())
 {
   // Default constructor
 }
@@ -110,7 +116,9 @@ Prog::Prog(const char* name) :
     pFE(NULL),
     m_name(name),
     m_iNumberedProc(1),
-    m_rootCluster(new Cluster(getNameNoPathNoExt().c_str()))
+    m_rootCluster(new Cluster(getNameNoPathNoExt().c_str())),
+    lazyLoader(NULL),
+    context(Boomerang::get())
 {
   // Constructor taking a name. Technically, the allocation of the space for the name could fail, but this is unlikely
   m_path = m_name;
@@ -120,6 +128,7 @@ Prog::~Prog()
 {
   if (pBF) delete pBF;
   if (pFE) delete pFE;
+  if (lazyLoader) delete lazyLoader;
   for (std::list<Proc*>::iterator it = m_procs.begin(); it != m_procs.end(); it++)
     {
       if (*it)
@@ -196,6 +205,7 @@ void Prog::generateDotFile()
 
 void Prog::generateCode(Cluster *cluster, UserProc *proc, bool intermixRTL)
 {
+  ContextScope scope(context);
   std::string basedir = m_rootCluster->makeDirs();
   std::ofstream os;
   if (cluster)
@@ -512,6 +522,7 @@ void Prog::clear()
       delete *it;
   m_procs.clear();
   m_procLabels.clear();
+  proofCache.clear();
   if (pBF)
     delete pBF;
   pBF = NULL;
@@ -821,6 +832,8 @@ void Prog::removeProc(const char *name)
     if (std::string(name) == (*it)->getName())
       {
         Boomerang::get()->alert_remove(*it);
+        if (!(*it)->isLib())
+          proofCache.forget((UserProc*)*it);
         m_procs.erase(it);
         break;
       }
@@ -1406,9 +1419,28 @@ void Prog::decodeEverythingUndecoded()
   finishDecode();
 }
 
+void Prog::loadProcBody(UserProc* proc)
+{
+  if (lazyLoader)
+    lazyLoader->loadBody(proc);
+}
+
+void Prog::loadAllProcBodies()
+{
+  if (lazyLoader == NULL)
+    return;
+  lazyLoader->loadAll();
+  // Nothing is left in the snapshot now
+  delete lazyLoader;
+  lazyLoader = NULL;
+}
+
 void Prog::decompile()
 {
+  ContextScope scope(context);
   assert(m_procs.size());
+  // Decompilation is interprocedural, so all the bodies are needed
+  loadAllProcBodies();
 
   if (VERBOSE)
     LOG << (int)m_procs.size() << " procedures\n";
@@ -1460,8 +1492,7 @@ void Prog::decompile()
               // A final pass to remove returns not used by any caller
               if (VERBOSE)
                 LOG << "prog: global removing unused returns\n";
-              // Repeat until no change. Note 100% sure if needed.
-              while (removeUnusedReturns());
+              removeUnusedReturns();
             }
 
         // print XML after removing returns
@@ -1482,6 +1513,13 @@ void Prog::decompile()
   // Note: removeUnusedLocals() is now in UserProc::generateCode()
 
   removeUnusedGlobals();
+
+  if (VERBOSE || DEBUG_PROOF)
+    {
+      std::ostringstream ost;
+      proofCache.printStatistics(ost);
+      LOG << ost.str().c_str();
+    }
 }
 
 void Prog::removeUnusedGlobals()
@@ -1538,6 +1576,12 @@ void Prog::removeUnusedGlobals()
     }
 }
 
+static int numReturnsOf(UserProc* proc)
+{
+  ReturnStatement* rs = proc->getTheReturnStatement();
+  return rs ? rs->getNumReturns() : 0;
+}
+
 // This is the global removing of unused and redundant returns. The initial idea is simple enough: remove some returns
 // according to the formula returns(p) = modifieds(p) isect union(live at c) for all c calling p.
 // However, removing returns reduces the uses, leading to three effects:
@@ -1547,33 +1591,75 @@ void Prog::removeUnusedGlobals()
 //   the child, and do the union again (hence needing a list of callers) to find out if this change also affects that
 //	 child.
 // Return true if any change
+// The procs to check are kept in a worklist. Removing returns or parameters from a proc adds its callers (their
+// arguments and call liveness change), and processing a proc adds the callees of any of its calls whose liveness
+// changed (see UserProc::updateForUseChange()). So when the worklist is empty, nothing more can be removed, and there
+// is no need to call this again.
 bool Prog::removeUnusedReturns()
 {
-  // For each UserProc. Each proc may process many others, so this may duplicate some work. Really need a worklist of
-  // procedures not yet processed.
-  // Define a workset for the procedures who have to have their returns checked
-  // This will be all user procs, except those undecoded (-sf says just trust the given signature)
-  std::set<UserProc*> removeRetSet;
+  // Initially all user procs, except those undecoded (-sf says just trust the given signature). Procs added to the
+  // worklist go in the order of m_procs, so that it is processed in the same order every time
+  std::map<UserProc*, int> order;
+  std::list<UserProc*> worklist;
+  std::set<UserProc*> queued;
+  std::map<UserProc*, int> numChanges, oldReturns, oldParams;
   std::list<Proc*>::iterator pp;
   bool change=false;
-  for (pp = m_procs.begin(); pp != m_procs.end(); ++pp)
+  int n = 0;
+  for (pp = m_procs.begin(); pp != m_procs.end(); ++pp, ++n)
     {
       UserProc* proc = (UserProc*)(*pp);
       if (proc->isLib()) continue;
+      order[proc] = n;
       if (!proc->isDecoded()) continue;		// e.g. use -sf file to just prototype the proc
-      removeRetSet.insert(proc);
+      worklist.push_back(proc);
+      queued.insert(proc);
+    }
+  // Note that sometimes changes propagate down the call tree (no caller uses potential returns for child), and
+  // sometimes up the call tree (removal of returns and/or dead code removes parameters, which affects all callers).
+  int numProcessed = 0;
+  while (worklist.size())
+    {
+      UserProc* proc = worklist.front();
+      worklist.pop_front();
+      queued.erase(proc);
+      if (oldReturns.find(proc) == oldReturns.end())
+        {
+          oldReturns[proc] = numReturnsOf(proc);
+          oldParams[proc] = proc->getParameters().size();
+        }
+      // The procs that proc says need checking again (possibly including itself)
+      std::set<UserProc*> removeRetSet;
+      if (proc->removeRedundantReturns(removeRetSet))
+        {
+          change = true;
+          numChanges[proc]++;
+        }
+      numProcessed++;
+      std::map<int, UserProc*> added;
+      std::set<UserProc*>::iterator it;
+      for (it = removeRetSet.begin(); it != removeRetSet.end(); ++it)
+        if (queued.find(*it) == queued.end())
+          added[order.find(*it) == order.end() ? n++ : order[*it]] = *it;
+      std::map<int, UserProc*>::iterator aa;
+      for (aa = added.begin(); aa != added.end(); ++aa)
+        {
+          worklist.push_back(aa->second);
+          queued.insert(aa->second);
+        }
     }
-  // The workset is processed in arbitrary order. May be able to do better, but note that sometimes changes propagate
-  // down the call tree (no caller uses potential returns for child), and sometimes up the call tree (removal of
-  // returns and/or dead code removes parameters, which affects all callers).
-  std::set<UserProc*>::iterator it;
-  while (removeRetSet.size())
+
+  if (VERBOSE || DEBUG_UNUSED)
     {
-      it = removeRetSet.begin();		// Pick the first element of the set
-      change |= (*it)->removeRedundantReturns(removeRetSet);
-      // Note: removing the currently processed item here should prevent unnecessary reprocessing of self recursive
-      // procedures
-      removeRetSet.erase(it);			// Remove the current element (may no longer be the first)
+      std::map<UserProc*, int>::iterator cc;
+      for (cc = numChanges.begin(); cc != numChanges.end(); ++cc)
+        {
+          UserProc* proc = cc->first;
+          LOG << "removed " << oldReturns[proc] - numReturnsOf(proc) << " returns and " <<
+              oldParams[proc] - (int)proc->getParameters().size() << " parameters from " << proc->getName() <<
+              " (changed " << cc->second << " times)\n";
+        }
+      LOG << "removing unused returns: processed procedures " << numProcessed << " times\n";
     }
   return change;
 }
@@ -1622,23 +1708,111 @@ void Prog::conTypeAnalysis()
     LOG << "=== end type analysis ===\n";
 }
 
+// Put the procs from first to last into result, ordered by their position (in m_procs)
+static void inProgramOrder(std::set<UserProc*>::iterator first, std::set<UserProc*>::iterator last,
+                           std::map<UserProc*, int>& position, std::vector<UserProc*>& result)
+{
+  std::vector<std::pair<int, UserProc*> > byPos;
+  for (; first != last; ++first)
+    byPos.push_back(std::pair<int, UserProc*>(position[*first], *first));
+  std::sort(byPos.begin(), byPos.end());
+  for (unsigned i = 0; i < byPos.size(); i++)
+    result.push_back(byPos[i].second);
+}
+
 void Prog::globalTypeAnalysis()
 {
   if (VERBOSE || DEBUG_TA)
     LOG << "### start global data-flow-based type analysis ###\n";
+  // First the local type analysis of each proc, then a worklist of the procs whose boundary types (parameters and
+  // returns, or arguments and results of their calls) changed when they were met with those at the other end of
+  // their calls. Only those procs are analysed again, and then their own calls and their callers are met again,
+  // until nothing changes. Procs are queued in the order of m_procs whenever several are queued at once, so that the
+  // order of the analyses (and so the log) does not depend on where the procs happen to be in memory
+  std::list<UserProc*> toMeet, toAnalyse;
+  std::set<UserProc*> inMeet, inAnalyse;
+  std::map<UserProc*, int> runs;
+  std::map<UserProc*, int> position;		// Of each proc in m_procs
+  int numPositions = 0;
+  int numRuns = 0;
   std::list<Proc*>::iterator pp;
   for (pp = m_procs.begin(); pp != m_procs.end(); pp++)
     {
       UserProc* proc = (UserProc*)(*pp);
       if (proc->isLib()) continue;
+      position[proc] = numPositions++;
       if (!proc->isDecoded()) continue;
-      // FIXME: this just does local TA again. Need to meet types for all parameter/arguments, and return/results!
-      // This will require a repeat until no change loop
       std::cout << "global type analysis for " << proc->getName() << "\n";
+      BudgetPhaseScope scope(proc->getBudget(), PHASE_GLOBAL);
       proc->typeAnalysis();
+      numRuns++;
+      toMeet.push_back(proc);
+      inMeet.insert(proc);
+    }
+  int numProcs = numRuns;
+
+  while (toMeet.size() || toAnalyse.size())
+    {
+      while (toMeet.size())
+        {
+          UserProc* proc = toMeet.front();
+          toMeet.pop_front();
+          inMeet.erase(proc);
+          std::set<UserProc*> changedSet;
+          if (proc->meetCallTypes(changedSet))
+            changedSet.insert(proc);
+          std::vector<UserProc*> changed;
+          inProgramOrder(changedSet.begin(), changedSet.end(), position, changed);
+          std::vector<UserProc*>::iterator cc;
+          for (cc = changed.begin(); cc != changed.end(); cc++)
+            {
+              if (!(*cc)->isDecoded() || (*cc)->isOverBudget()) continue;
+              if (runs[*cc] >= GLOBAL_TA_ITER_LIMIT)
+                {
+                  if (runs[*cc]++ == GLOBAL_TA_ITER_LIMIT)
+                    LOG << "### WARNING: iteration limit exceeded for global type analysis of procedure " <<
+                        (*cc)->getName() << " ###\n";
+                  continue;
+                }
+              if (inAnalyse.insert(*cc).second)
+                toAnalyse.push_back(*cc);
+            }
+        }
+      if (toAnalyse.size() == 0)
+        break;
+
+      UserProc* proc = toAnalyse.front();
+      toAnalyse.pop_front();
+      inAnalyse.erase(proc);
+      if (VERBOSE || DEBUG_TA)
+        LOG << "global type analysis for " << proc->getName() << " (boundary types changed)\n";
+      {
+        BudgetPhaseScope scope(proc->getBudget(), PHASE_GLOBAL);
+        proc->typeAnalysis();
+      }
+      runs[proc]++;
+      numRuns++;
+      // The new types have to be met with the callees of proc, and with its callers
+      if (inMeet.insert(proc).second)
+        toMeet.push_back(proc);
+      std::set<CallStatement*>& callers = proc->getCallers();
+      std::set<UserProc*> callerSet;
+      std::set<CallStatement*>::iterator it;
+      for (it = callers.begin(); it != callers.end(); it++)
+        if ((*it)->getProc())
+          callerSet.insert((*it)->getProc());
+      std::vector<UserProc*> callerProcs;
+      inProgramOrder(callerSet.begin(), callerSet.end(), position, callerProcs);
+      for (unsigned i = 0; i < callerProcs.size(); i++)
+        if (inMeet.insert(callerProcs[i]).second)
+          toMeet.push_back(callerProcs[i]);
     }
+
   if (VERBOSE || DEBUG_TA)
-    LOG << "### end type analysis ###\n";
+    {
+      LOG << "global type analysis: " << numRuns << " procedure analyses for " << numProcs << " procedures\n";
+      LOG << "### end type analysis ###\n";
+    }
 }
 
 void Prog::rangeAnalysis()
@@ -1649,11 +1823,35 @@ void Prog::rangeAnalysis()
       UserProc* proc = (UserProc*)(*pp);
       if (proc->isLib()) continue;
       if (!proc->isDecoded()) continue;
+      BudgetPhaseScope scope(proc->getBudget(), PHASE_GLOBAL);
       proc->rangeAnalysis();
       proc->logSuspectMemoryDefs();
     }
 }
 
+void Prog::printBudgetSummary(std::ostream &os)
+{
+  if (!ProcBudget::isLimited())
+    return;
+  int numOver = 0;
+  std::list<Proc*>::iterator pp;
+  for (pp = m_procs.begin(); pp != m_procs.end(); pp++)
+    {
+      if ((*pp)->isLib()) continue;
+      UserProc* proc = (UserProc*)(*pp);
+      if (!proc->getBudget().wasExceeded()) continue;
+      if (numOver++ == 0)
+        os << "procedures over their decompilation budget:\n";
+      os << "  " << proc->getName() << ": ";
+      proc->getBudget().print(os);
+      os << "\n";
+    }
+  if (numOver == 0)
+    os << "all procedures decompiled within budget\n";
+  else
+    os << numOver << " of " << getNumUserProcs() << " procedures over budget\n";
+}
+
 void Prog::printCallGraph()
 {
   std::string fname1 = Boomerang::get()->getOutputPath() + "callgraph.out";
@@ -0,0 +1,2556 @@
+/*
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+/*==============================================================================
+ * FILE:	   progsnapshot.cpp
+ * OVERVIEW:   Implementation of the ProgSnapshot class, which saves and loads the state of a Prog in a compact binary
+ *				format (see progsnapshot.h for the layout)
+ *============================================================================*/
+
+#include <cassert>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#if defined(_WIN32)
+#include <io.h>
+#include <process.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "progsnapshot.h"
+#include "prog.h"
+#include "proc.h"
+#include "cfg.h"
+#include "basicblock.h"
+#include "rtl.h"
+#include "register.h"
+#include "statement.h"
+#include "exp.h"
+#include "type.h"
+#include "signature.h"
+#include "cluster.h"
+#include "dataflow.h"
+#include "managed.h"
+#include "frontend.h"
+#include "BinaryFile.h"
+#include "boomerang.h"
+#include "log.h"
+
+static const char snapMagic[] = "BMRGSNAP";
+static const char dictMagic[] = "BMRGSSLD";
+#define SNAP_MAGIC_LEN	8
+#define SNAP_HEADER_LEN	(SNAP_MAGIC_LEN + 4 * 4)	// Magic, then version and the offsets of the 3 sections
+#define DICT_HEADER_LEN	(SNAP_MAGIC_LEN + 6 * 4)	// Magic, versions, hash, build, and the offsets of the 2 sections
+
+// Identifies the build of the decompiler (and so of the SSL parser) that saved a dictionary, so that a rebuilt one
+// parses the SSL file again, even when the versions above were not changed. This is the time that this file was
+// compiled, and where it can be found, the size and time of the executable
+static unsigned buildFingerprint()
+{
+  static unsigned fingerprint = 0;
+  if (fingerprint != 0)
+    return fingerprint;
+  std::string stamp = std::string(Boomerang::getVersionStr()) + " " + __DATE__ + " " + __TIME__;
+  char buf[64];
+  sprintf(buf, " %d", (int)sizeof(void*));
+  stamp += buf;
+#if defined(__linux__)
+  struct stat st;
+  if (stat("/proc/self/exe", &st) == 0)
+    {
+      sprintf(buf, " %ld %ld", (long)st.st_size, (long)st.st_mtime);
+      stamp += buf;
+    }
+#endif
+  unsigned hash = 2166136261u;
+  for (size_t i=0; i < stamp.size(); i++)
+    hash = (hash ^ (unsigned char)stamp[i]) * 16777619u;
+  fingerprint = hash ? hash : 1;
+  return fingerprint;
+}
+
+// The classes of Exp, for the tag that starts each expression
+enum SnapExpClass {SE_NULL, SE_TYPEVAL, SE_TERMINAL, SE_CONST, SE_LOCATION, SE_REFEXP, SE_FLAGDEF, SE_TYPEDEXP,
+                   SE_TERNARY, SE_BINARY, SE_UNARY
+                  };
+
+// The kinds of Signature
+enum SnapSigKind {SS_NULL, SS_GENERIC, SS_PLATFORM, SS_CUSTOM};
+
+// The kinds of Cluster
+enum SnapClusterKind {SC_CLUSTER, SC_MODULE, SC_CLASS};
+
+static void put32(std::vector<unsigned char>& v, unsigned n)
+{
+  for (int i=0; i < 4; i++)
+    v.push_back((unsigned char)(n >> (i*8)));
+}
+
+static unsigned get32(const unsigned char* p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned)p[3] << 24);
+}
+
+// Make an empty statement of the given kind, to be filled in later by getStatement()
+static Statement* newStatement(int kind)
+{
+  switch (kind)
+    {
+    case STMT_ASSIGN:
+      return new Assign();
+    case STMT_PHIASSIGN:
+      return new PhiAssign((Exp*)NULL);
+    case STMT_IMPASSIGN:
+      return new ImplicitAssign((Exp*)NULL);
+    case STMT_BOOLASSIGN:
+      return new BoolAssign(0);
+    case STMT_CALL:
+      return new CallStatement();
+    case STMT_RET:
+      return new ReturnStatement();
+    case STMT_BRANCH:
+      return new BranchStatement();
+    case STMT_GOTO:
+      return new GotoStatement();
+    case STMT_CASE:
+      return new CaseStatement();
+    case STMT_IMPREF:
+      return new ImpRefStatement(NULL, NULL);
+    case STMT_JUNCTION:
+      return new JunctionStatement();
+    default:
+      return NULL;
+    }
+}
+
+ProgSnapshot::ProgSnapshot() : out(NULL), danglingRefs(0), base(NULL), size(0), mapped(false), in(NULL), inEnd(NULL),
+  bad(false), prog(NULL), typeDefs(NULL)
+{
+}
+
+ProgSnapshot::~ProgSnapshot()
+{
+  unmap();
+}
+
+/*==============================================================================
+ * FUNCTION:		ProgSnapshot::isSnapshot
+ * OVERVIEW:		Check if a file is a snapshot
+ * PARAMETERS:		fname - name of the file
+ * RETURNS:			True if the file starts with the snapshot magic number
+ *============================================================================*/
+bool ProgSnapshot::isSnapshot(const char* fname)
+{
+  FILE* f = fopen(fname, "rb");
+  if (f == NULL)
+    return false;
+  char buf[SNAP_MAGIC_LEN];
+  bool ret = fread(buf, 1, SNAP_MAGIC_LEN, f) == SNAP_MAGIC_LEN && memcmp(buf, snapMagic, SNAP_MAGIC_LEN) == 0;
+  fclose(f);
+  return ret;
+}
+
+//	//	//	//	//	//	//	//
+//							//
+//		W r i t i n g		//
+//							//
+//	//	//	//	//	//	//	//
+
+void ProgSnapshot::putNum(unsigned n)
+{
+  while (n >= 0x80)
+    {
+      putByte((unsigned char)(n | 0x80));
+      n >>= 7;
+    }
+  putByte((unsigned char)n);
+}
+
+// Signed numbers are "zigzag" encoded, so that small negative numbers are as short as small positive ones
+void ProgSnapshot::putSNum(int n)
+{
+  putNum(((unsigned)n << 1) ^ (unsigned)(n >> 31));
+}
+
+void ProgSnapshot::putQWord(QWord n)
+{
+  while (n >= 0x80)
+    {
+      putByte((unsigned char)(n | 0x80));
+      n >>= 7;
+    }
+  putByte((unsigned char)n);
+}
+
+void ProgSnapshot::putDouble(double d)
+{
+  QWord n;
+  assert(sizeof(n) == sizeof(d));
+  memcpy(&n, &d, sizeof(n));
+  putQWord(n);
+}
+
+void ProgSnapshot::putString(const std::string& s)
+{
+  std::map<std::string, unsigned>::iterator it = stringIds.find(s);
+  if (it != stringIds.end())
+    {
+      putNum(it->second);
+      return;
+    }
+  unsigned id = strings.size();
+  stringIds[s] = id;
+  strings.push_back(s);
+  putNum(id);
+}
+
+void ProgSnapshot::putProc(Proc* p)
+{
+  std::map<Proc*, unsigned>::iterator it = procIds.find(p);
+  putNum(it == procIds.end() ? 0 : it->second);
+}
+
+void ProgSnapshot::putStmt(Statement* s)
+{
+  if (s == NULL)
+    {
+      putNum(0);
+      return;
+    }
+  std::map<Statement*, std::pair<unsigned, unsigned> >::iterator it = stmtIds.find(s);
+  if (it == stmtIds.end())
+    {
+      // Not reachable from any proc (e.g. already deleted); it is read back as NULL
+      danglingRefs++;
+      putNum(0);
+      return;
+    }
+  putNum(it->second.first);
+  putNum(it->second.second);
+}
+
+void ProgSnapshot::putBB(BasicBlock* bb)
+{
+  std::map<BasicBlock*, unsigned>::iterator it = bbIds.find(bb);
+  putNum(it == bbIds.end() ? 0 : it->second);
+}
+
+void ProgSnapshot::putCluster(Cluster* c)
+{
+  std::map<Cluster*, unsigned>::iterator it = clusterIds.find(c);
+  putNum(it == clusterIds.end() ? 0 : it->second);
+}
+
+// Types are written once each, in the pool (see putPool()), and referred to by number everywhere else. So a type
+// shared by several owners is shared again when it is read back, and a type that refers to itself (e.g. a compound
+// with a member that points to it) is written only once
+void ProgSnapshot::putType(Type* ty)
+{
+  if (ty == NULL)
+    {
+      putNum(0);
+      return;
+    }
+  std::map<Type*, unsigned>::iterator it = typeIds.find(ty);
+  if (it != typeIds.end())
+    {
+      putNum(it->second);
+      return;
+    }
+  unsigned id = typeList.size() + 1;
+  typeIds[ty] = id;
+  typeList.push_back(ty);
+  putNum(id);
+}
+
+// The definition of a type, for the pool. The types that it refers to are written by number (see putType())
+void ProgSnapshot::putTypeDef(Type* ty)
+{
+  eType id = ty->getId();
+  if (id == eUpper && ty->isLower())
+    id = eLower;						// LowerType is constructed with the id of an UpperType
+  putByte((unsigned char)(id+1));
+  switch (id)
+    {
+    case eVoid:
+    case eBoolean:
+    case eChar:
+      break;
+    case eFunc:
+      putSignature(((FuncType*)ty)->signature);
+      break;
+    case eInteger:
+      putNum(((IntegerType*)ty)->size);
+      putSNum(((IntegerType*)ty)->signedness);
+      break;
+    case eFloat:
+      putNum(((FloatType*)ty)->size);
+      break;
+    case ePointer:
+      putType(((PointerType*)ty)->points_to);
+      break;
+    case eArray:
+      putType(((ArrayType*)ty)->base_type);
+      putNum(((ArrayType*)ty)->length);
+      break;
+    case eNamed:
+      putString(((NamedType*)ty)->name);
+      break;
+    case eCompound:
+    {
+      CompoundType* c = (CompoundType*)ty;
+      putBool(c->generic);
+      putSNum(c->nextGenericMemberNum);
+      putNum(c->types.size());
+      for (unsigned i=0; i < c->types.size(); i++)
+        {
+          putString(c->names[i]);
+          putType(c->types[i]);
+        }
+      break;
+    }
+    case eUnion:
+    {
+      UnionType* u = (UnionType*)ty;
+      putNum(u->li.size());
+      for (std::list<UnionElement>::iterator it = u->li.begin(); it != u->li.end(); it++)
+        {
+          putString(it->name);
+          putType(it->type);
+        }
+      break;
+    }
+    case eSize:
+      putNum(((SizeType*)ty)->size);
+      break;
+    case eUpper:
+      putType(((UpperType*)ty)->getBaseType());
+      break;
+    case eLower:
+      putType(((LowerType*)ty)->getBaseType());
+      break;
+    }
+}
+
+void ProgSnapshot::putExp(Exp* e)
+{
+  if (e == NULL)
+    {
+      putByte(SE_NULL);
+      return;
+    }
+  // Note: the order matters, since e.g. a TypeVal is also a Terminal
+  if (TypeVal* t = dynamic_cast<TypeVal*>(e))
+    {
+      putByte(SE_TYPEVAL);
+      putNum(e->op);
+      putType(t->val);
+    }
+  else if (dynamic_cast<Terminal*>(e))
+    {
+      putByte(SE_TERMINAL);
+      putNum(e->op);
+    }
+  else if (Const* c = dynamic_cast<Const*>(e))
+    {
+      putByte(SE_CONST);
+      putNum(e->op);
+      putSNum(c->conscript);
+      putType(c->type);
+      switch (e->op)
+        {
+        case opIntConst:
+          putSNum(c->u.i);
+          break;
+        case opFltConst:
+          putDouble(c->u.d);
+          break;
+        case opStrConst:
+          putString(c->u.p);
+          break;
+        case opFuncConst:
+          putProc(c->u.pp);
+          break;
+        default:
+          putQWord(c->u.ll);
+          break;
+        }
+    }
+  else if (Location* l = dynamic_cast<Location*>(e))
+    {
+      putByte(SE_LOCATION);
+      putNum(e->op);
+      putProc(l->proc);
+      putExp(l->subExp1);
+    }
+  else if (RefExp* r = dynamic_cast<RefExp*>(e))
+    {
+      putByte(SE_REFEXP);
+      putNum(e->op);
+      putStmt(r->def);
+      putExp(r->subExp1);
+    }
+  else if (FlagDef* f = dynamic_cast<FlagDef*>(e))
+    {
+      putByte(SE_FLAGDEF);
+      putNum(e->op);
+      std::map<RTL*, unsigned>::iterator it = rtlIds.find(f->rtl);
+      putNum(it == rtlIds.end() ? 0 : it->second);
+      putExp(f->subExp1);
+    }
+  else if (TypedExp* ty = dynamic_cast<TypedExp*>(e))
+    {
+      putByte(SE_TYPEDEXP);
+      putNum(e->op);
+      putType(ty->type);
+      putExp(ty->subExp1);
+    }
+  else if (Ternary* tn = dynamic_cast<Ternary*>(e))
+    {
+      putByte(SE_TERNARY);
+      putNum(e->op);
+      putExp(tn->subExp1);
+      putExp(tn->subExp2);
+      putExp(tn->subExp3);
+    }
+  else if (Binary* b = dynamic_cast<Binary*>(e))
+    {
+      putByte(SE_BINARY);
+      putNum(e->op);
+      putExp(b->subExp1);
+      putExp(b->subExp2);
+    }
+  else if (Unary* u = dynamic_cast<Unary*>(e))
+    {
+      putByte(SE_UNARY);
+      putNum(e->op);
+      putExp(u->subExp1);
+    }
+  else
+    {
+      std::cerr << "unknown exp in ProgSnapshot::putExp\n";
+      assert(false);
+    }
+}
+
+void ProgSnapshot::putSignature(Signature* sig)
+{
+  if (sig == NULL)
+    {
+      putByte(SS_NULL);
+      return;
+    }
+  platform plat = sig->getPlatform();
+  if (CustomSignature* cs = dynamic_cast<CustomSignature*>(sig))
+    {
+      putByte(SS_CUSTOM);
+      putSNum(cs->getStackRegister());
+    }
+  else if (plat == PLAT_PENTIUM || plat == PLAT_SPARC || plat == PLAT_PPC || plat == PLAT_ST20)
+    {
+      // The platforms that Signature::instantiate() knows about
+      putByte(SS_PLATFORM);
+      putNum(plat);
+      putNum(sig->getConvention());
+    }
+  else
+    putByte(SS_GENERIC);
+  putString(sig->name);
+  putString(sig->sigFile);
+  putBool(sig->ellipsis);
+  putBool(sig->unknown);
+  putBool(sig->forced);
+  putString(sig->preferedName);
+  putNum(sig->params.size());
+  for (unsigned i=0; i < sig->params.size(); i++)
+    {
+      Parameter* p = sig->params[i];
+      putString(p->name);
+      putType(p->type);
+      putExp(p->exp);
+      putString(p->boundMax);
+    }
+  putNum(sig->returns.size());
+  for (Returns::iterator rr = sig->returns.begin(); rr != sig->returns.end(); ++rr)
+    {
+      putType((*rr)->type);
+      putExp((*rr)->exp);
+    }
+  putType(sig->rettype);
+  putType(sig->preferedReturn);
+  putNum(sig->preferedParams.size());
+  for (unsigned i=0; i < sig->preferedParams.size(); i++)
+    putSNum(sig->preferedParams[i]);
+}
+
+void ProgSnapshot::putDefCollector(DefCollector& col)
+{
+  putBool(col.initialised);
+  putNum(col.defs.size());
+  for (AssignSet::iterator it = col.defs.begin(); it != col.defs.end(); ++it)
+    putStmt(*it);
+}
+
+void ProgSnapshot::putDataIntervals(DataIntervalMap& dim)
+{
+  putNum(dim.dimap.size());
+  for (DataIntervalMap::iterator it = dim.dimap.begin(); it != dim.dimap.end(); ++it)
+    {
+      putNum(it->first);
+      putNum(it->second.size);
+      putString(it->second.name);
+      putType(it->second.type);
+    }
+}
+
+void ProgSnapshot::putStatement(Statement* s)
+{
+  putSNum(s->number);
+  putSNum(s->dominanceNum);
+  putBB(s->pbb);
+  putStmt(s->parent);
+  putProc(s->proc);
+  switch (s->kind)
+    {
+    case STMT_ASSIGN:
+    {
+      Assign* a = (Assign*)s;
+      putType(a->type);
+      putExp(a->lhs);
+      putExp(a->rhs);
+      putExp(a->guard);
+      break;
+    }
+    case STMT_PHIASSIGN:
+    {
+      PhiAssign* pa = (PhiAssign*)s;
+      putType(pa->type);
+      putExp(pa->lhs);
+      putNum(pa->defVec.size());
+      for (PhiAssign::iterator it = pa->defVec.begin(); it != pa->defVec.end(); ++it)
+        {
+          putStmt(it->def);
+          putExp(it->e);
+        }
+      break;
+    }
+    case STMT_IMPASSIGN:
+      putType(((ImplicitAssign*)s)->type);
+      putExp(((ImplicitAssign*)s)->lhs);
+      break;
+    case STMT_BOOLASSIGN:
+    {
+      BoolAssign* ba = (BoolAssign*)s;
+      putType(ba->type);
+      putExp(ba->lhs);
+      putNum(ba->jtCond);
+      putExp(ba->pCond);
+      putBool(ba->bFloat);
+      putSNum(ba->size);
+      break;
+    }
+    case STMT_IMPREF:
+      putType(((ImpRefStatement*)s)->type);
+      putExp(((ImpRefStatement*)s)->addressExp);
+      break;
+    case STMT_GOTO:
+    case STMT_BRANCH:
+    case STMT_CASE:
+    case STMT_CALL:
+    {
+      GotoStatement* g = (GotoStatement*)s;
+      putExp(g->pDest);
+      putBool(g->m_isComputed);
+      if (s->kind == STMT_BRANCH)
+        {
+          BranchStatement* br = (BranchStatement*)s;
+          putNum(br->jtCond);
+          putExp(br->pCond);
+          putBool(br->bFloat);
+          putSNum(br->size);
+        }
+      else if (s->kind == STMT_CASE)
+        {
+          SWITCH_INFO* si = ((CaseStatement*)s)->pSwitchInfo;
+          putBool(si != NULL);
+          if (si)
+            {
+              putExp(si->pSwitchVar);
+              putByte(si->chForm);
+              putSNum(si->iLower);
+              putSNum(si->iUpper);
+              putSNum(si->iNumTable);
+              putSNum(si->iOffset);
+              if (si->chForm == 'F')
+                {
+                  for (int i=0; i < si->iNumTable; i++)
+                    putSNum(si->pValues[i]);
+                }
+              else
+                putNum(si->uTable);
+            }
+        }
+      else if (s->kind == STMT_CALL)
+        {
+          CallStatement* c = (CallStatement*)s;
+          putBool(c->returnAfterCall);
+          putStmtList(c->arguments);
+          putStmtList(c->defines);
+          putProc(c->procDest);
+          putSignature(c->signature);
+          putBool(c->useCol.initialised);
+          putNum(c->useCol.locs.size());
+          for (LocationSet::iterator it = c->useCol.locs.begin(); it != c->useCol.locs.end(); ++it)
+            putExp(*it);
+          putDefCollector(c->defCol);
+          putStmt(c->calleeReturn);
+        }
+      break;
+    }
+    case STMT_RET:
+    {
+      ReturnStatement* r = (ReturnStatement*)s;
+      putNum(r->retAddr);
+      putDefCollector(r->col);
+      putStmtList(r->modifieds);
+      putStmtList(r->returns);
+      break;
+    }
+    case STMT_JUNCTION:
+      break;
+    }
+}
+
+
+void ProgSnapshot::putStmtList(StatementList& sl)
+{
+  putNum(sl.size());
+  for (StatementList::iterator it = sl.begin(); it != sl.end(); ++it)
+    putStmt(*it);
+}
+
+void ProgSnapshot::putBasicBlock(BasicBlock* bb)
+{
+  putNum(bb->m_nodeType);
+  putSNum(bb->m_iLabelNum);
+  putString(bb->m_labelStr);
+  putBool(bb->m_labelneeded);
+  putBool(bb->m_bIncomplete);
+  putBool(bb->m_bJumpReqd);
+  putBool(bb->m_iTraversed);
+  putSNum(bb->m_DFTfirst);
+  putSNum(bb->m_DFTlast);
+  putSNum(bb->m_DFTrevfirst);
+  putSNum(bb->m_DFTrevlast);
+  putNum(bb->m_structType);
+  putNum(bb->m_loopCondType);
+  putBB(bb->m_loopHead);
+  putBB(bb->m_caseHead);
+  putBB(bb->m_condFollow);
+  putBB(bb->m_loopFollow);
+  putBB(bb->m_latchNode);
+  putSNum(bb->ord);
+  putSNum(bb->revOrd);
+  putSNum(bb->inEdgesVisited);
+  putSNum(bb->numForwardInEdges);
+  putSNum(bb->loopStamps[0]);
+  putSNum(bb->loopStamps[1]);
+  putSNum(bb->revLoopStamps[0]);
+  putSNum(bb->revLoopStamps[1]);
+  putNum(bb->traversed);
+  putBool(bb->hllLabel);
+  putBool(bb->labelStr != NULL);
+  if (bb->labelStr)
+    putString(bb->labelStr);
+  putSNum(bb->indentLevel);
+  putBB(bb->immPDom);
+  putBB(bb->loopHead);
+  putBB(bb->caseHead);
+  putBB(bb->condFollow);
+  putBB(bb->loopFollow);
+  putBB(bb->latchNode);
+  putNum(bb->sType);
+  putNum(bb->usType);
+  putNum(bb->lType);
+  putNum(bb->cType);
+  putSNum(bb->m_iNumInEdges);
+  putNum(bb->m_InEdges.size());
+  for (unsigned i=0; i < bb->m_InEdges.size(); i++)
+    putBB(bb->m_InEdges[i]);
+  putSNum(bb->m_iNumOutEdges);
+  putNum(bb->m_OutEdges.size());
+  for (unsigned i=0; i < bb->m_OutEdges.size(); i++)
+    putBB(bb->m_OutEdges[i]);
+  putNum(bb->liveIn.size());
+  for (LocationSet::iterator it = bb->liveIn.begin(); it != bb->liveIn.end(); ++it)
+    putExp(*it);
+  putBool(bb->m_pRtls != NULL);
+  if (bb->m_pRtls)
+    {
+      putNum(bb->m_pRtls->size());
+      for (std::list<RTL*>::iterator it = bb->m_pRtls->begin(); it != bb->m_pRtls->end(); ++it)
+        {
+          std::map<RTL*, unsigned>::iterator rr = rtlIds.find(*it);
+          putNum(rr == rtlIds.end() ? 0 : rr->second);
+        }
+    }
+  putBool(bb->overlappedRegProcessingDone);
+}
+
+// Give s (and the statements that it owns, which are not in any RTL) the next numbers of proc procNum
+void ProgSnapshot::numberStatement(Statement* s, unsigned procNum, std::vector<Statement*>& stmts)
+{
+  if (s == NULL || stmtIds.find(s) != stmtIds.end())
+    return;
+  stmts.push_back(s);
+  stmtIds[s] = std::pair<unsigned, unsigned>(procNum, stmts.size());
+  StatementList::iterator ss;
+  AssignSet::iterator aa;
+  if (s->kind == STMT_CALL)
+    {
+      CallStatement* c = (CallStatement*)s;
+      for (ss = c->arguments.begin(); ss != c->arguments.end(); ++ss)
+        numberStatement(*ss, procNum, stmts);
+      for (ss = c->defines.begin(); ss != c->defines.end(); ++ss)
+        numberStatement(*ss, procNum, stmts);
+      for (aa = c->defCol.defs.begin(); aa != c->defCol.defs.end(); ++aa)
+        numberStatement(*aa, procNum, stmts);
+    }
+  else if (s->kind == STMT_RET)
+    {
+      ReturnStatement* r = (ReturnStatement*)s;
+      for (ss = r->modifieds.begin(); ss != r->modifieds.end(); ++ss)
+        numberStatement(*ss, procNum, stmts);
+      for (ss = r->returns.begin(); ss != r->returns.end(); ++ss)
+        numberStatement(*ss, procNum, stmts);
+      for (aa = r->col.defs.begin(); aa != r->col.defs.end(); ++aa)
+        numberStatement(*aa, procNum, stmts);
+    }
+}
+
+void ProgSnapshot::numberStatements(UserProc* proc, std::vector<Statement*>& stmts)
+{
+  unsigned procNum = procIds[proc];
+  Cfg* cfg = proc->cfg;
+  for (std::list<PBB>::iterator bb = cfg->m_listBB.begin(); bb != cfg->m_listBB.end(); ++bb)
+    {
+      std::list<RTL*>* rtls = (*bb)->m_pRtls;
+      if (rtls == NULL)
+        continue;
+      for (std::list<RTL*>::iterator rr = rtls->begin(); rr != rtls->end(); ++rr)
+        for (std::list<Statement*>::iterator ss = (*rr)->stmtList.begin(); ss != (*rr)->stmtList.end(); ++ss)
+          numberStatement(*ss, procNum, stmts);
+    }
+  for (StatementList::iterator pp = proc->parameters.begin(); pp != proc->parameters.end(); ++pp)
+    numberStatement(*pp, procNum, stmts);
+  std::map<Exp*, Statement*, lessExpStar>::iterator ii;
+  for (ii = cfg->implicitMap.begin(); ii != cfg->implicitMap.end(); ++ii)
+    numberStatement(ii->second, procNum, stmts);
+  numberStatement(proc->theReturnStatement, procNum, stmts);
+}
+
+void ProgSnapshot::putProcHeader(Proc* p)
+{
+  putNum(p->address);
+  putNum(p->m_firstCallerAddr);
+  putProc(p->m_firstCaller);
+  putCluster(p->cluster);
+  putSignature(p->signature);
+  putNum(p->provenTrue.size());
+  for (std::map<Exp*, Exp*, lessExpStar>::iterator it = p->provenTrue.begin(); it != p->provenTrue.end(); ++it)
+    {
+      putExp(it->first);
+      putExp(it->second);
+    }
+  putNum(p->callerSet.size());
+  for (std::set<CallStatement*>::iterator cc = p->callerSet.begin(); cc != p->callerSet.end(); ++cc)
+    putStmt(*cc);
+  if (!p->isLib())
+    putNum(((UserProc*)p)->status);
+}
+
+void ProgSnapshot::putProcBody(UserProc* proc, std::vector<Statement*>& stmts)
+{
+  Cfg* cfg = proc->cfg;
+  bbIds.clear();
+  rtlIds.clear();
+  std::vector<RTL*> rtls;
+  std::list<PBB>::iterator bb;
+  for (bb = cfg->m_listBB.begin(); bb != cfg->m_listBB.end(); ++bb)
+    {
+      unsigned n = bbIds.size() + 1;
+      bbIds[*bb] = n;
+      if ((*bb)->m_pRtls == NULL)
+        continue;
+      for (std::list<RTL*>::iterator rr = (*bb)->m_pRtls->begin(); rr != (*bb)->m_pRtls->end(); ++rr)
+        {
+          rtls.push_back(*rr);
+          rtlIds[*rr] = rtls.size();
+        }
+    }
+
+  // The kinds first, so that all the statements can be created before any are read (see makeStatements())
+  putNum(stmts.size());
+  unsigned i;
+  for (i=0; i < stmts.size(); i++)
+    putByte(stmts[i]->kind);
+  putNum(cfg->m_listBB.size());
+  putNum(rtls.size());
+  for (i=0; i < stmts.size(); i++)
+    putStatement(stmts[i]);
+  for (i=0; i < rtls.size(); i++)
+    {
+      putNum(rtls[i]->nativeAddr);
+      putNum(rtls[i]->stmtList.size());
+      for (std::list<Statement*>::iterator ss = rtls[i]->stmtList.begin(); ss != rtls[i]->stmtList.end(); ++ss)
+        putStmt(*ss);
+    }
+  for (bb = cfg->m_listBB.begin(); bb != cfg->m_listBB.end(); ++bb)
+    putBasicBlock(*bb);
+
+  // The Cfg
+  putBool(cfg->m_bWellFormed);
+  putBool(cfg->structured);
+  putSNum(cfg->lastLabel);
+  putBool(cfg->bImplicitsDone);
+  putBB(cfg->entryBB);
+  putBB(cfg->exitBB);
+  putNum(cfg->Ordering.size());
+  for (i=0; i < cfg->Ordering.size(); i++)
+    putBB(cfg->Ordering[i]);
+  putNum(cfg->revOrdering.size());
+  for (i=0; i < cfg->revOrdering.size(); i++)
+    putBB(cfg->revOrdering[i]);
+  putNum(cfg->m_mapBB.size());
+  for (MAPBB::iterator mm = cfg->m_mapBB.begin(); mm != cfg->m_mapBB.end(); ++mm)
+    {
+      putNum(mm->first);
+      putBB(mm->second);
+    }
+  putNum(cfg->callSites.size());
+  for (std::set<CallStatement*>::iterator cc = cfg->callSites.begin(); cc != cfg->callSites.end(); ++cc)
+    putStmt(*cc);
+  putNum(cfg->implicitMap.size());
+  std::map<Exp*, Statement*, lessExpStar>::iterator ii;
+  for (ii = cfg->implicitMap.begin(); ii != cfg->implicitMap.end(); ++ii)
+    {
+      putExp(ii->first);
+      putStmt(ii->second);
+    }
+
+  // The rest of the UserProc
+  putNum(proc->locals.size());
+  for (std::map<std::string, Type*>::iterator ll = proc->locals.begin(); ll != proc->locals.end(); ++ll)
+    {
+      putString(ll->first);
+      putType(ll->second);
+    }
+  putSNum(proc->nextLocal);
+  putSNum(proc->nextParam);
+  putNum(proc->symbolMap.size());
+  for (UserProc::SymbolMap::iterator sm = proc->symbolMap.begin(); sm != proc->symbolMap.end(); ++sm)
+    {
+      putExp(sm->first);
+      putExp(sm->second);
+    }
+  putDataIntervals(proc->localTable);
+  putNum(proc->calleeList.size());
+  for (std::list<Proc*>::iterator pp = proc->calleeList.begin(); pp != proc->calleeList.end(); ++pp)
+    putProc(*pp);
+  putBool(proc->col.initialised);
+  putNum(proc->col.locs.size());
+  LocationSet::iterator ls;
+  for (ls = proc->col.locs.begin(); ls != proc->col.locs.end(); ++ls)
+    putExp(*ls);
+  putStmtList(proc->parameters);
+  putNum(proc->addressEscapedVars.size());
+  for (ls = proc->addressEscapedVars.begin(); ls != proc->addressEscapedVars.end(); ++ls)
+    putExp(*ls);
+  putSNum(proc->stmtNumber);
+  putStmt(proc->theReturnStatement);
+  putNum(proc->stackMap.size());
+  for (std::map<int, Type*>::iterator st = proc->stackMap.begin(); st != proc->stackMap.end(); ++st)
+    {
+      putSNum(st->first);
+      putType(st->second);
+    }
+  putSNum(proc->DFGcount);
+}
+
+// The string pool, which is the last section of snapshots and dictionaries
+// The pool: the strings, then the table of types, with the offset of the definition of each
+void ProgSnapshot::putPool()
+{
+  // The types first, since their definitions can add strings, and more types
+  std::vector<unsigned char>* poolSect = out;
+  std::vector<unsigned char> defs;
+  std::vector<unsigned> offsets;
+  out = &defs;
+  for (unsigned i=0; i < typeList.size(); i++)
+    {
+      offsets.push_back(defs.size());
+      putTypeDef(typeList[i]);
+    }
+  out = poolSect;
+
+  putNum(strings.size());
+  for (unsigned i=0; i < strings.size(); i++)
+    {
+      putNum(strings[i].size());
+      out->insert(out->end(), strings[i].begin(), strings[i].end());
+    }
+  putNum(offsets.size());
+  for (unsigned i=0; i < offsets.size(); i++)
+    putNum(offsets[i]);
+  out->insert(out->end(), defs.begin(), defs.end());
+}
+
+void ProgSnapshot::putStrList(std::list<std::string>& sl)
+{
+  putNum(sl.size());
+  for (std::list<std::string>::iterator it = sl.begin(); it != sl.end(); ++it)
+    putString(*it);
+}
+
+// A statement that is not in any proc (i.e. a template of the SSL dictionary), written out in full with its kind
+void ProgSnapshot::putWholeStmt(Statement* s)
+{
+  putBool(s != NULL);
+  if (s)
+    {
+      putByte(s->kind);
+      putStatement(s);
+    }
+}
+
+void ProgSnapshot::putRTL(RTL* rtl)
+{
+  putNum(rtl->nativeAddr);
+  putNum(rtl->stmtList.size());
+  for (std::list<Statement*>::iterator it = rtl->stmtList.begin(); it != rtl->stmtList.end(); ++it)
+    putWholeStmt(*it);
+}
+
+void ProgSnapshot::putRegister(Register& reg)
+{
+  // The address is only used by the interpreter, and is never set from the SSL file
+  putString(reg.g_name());
+  putSNum(reg.g_size());
+  putBool(reg.isFloat());
+  putSNum(reg.g_mappedIndex());
+  putSNum(reg.g_mappedOffset());
+}
+
+void ProgSnapshot::putParamEntry(ParamEntry& pe)
+{
+  putStrList(pe.params);
+  putStrList(pe.funcParams);
+  putWholeStmt(pe.asgn);
+  putBool(pe.lhs);
+  putNum(pe.kind);
+  putType(pe.type);
+  putType(pe.regType);
+  putNum(pe.regIdx.size());
+  for (std::set<int>::iterator it = pe.regIdx.begin(); it != pe.regIdx.end(); ++it)
+    putSNum(*it);
+  putSNum(pe.mark);
+}
+
+/*==============================================================================
+ * FUNCTION:		ProgSnapshot::saveDict
+ * OVERVIEW:		Save an SSL dictionary to a file, so that the SSL file need not be parsed again while it is
+ *					unchanged. The flag functions are not saved, since they are only used while parsing
+ * PARAMETERS:		dict - the dictionary, as left by RTLInstDict::readSSLFile()
+ *					hash - the hash of the SSL file that dict was read from (see hashFile())
+ *					fname - the name of the file to save to
+ * RETURNS:			False if the file could not be written (e.g. the directory is read only)
+ *============================================================================*/
+bool ProgSnapshot::saveDict(RTLInstDict& dict, unsigned hash, const char* fname)
+{
+  stringIds.clear();
+  strings.clear();
+  procIds.clear();
+  bbIds.clear();
+  rtlIds.clear();
+  stmtIds.clear();
+  typeIds.clear();
+  typeList.clear();
+
+  std::vector<unsigned char> dictSect;
+  out = &dictSect;
+  putNum(dict.RegMap.size());
+  for (std::map<std::string, int>::iterator rr = dict.RegMap.begin(); rr != dict.RegMap.end(); ++rr)
+    {
+      putString(rr->first);
+      putSNum(rr->second);
+    }
+  putNum(dict.DetRegMap.size());
+  for (std::map<int, Register>::iterator dr = dict.DetRegMap.begin(); dr != dict.DetRegMap.end(); ++dr)
+    {
+      putSNum(dr->first);
+      putRegister(dr->second);
+    }
+  putNum(dict.SpecialRegMap.size());
+  for (std::map<std::string, Register>::iterator sr = dict.SpecialRegMap.begin(); sr != dict.SpecialRegMap.end(); ++sr)
+    {
+      putString(sr->first);
+      putRegister(sr->second);
+    }
+  putNum(dict.ParamSet.size());
+  for (std::set<std::string>::iterator ps = dict.ParamSet.begin(); ps != dict.ParamSet.end(); ++ps)
+    putString(*ps);
+  putNum(dict.DetParamMap.size());
+  for (std::map<std::string, ParamEntry>::iterator pp = dict.DetParamMap.begin(); pp != dict.DetParamMap.end(); ++pp)
+    {
+      putString(pp->first);
+      putParamEntry(pp->second);
+    }
+  putNum(dict.fastMap.size());
+  for (std::map<std::string, std::string>::iterator fm = dict.fastMap.begin(); fm != dict.fastMap.end(); ++fm)
+    {
+      putString(fm->first);
+      putString(fm->second);
+    }
+  putBool(dict.bigEndian);
+  putNum(dict.idict.size());
+  for (std::map<std::string, TableEntry>::iterator ii = dict.idict.begin(); ii != dict.idict.end(); ++ii)
+    {
+      putString(ii->first);
+      putStrList(ii->second.params);
+      putRTL(&ii->second.rtl);
+      putSNum(ii->second.flags);
+    }
+  putBool(dict.fetchExecCycle != NULL);
+  if (dict.fetchExecCycle)
+    putRTL(dict.fetchExecCycle);
+
+  std::vector<unsigned char> poolSect;
+  out = &poolSect;
+  putPool();
+  out = NULL;
+
+  std::vector<unsigned char> header(dictMagic, dictMagic + SNAP_MAGIC_LEN);
+  put32(header, SNAPSHOT_VERSION);
+  put32(header, SSLDICT_VERSION);
+  put32(header, hash);
+  put32(header, buildFingerprint());
+  put32(header, DICT_HEADER_LEN);
+  put32(header, DICT_HEADER_LEN + dictSect.size());
+
+  // Write a temporary file and rename it, so that a dictionary being written (e.g. by another batch worker) is never
+  // read
+  char suffix[32];
+  sprintf(suffix, ".%d", (int)getpid());
+  std::string tmpName = std::string(fname) + suffix;
+  FILE* f = fopen(tmpName.c_str(), "wb");
+  if (f == NULL)
+    return false;
+  bool ok = fwrite(&header[0], 1, header.size(), f) == header.size();
+  ok = ok && fwrite(&dictSect[0], 1, dictSect.size(), f) == dictSect.size();
+  ok = ok && fwrite(&poolSect[0], 1, poolSect.size(), f) == poolSect.size();
+  ok = (fclose(f) == 0) && ok;
+#if defined(_WIN32)
+  remove(fname);
+#endif
+  if (!ok || rename(tmpName.c_str(), fname) != 0)
+    {
+      remove(tmpName.c_str());
+      return false;
+    }
+  return true;
+}
+
+/*==============================================================================
+ * FUNCTION:		ProgSnapshot::save
+ * OVERVIEW:		Save the state of a Prog to a file
+ * PARAMETERS:		prog - the program to save
+ *					fname - the name of the file to save to
+ * RETURNS:			False if the file could not be written
+ *============================================================================*/
+bool ProgSnapshot::save(Prog* prog, const char* fname)
+{
+  // Procedures that were loaded lazily must be complete before they can be written
+  prog->loadAllProcBodies();
+  stringIds.clear();
+  strings.clear();
+  procIds.clear();
+  clusterIds.clear();
+  stmtIds.clear();
+  typeIds.clear();
+  typeList.clear();
+  danglingRefs = 0;
+
+  std::list<Proc*>::iterator pp;
+  for (pp = prog->m_procs.begin(); pp != prog->m_procs.end(); ++pp)
+    {
+      unsigned n = procIds.size() + 1;
+      procIds[*pp] = n;
+    }
+  // Clusters, in pre-order, so that parents are read before their children
+  std::vector<Cluster*> clusters;
+  clusters.push_back(prog->m_rootCluster);
+  for (unsigned i=0; i < clusters.size(); i++)
+    {
+      clusterIds[clusters[i]] = i+1;
+      for (unsigned j=0; j < clusters[i]->children.size(); j++)
+        clusters.push_back(clusters[i]->children[j]);
+    }
+
+  // All statements have to be numbered before any are written, since a statement can refer to any other
+  std::vector<std::vector<Statement*> > stmts(procIds.size());
+  unsigned n = 0;
+  for (pp = prog->m_procs.begin(); pp != prog->m_procs.end(); ++pp, ++n)
+    if (!(*pp)->isLib())
+      numberStatements((UserProc*)*pp, stmts[n]);
+
+  std::vector<unsigned char> bodies;
+  std::vector<std::pair<unsigned, unsigned> > bodyPos;		// Offset and length of each body
+  out = &bodies;
+  n = 0;
+  for (pp = prog->m_procs.begin(); pp != prog->m_procs.end(); ++pp, ++n)
+    {
+      unsigned start = bodies.size();
+      if (!(*pp)->isLib())
+        putProcBody((UserProc*)*pp, stmts[n]);
+      bodyPos.push_back(std::pair<unsigned, unsigned>(start, bodies.size() - start));
+    }
+
+  std::vector<unsigned char> progSect;
+  out = &progSect;
+  putString(prog->m_name);
+  putString(prog->m_path);
+  putSNum(prog->m_iNumberedProc);
+  // The directory first, so that the procs exist before anything (e.g. the signature of a FuncType) refers to them
+  putNum(prog->m_procs.size());
+  n = 0;
+  for (pp = prog->m_procs.begin(); pp != prog->m_procs.end(); ++pp, ++n)
+    {
+      putBool(!(*pp)->isLib());
+      putNum(bodyPos[n].first);
+      putNum(bodyPos[n].second);
+    }
+  putNum(clusters.size());
+  for (unsigned i=0; i < clusters.size(); i++)
+    {
+      Cluster* c = clusters[i];
+      Class* cl = dynamic_cast<Class*>(c);
+      putByte(cl ? SC_CLASS : dynamic_cast<Module*>(c) ? SC_MODULE : SC_CLUSTER);
+      putString(c->name);
+      putCluster(c->parent);
+      if (cl)
+        putType(cl->type);
+    }
+  putNum(prog->globals.size());
+  for (std::set<Global*>::iterator gg = prog->globals.begin(); gg != prog->globals.end(); ++gg)
+    {
+      putString((*gg)->nam);
+      putNum((*gg)->uaddr);
+      putType((*gg)->type);
+    }
+  putDataIntervals(prog->globalMap);
+  for (pp = prog->m_procs.begin(); pp != prog->m_procs.end(); ++pp)
+    putProcHeader(*pp);
+
+  std::vector<unsigned char> poolSect;
+  out = &poolSect;
+  putPool();
+  out = NULL;
+
+  std::vector<unsigned char> header(snapMagic, snapMagic + SNAP_MAGIC_LEN);
+  put32(header, SNAPSHOT_VERSION);
+  put32(header, SNAP_HEADER_LEN);
+  put32(header, SNAP_HEADER_LEN + progSect.size());
+  put32(header, SNAP_HEADER_LEN + progSect.size() + bodies.size());
+
+  FILE* f = fopen(fname, "wb");
+  if (f == NULL)
+    {
+      std::cerr << "cannot open " << fname << " for writing\n";
+      return false;
+    }
+  bool ok = fwrite(&header[0], 1, header.size(), f) == header.size();
+  ok = ok && fwrite(&progSect[0], 1, progSect.size(), f) == progSect.size();
+  if (bodies.size())
+    ok = ok && fwrite(&bodies[0], 1, bodies.size(), f) == bodies.size();
+  ok = ok && fwrite(&poolSect[0], 1, poolSect.size(), f) == poolSect.size();
+  ok = (fclose(f) == 0) && ok;
+  if (!ok)
+    {
+      std::cerr << "error writing " << fname << "\n";
+      return false;
+    }
+  LOG << "saved " << (int)procIds.size() << " procedures to " << fname << " (" <<
+      (int)(header.size() + progSect.size() + bodies.size() + poolSect.size()) << " bytes)\n";
+  if (danglingRefs)
+    LOG << "warning: " << (int)danglingRefs << " references to statements not in any procedure were saved as "
+        "NULL\n";
+  return true;
+}
+
+//	//	//	//	//	//	//	//
+//							//
+//		R e a d i n g		//
+//							//
+//	//	//	//	//	//	//	//
+
+bool ProgSnapshot::map(const char* fname)
+{
+  unmap();
+#if !defined(_WIN32)
+  int fd = open(fname, O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+      void* p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED)
+        {
+          close(fd);
+          base = (const unsigned char*)p;
+          size = st.st_size;
+          mapped = true;
+          return true;
+        }
+    }
+  close(fd);
+#endif
+  // Can't map it; read it into memory instead
+  FILE* f = fopen(fname, "rb");
+  if (f == NULL)
+    return false;
+  fseek(f, 0, SEEK_END);
+  long len = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  if (len <= 0)
+    {
+      fclose(f);
+      return false;
+    }
+  unsigned char* buf = new unsigned char[len];
+  if (fread(buf, 1, len, f) != (size_t)len)
+    {
+      delete [] buf;
+      fclose(f);
+      return false;
+    }
+  fclose(f);
+  base = buf;
+  size = len;
+  mapped = false;
+  return true;
+}
+
+void ProgSnapshot::unmap()
+{
+  if (base == NULL)
+    return;
+#if !defined(_WIN32)
+  if (mapped)
+    munmap((void*)base, size);
+  else
+#endif
+    delete [] base;
+  base = NULL;
+  size = 0;
+}
+
+unsigned ProgSnapshot::getNum()
+{
+  unsigned n = 0;
+  for (int shift = 0; shift < 35; shift += 7)
+    {
+      unsigned char b = getByte();
+      n |= (unsigned)(b & 0x7F) << shift;
+      if ((b & 0x80) == 0)
+        return n;
+    }
+  bad = true;
+  return 0;
+}
+
+unsigned ProgSnapshot::getCount()
+{
+  unsigned n = getNum();
+  // Every item takes at least one byte
+  if (n > (unsigned)(inEnd - in))
+    {
+      bad = true;
+      return 0;
+    }
+  return n;
+}
+
+int ProgSnapshot::getSNum()
+{
+  unsigned n = getNum();
+  return (int)(n >> 1) ^ -(int)(n & 1);
+}
+
+QWord ProgSnapshot::getQWord()
+{
+  QWord n = 0;
+  for (int shift = 0; shift < 70; shift += 7)
+    {
+      unsigned char b = getByte();
+      n |= (QWord)(b & 0x7F) << shift;
+      if ((b & 0x80) == 0)
+        return n;
+    }
+  bad = true;
+  return 0;
+}
+
+double ProgSnapshot::getDouble()
+{
+  QWord n = getQWord();
+  double d;
+  memcpy(&d, &n, sizeof(d));
+  return d;
+}
+
+const std::string& ProgSnapshot::getString()
+{
+  static std::string empty;
+  unsigned n = getNum();
+  if (n >= pool.size())
+    {
+      bad = true;
+      return empty;
+    }
+  return pool[n];
+}
+
+Proc* ProgSnapshot::getProc()
+{
+  unsigned n = getNum();
+  if (n == 0)
+    return NULL;
+  if (n > procs.size())
+    {
+      bad = true;
+      return NULL;
+    }
+  return procs[n-1];
+}
+
+Cluster* ProgSnapshot::getCluster()
+{
+  unsigned n = getNum();
+  if (n == 0)
+    return NULL;
+  if (n > clusters.size())
+    {
+      bad = true;
+      return NULL;
+    }
+  return clusters[n-1];
+}
+
+BasicBlock* ProgSnapshot::getBB()
+{
+  unsigned n = getNum();
+  if (n == 0)
+    return NULL;
+  if (n > bbs.size())
+    {
+      bad = true;
+      return NULL;
+    }
+  return bbs[n-1];
+}
+
+// Create (but don't read) all the statements of proc procNum, if not done already. Only the table of kinds at the
+// start of its body is read
+void ProgSnapshot::makeStatements(unsigned procNum)
+{
+  ProcEntry& pe = directory[procNum-1];
+  if (!pe.stmts.empty() || pe.length == 0)
+    return;
+  const unsigned char* saveIn = in;
+  const unsigned char* saveEnd = inEnd;
+  in = base + pe.offset;
+  inEnd = in + pe.length;
+  unsigned n = getCount();
+  pe.stmts.reserve(n);
+  for (unsigned i=0; i < n && !bad; i++)
+    {
+      int kind = getByte();
+      Statement* s = newStatement(kind);
+      if (s == NULL)
+        {
+          bad = true;
+          break;
+        }
+      s->kind = (STMT_KIND)kind;
+      s->proc = (UserProc*)procs[procNum-1];		// So that the proc can be found (and loaded) from a shell
+      pe.stmts.push_back(s);
+    }
+  in = saveIn;
+  inEnd = saveEnd;
+}
+
+Statement* ProgSnapshot::getStmt()
+{
+  unsigned p = getNum();
+  if (p == 0)
+    return NULL;
+  unsigned n = getNum();
+  if (p > procs.size())
+    {
+      bad = true;
+      return NULL;
+    }
+  makeStatements(p);
+  std::vector<Statement*>& stmts = directory[p-1].stmts;
+  if (n == 0 || n > stmts.size())
+    {
+      bad = true;
+      return NULL;
+    }
+  return stmts[n-1];
+}
+
+void ProgSnapshot::getStmtList(StatementList& sl)
+{
+  unsigned n = getCount();
+  for (unsigned i=0; i < n; i++)
+    {
+      Statement* s = getStmt();
+      if (s)
+        sl.append(s);
+    }
+}
+
+Type* ProgSnapshot::getType()
+{
+  unsigned id = getNum();
+  if (id == 0)
+    return NULL;
+  if (id > types.size())
+    {
+      bad = true;
+      return NULL;
+    }
+  if (types[id-1] == NULL)
+    {
+      // Read its definition from the pool, then carry on from here
+      const unsigned char* savedIn = in;
+      const unsigned char* savedEnd = inEnd;
+      in = typeDefs + typeOffsets[id-1];
+      inEnd = base + size;
+      getTypeDef(id-1);
+      in = savedIn;
+      inEnd = savedEnd;
+    }
+  return types[id-1];
+}
+
+// Read the definition of type i of the pool. The type is entered in types before the types that it refers to are read,
+// so that they can refer back to it
+void ProgSnapshot::getTypeDef(unsigned i)
+{
+  unsigned char tag = getByte();
+  switch (tag-1)
+    {
+    case eVoid:
+      types[i] = new VoidType();
+      break;
+    case eBoolean:
+      types[i] = new BooleanType();
+      break;
+    case eChar:
+      types[i] = new CharType();
+      break;
+    case eFunc:
+    {
+      FuncType* f = new FuncType(NULL);
+      types[i] = f;
+      f->signature = getSignature();
+      break;
+    }
+    case eInteger:
+    {
+      unsigned sz = getNum();
+      types[i] = new IntegerType(sz, getSNum());
+      break;
+    }
+    case eFloat:
+      types[i] = new FloatType(getNum());
+      break;
+    case ePointer:
+    {
+      PointerType* p = new PointerType(new VoidType());
+      types[i] = p;
+      Type* t = getType();
+      if (t && t != p)
+        p->points_to = t;
+      break;
+    }
+    case eArray:
+    {
+      ArrayType* a = new ArrayType(NULL, 0);
+      types[i] = a;
+      a->base_type = getType();
+      a->length = getNum();
+      break;
+    }
+    case eNamed:
+      types[i] = new NamedType(getString().c_str());
+      break;
+    case eCompound:
+    {
+      CompoundType* c = new CompoundType(getBool());
+      types[i] = c;
+      c->nextGenericMemberNum = getSNum();
+      unsigned n = getCount();
+      for (unsigned j=0; j < n && !bad; j++)
+        {
+          c->names.push_back(getString());
+          c->types.push_back(getType());
+        }
+      break;
+    }
+    case eUnion:
+    {
+      UnionType* u = new UnionType();
+      types[i] = u;
+      unsigned n = getCount();
+      for (unsigned j=0; j < n && !bad; j++)
+        {
+          UnionElement ue;
+          ue.name = getString();
+          ue.type = getType();
+          u->li.push_back(ue);
+        }
+      break;
+    }
+    case eSize:
+      types[i] = new SizeType(getNum());
+      break;
+    case eUpper:
+    {
+      UpperType* t = new UpperType(NULL);
+      types[i] = t;
+      t->setBaseType(getType());
+      break;
+    }
+    case eLower:
+    {
+      LowerType* t = new LowerType(NULL);
+      types[i] = t;
+      t->setBaseType(getType());
+      break;
+    }
+    default:
+      bad = true;
+      break;
+    }
+}
+
+Exp* ProgSnapshot::getExp()
+{
+  unsigned char tag = getByte();
+  if (tag == SE_NULL)
+    return NULL;
+  unsigned op = getNum();
+  if (op >= opNumOf)
+    {
+      bad = true;
+      return NULL;
+    }
+  OPER o = (OPER)op;
+  switch (tag)
+    {
+    case SE_TYPEVAL:
+    {
+      TypeVal* t = new TypeVal(getType());
+      t->op = o;
+      return t;
+    }
+    case SE_TERMINAL:
+      return new Terminal(o);
+    case SE_CONST:
+    {
+      Const* c = new Const(0);
+      c->op = o;
+      c->conscript = getSNum();
+      c->type = getType();
+      switch (o)
+        {
+        case opIntConst:
+          c->u.i = getSNum();
+          break;
+        case opFltConst:
+          c->u.d = getDouble();
+          break;
+        case opStrConst:
+          c->u.p = strdup(getString().c_str());
+          break;
+        case opFuncConst:
+          c->u.pp = getProc();
+          break;
+        default:
+          c->u.ll = getQWord();
+          break;
+        }
+      return c;
+    }
+    case SE_LOCATION:
+    {
+      Location* l = new Location(o);
+      Proc* p = getProc();
+      if (p && p->isLib())
+        bad = true;
+      else
+        l->proc = (UserProc*)p;
+      l->subExp1 = getExp();
+      return l;
+    }
+    case SE_REFEXP:
+    {
+      RefExp* r = new RefExp();
+      r->def = getStmt();
+      r->subExp1 = getExp();
+      return r;
+    }
+    case SE_FLAGDEF:
+    {
+      unsigned n = getNum();
+      RTL* rtl = NULL;
+      if (n > rtls.size())
+        bad = true;
+      else if (n)
+        rtl = rtls[n-1];
+      Exp* params = getExp();
+      if (params == NULL)
+        {
+          bad = true;
+          return NULL;
+        }
+      return new FlagDef(params, rtl);
+    }
+    case SE_TYPEDEXP:
+    {
+      TypedExp* t = new TypedExp();
+      t->type = getType();
+      t->subExp1 = getExp();
+      return t;
+    }
+    case SE_TERNARY:
+    {
+      Ternary* t = new Ternary(o);
+      t->subExp1 = getExp();
+      t->subExp2 = getExp();
+      t->subExp3 = getExp();
+      return t;
+    }
+    case SE_BINARY:
+    {
+      Binary* b = new Binary(o);
+      b->subExp1 = getExp();
+      b->subExp2 = getExp();
+      return b;
+    }
+    case SE_UNARY:
+    {
+      Unary* u = new Unary(o);
+      u->subExp1 = getExp();
+      return u;
+    }
+    default:
+      bad = true;
+      return NULL;
+    }
+}
+
+Signature* ProgSnapshot::getSignature()
+{
+  unsigned char kind = getByte();
+  if (kind == SS_NULL)
+    return NULL;
+  int sp = 0;
+  unsigned plat = PLAT_GENERIC, conv = CONV_NONE;
+  if (kind == SS_CUSTOM)
+    sp = getSNum();
+  else if (kind == SS_PLATFORM)
+    {
+      plat = getNum();
+      conv = getNum();
+      if (!(plat == PLAT_PENTIUM || plat == PLAT_SPARC || plat == PLAT_PPC || plat == PLAT_ST20) || conv > CONV_NONE
+          || (plat == PLAT_SPARC && conv != CONV_C))
+        {
+          bad = true;
+          kind = SS_GENERIC;
+        }
+    }
+  else if (kind != SS_GENERIC)
+    {
+      bad = true;
+      return NULL;
+    }
+  const char* name = getString().c_str();
+  Signature* sig;
+  if (kind == SS_CUSTOM)
+    {
+      CustomSignature* cs = new CustomSignature(name);
+      cs->setSP(sp);
+      sig = cs;
+    }
+  else if (kind == SS_PLATFORM)
+    sig = Signature::instantiate((platform)plat, (callconv)conv, name);
+  else
+    sig = new Signature(name);
+  // The constructors may have added parameters and returns; the saved ones replace them
+  sig->params.clear();
+  sig->returns.clear();
+  sig->sigFile = getString();
+  sig->ellipsis = getBool();
+  sig->unknown = getBool();
+  sig->forced = getBool();
+  sig->preferedName = getString();
+  unsigned n = getCount();
+  unsigned i;
+  for (i=0; i < n; i++)
+    {
+      const char* pname = getString().c_str();
+      Type* ty = getType();
+      Exp* e = getExp();
+      sig->params.push_back(new Parameter(ty, pname, e, getString().c_str()));
+    }
+  n = getCount();
+  for (i=0; i < n; i++)
+    {
+      Type* ty = getType();
+      sig->returns.push_back(new Return(ty, getExp()));
+    }
+  sig->rettype = getType();
+  sig->preferedReturn = getType();
+  n = getCount();
+  for (i=0; i < n; i++)
+    sig->preferedParams.push_back(getSNum());
+  return sig;
+}
+
+void ProgSnapshot::getDefCollector(DefCollector& col)
+{
+  col.initialised = getBool();
+  unsigned n = getCount();
+  for (unsigned i=0; i < n; i++)
+    {
+      Statement* s = getStmt();
+      // The set is ordered by the left hand sides, so the insertion has to wait until the Assign has been read
+      if (s && s->kind == STMT_ASSIGN)
+        pendingDefs.push_back(std::pair<DefCollector*, Assign*>(&col, (Assign*)s));
+    }
+}
+
+void ProgSnapshot::getDataIntervals(DataIntervalMap& dim)
+{
+  unsigned n = getCount();
+  for (unsigned i=0; i < n; i++)
+    {
+      ADDRESS addr = getNum();
+      DataInterval di;
+      di.size = getNum();
+      di.name = getString();
+      di.type = getType();
+      dim.dimap[addr] = di;
+    }
+}
+
+void ProgSnapshot::getStatement(Statement* s)
+{
+  s->number = getSNum();
+  s->dominanceNum = getSNum();
+  s->pbb = getBB();
+  s->parent = getStmt();
+  Proc* p = getProc();
+  if (p && p->isLib())
+    bad = true;
+  else
+    s->proc = (UserProc*)p;
+  switch (s->kind)
+    {
+    case STMT_ASSIGN:
+    {
+      Assign* a = (Assign*)s;
+      a->type = getType();
+      a->lhs = getExp();
+      a->rhs = getExp();
+      a->guard = getExp();
+      break;
+    }
+    case STMT_PHIASSIGN:
+    {
+      PhiAssign* pa = (PhiAssign*)s;
+      pa->type = getType();
+      pa->lhs = getExp();
+      unsigned n = getCount();
+      pa->defVec.resize(n);
+      for (unsigned i=0; i < n; i++)
+        {
+          pa->defVec[i].def = getStmt();
+          pa->defVec[i].e = getExp();
+        }
+      break;
+    }
+    case STMT_IMPASSIGN:
+      ((ImplicitAssign*)s)->type = getType();
+      ((ImplicitAssign*)s)->lhs = getExp();
+      break;
+    case STMT_BOOLASSIGN:
+    {
+      BoolAssign* ba = (BoolAssign*)s;
+      ba->type = getType();
+      ba->lhs = getExp();
+      ba->jtCond = (BRANCH_TYPE)getNum();
+      ba->pCond = getExp();
+      ba->bFloat = getBool();
+      ba->size = getSNum();
+      break;
+    }
+    case STMT_IMPREF:
+      ((ImpRefStatement*)s)->type = getType();
+      ((ImpRefStatement*)s)->addressExp = getExp();
+      break;
+    case STMT_GOTO:
+    case STMT_BRANCH:
+    case STMT_CASE:
+    case STMT_CALL:
+    {
+      GotoStatement* g = (GotoStatement*)s;
+      g->pDest = getExp();
+      g->m_isComputed = getBool();
+      if (s->kind == STMT_BRANCH)
+        {
+          BranchStatement* br = (BranchStatement*)s;
+          br->jtCond = (BRANCH_TYPE)getNum();
+          br->pCond = getExp();
+          br->bFloat = getBool();
+          br->size = getSNum();
+        }
+      else if (s->kind == STMT_CASE)
+        {
+          if (getBool())
+            {
+              SWITCH_INFO* si = new SWITCH_INFO;
+              si->pSwitchVar = getExp();
+              si->chForm = getByte();
+              si->iLower = getSNum();
+              si->iUpper = getSNum();
+              si->iNumTable = getSNum();
+              si->iOffset = getSNum();
+              if (si->chForm == 'F')
+                {
+                  if (si->iNumTable < 0 || (unsigned)si->iNumTable > (unsigned)(inEnd - in))
+                    {
+                      bad = true;
+                      si->iNumTable = 0;
+                    }
+                  si->pValues = new int[si->iNumTable];
+                  for (int i=0; i < si->iNumTable; i++)
+                    si->pValues[i] = getSNum();
+                  si->uTable = 0;
+                }
+              else
+                {
+                  si->uTable = getNum();
+                  si->pValues = NULL;
+                }
+              ((CaseStatement*)s)->pSwitchInfo = si;
+            }
+        }
+      else if (s->kind == STMT_CALL)
+        {
+          CallStatement* c = (CallStatement*)s;
+          c->returnAfterCall = getBool();
+          getStmtList(c->arguments);
+          getStmtList(c->defines);
+          c->procDest = getProc();
+          c->signature = getSignature();
+          c->useCol.initialised = getBool();
+          unsigned n = getCount();
+          for (unsigned i=0; i < n; i++)
+            {
+              Exp* e = getExp();
+              if (e)
+                c->useCol.locs.insert(e);
+            }
+          getDefCollector(c->defCol);
+          Statement* r = getStmt();
+          c->calleeReturn = (r && r->kind == STMT_RET) ? (ReturnStatement*)r : NULL;
+        }
+      break;
+    }
+    case STMT_RET:
+    {
+      ReturnStatement* r = (ReturnStatement*)s;
+      r->retAddr = getNum();
+      getDefCollector(r->col);
+      getStmtList(r->modifieds);
+      getStmtList(r->returns);
+      break;
+    }
+    case STMT_JUNCTION:
+      break;
+    }
+}
+
+void ProgSnapshot::getBasicBlock(BasicBlock* bb)
+{
+  bb->m_nodeType = (BBTYPE)getNum();
+  bb->m_iLabelNum = getSNum();
+  bb->m_labelStr = getString();
+  bb->m_labelneeded = getBool();
+  bb->m_bIncomplete = getBool();
+  bb->m_bJumpReqd = getBool();
+  bb->m_iTraversed = getBool();
+  bb->m_DFTfirst = getSNum();
+  bb->m_DFTlast = getSNum();
+  bb->m_DFTrevfirst = getSNum();
+  bb->m_DFTrevlast = getSNum();
+  bb->m_structType = (SBBTYPE)getNum();
+  bb->m_loopCondType = (SBBTYPE)getNum();
+  bb->m_loopHead = getBB();
+  bb->m_caseHead = getBB();
+  bb->m_condFollow = getBB();
+  bb->m_loopFollow = getBB();
+  bb->m_latchNode = getBB();
+  bb->ord = getSNum();
+  bb->revOrd = getSNum();
+  bb->inEdgesVisited = getSNum();
+  bb->numForwardInEdges = getSNum();
+  bb->loopStamps[0] = getSNum();
+  bb->loopStamps[1] = getSNum();
+  bb->revLoopStamps[0] = getSNum();
+  bb->revLoopStamps[1] = getSNum();
+  bb->traversed = (travType)getNum();
+  bb->hllLabel = getBool();
+  bb->labelStr = getBool() ? strdup(getString().c_str()) : NULL;
+  bb->indentLevel = getSNum();
+  bb->immPDom = getBB();
+  bb->loopHead = getBB();
+  bb->caseHead = getBB();
+  bb->condFollow = getBB();
+  bb->loopFollow = getBB();
+  bb->latchNode = getBB();
+  bb->sType = (structType)getNum();
+  bb->usType = (unstructType)getNum();
+  bb->lType = (loopType)getNum();
+  bb->cType = (condType)getNum();
+  bb->m_iNumInEdges = getSNum();
+  unsigned n = getCount();
+  unsigned i;
+  for (i=0; i < n; i++)
+    bb->m_InEdges.push_back(getBB());
+  bb->m_iNumOutEdges = getSNum();
+  n = getCount();
+  for (i=0; i < n; i++)
+    bb->m_OutEdges.push_back(getBB());
+  n = getCount();
+  for (i=0; i < n; i++)
+    {
+      Exp* e = getExp();
+      if (e)
+        bb->liveIn.insert(e);
+    }
+  if (getBool())
+    {
+      bb->m_pRtls = new std::list<RTL*>;
+      n = getCount();
+      for (i=0; i < n; i++)
+        {
+          unsigned r = getNum();
+          if (r == 0 || r > rtls.size())
+            bad = true;
+          else
+            bb->m_pRtls->push_back(rtls[r-1]);
+        }
+    }
+  bb->overlappedRegProcessingDone = getBool();
+}
+
+void ProgSnapshot::getProcHeader(Proc* p)
+{
+  p->prog = prog;
+  p->address = getNum();
+  p->m_firstCallerAddr = getNum();
+  p->m_firstCaller = getProc();
+  p->cluster = getCluster();
+  p->signature = getSignature();
+  unsigned n = getCount();
+  unsigned i;
+  for (i=0; i < n; i++)
+    {
+      Exp* e = getExp();
+      Exp* f = getExp();
+      if (e)
+        p->provenTrue[e] = f;
+    }
+  n = getCount();
+  for (i=0; i < n; i++)
+    {
+      Statement* s = getStmt();
+      if (s && s->kind == STMT_CALL)
+        p->callerSet.insert((CallStatement*)s);
+    }
+  if (!p->isLib())
+    ((UserProc*)p)->status = (ProcStatus)getNum();
+}
+
+// Read the body (Cfg, statements, locals etc) of UserProc procNum
+void ProgSnapshot::getProcBody(unsigned procNum)
+{
+  ProcEntry& pe = directory[procNum-1];
+  if (pe.loaded || pe.length == 0)
+    return;
+  pe.loaded = true;
+  makeStatements(procNum);
+  UserProc* proc = (UserProc*)procs[procNum-1];
+  Cfg* cfg = proc->cfg;
+  std::vector<Statement*>& stmts = pe.stmts;
+  const unsigned char* saveIn = in;
+  const unsigned char* saveEnd = inEnd;
+  in = base + pe.offset;
+  inEnd = in + pe.length;
+
+  unsigned n = getCount();
+  in += n;								// Skip the kinds; makeStatements() has used them
+  bbs.clear();
+  rtls.clear();
+  n = getCount();
+  unsigned i;
+  for (i=0; i < n; i++)
+    bbs.push_back(new BasicBlock());
+  n = getCount();
+  for (i=0; i < n; i++)
+    rtls.push_back(new RTL());
+  for (i=0; i < stmts.size() && !bad; i++)
+    getStatement(stmts[i]);
+  for (i=0; i < rtls.size() && !bad; i++)
+    {
+      rtls[i]->nativeAddr = getNum();
+      unsigned m = getCount();
+      for (unsigned j=0; j < m; j++)
+        {
+          Statement* s = getStmt();
+          if (s)
+            rtls[i]->stmtList.push_back(s);
+        }
+    }
+  for (i=0; i < bbs.size() && !bad; i++)
+    {
+      getBasicBlock(bbs[i]);
+      cfg->addBB(bbs[i]);
+    }
+
+  // The Cfg
+  cfg->m_bWellFormed = getBool();
+  cfg->structured = getBool();
+  cfg->lastLabel = getSNum();
+  cfg->bImplicitsDone = getBool();
+  cfg->entryBB = getBB();
+  cfg->exitBB = getBB();
+  n = getCount();
+  for (i=0; i < n; i++)
+    cfg->Ordering.push_back(getBB());
+  n = getCount();
+  for (i=0; i < n; i++)
+    cfg->revOrdering.push_back(getBB());
+  n = getCount();
+  for (i=0; i < n; i++)
+    {
+      ADDRESS a = getNum();
+      cfg->m_mapBB[a] = getBB();
+    }
+  n = getCount();
+  for (i=0; i < n; i++)
+    {
+      Statement* s = getStmt();
+      if (s && s->kind == STMT_CALL)
+        cfg->callSites.insert((CallStatement*)s);
+    }
+  n = getCount();
+  for (i=0; i < n; i++)
+    {
+      Exp* e = getExp();
+      Statement* s = getStmt();
+      if (e)
+        cfg->implicitMap[e] = s;
+    }
+
+  // The rest of the UserProc
+  n = getCount();
+  for (i=0; i < n; i++)
+    {
+      const std::string& name = getString();
+      proc->locals[name] = getType();
+    }
+  proc->nextLocal = getSNum();
+  proc->nextParam = getSNum();
+  n = getCount();
+  for (i=0; i < n; i++)
+    {
+      Exp* from = getExp();
+      Exp* to = getExp();
+      if (from)
+        proc->insertSymbol(from, to);
+    }
+  getDataIntervals(proc->localTable);
+  n = getCount();
+  for (i=0; i < n; i++)
+    {
+      Proc* p = getProc();
+      if (p)
+        proc->calleeList.push_back(p);
+    }
+  proc->col.initialised = getBool();
+  n = getCount();
+  for (i=0; i < n; i++)
+    {
+      Exp* e = getExp();
+      if (e)
+        proc->col.locs.insert(e);
+    }
+  getStmtList(proc->parameters);
+  n = getCount();
+  for (i=0; i < n; i++)
+    {
+      Exp* e = getExp();
+      if (e)
+        proc->addressEscapedVars.insert(e);
+    }
+  proc->stmtNumber = getSNum();
+  Statement* r = getStmt();
+  proc->theReturnStatement = (r && r->kind == STMT_RET) ? (ReturnStatement*)r : NULL;
+  n = getCount();
+  for (i=0; i < n; i++)
+    {
+      int off = getSNum();
+      proc->stackMap[off] = getType();
+    }
+  proc->DFGcount = getSNum();
+
+  if (!bad)
+    {
+      // All the Assigns of this proc are complete now
+      for (std::list<std::pair<DefCollector*, Assign*> >::iterator dd = pendingDefs.begin(); dd != pendingDefs.end();
+           ++dd)
+        dd->first->defs.insert(dd->second);
+    }
+  pendingDefs.clear();
+  in = saveIn;
+  inEnd = saveEnd;
+}
+
+/*==============================================================================
+ * FUNCTION:		ProgSnapshot::load
+ * OVERVIEW:		Load a Prog from a snapshot file, and the binary file that it was decoded from (if it can still be
+ *					found), so that decompilation can continue
+ * PARAMETERS:		fname - the name of the snapshot file
+ *					lazy - if true, leave the bodies of the UserProcs in the file until they are needed
+ * RETURNS:			The new Prog, or NULL if the file can't be read or is corrupt
+ *============================================================================*/
+void ProgSnapshot::getPool(unsigned poolOff)
+{
+  in = base + poolOff;
+  inEnd = base + size;
+  unsigned n = getCount();
+  pool.reserve(n);
+  for (unsigned i=0; i < n && !bad; i++)
+    {
+      unsigned len = getNum();
+      if (len > (unsigned)(inEnd - in))
+        {
+          bad = true;
+          break;
+        }
+      pool.push_back(std::string((const char*)in, len));
+      in += len;
+    }
+
+  // The types are only read when first referred to (see getType())
+  types.clear();
+  typeOffsets.clear();
+  n = bad ? 0 : getCount();
+  typeOffsets.reserve(n);
+  for (unsigned i=0; i < n && !bad; i++)
+    typeOffsets.push_back(getNum());
+  typeDefs = in;
+  for (unsigned i=0; i < typeOffsets.size(); i++)
+    if (typeOffsets[i] >= (unsigned)(inEnd - typeDefs))
+      bad = true;
+  if (!bad)
+    types.resize(typeOffsets.size(), NULL);
+}
+
+void ProgSnapshot::getStrList(std::list<std::string>& sl)
+{
+  unsigned n = getCount();
+  for (unsigned i=0; i < n && !bad; i++)
+    sl.push_back(getString());
+}
+
+Statement* ProgSnapshot::getWholeStmt()
+{
+  if (!getBool())
+    return NULL;
+  int kind = getByte();
+  Statement* s = newStatement(kind);
+  if (s == NULL)
+    {
+      bad = true;
+      return NULL;
+    }
+  s->kind = (STMT_KIND)kind;
+  getStatement(s);
+  return s;
+}
+
+void ProgSnapshot::getRTL(RTL* rtl)
+{
+  rtl->nativeAddr = getNum();
+  unsigned n = getCount();
+  for (unsigned i=0; i < n && !bad; i++)
+    {
+      Statement* s = getWholeStmt();
+      if (s)
+        rtl->stmtList.push_back(s);
+    }
+}
+
+void ProgSnapshot::getRegister(Register& reg)
+{
+  reg.s_name(getString().c_str());
+  reg.s_size(getSNum());
+  reg.s_float(getBool());
+  reg.s_mappedIndex(getSNum());
+  reg.s_mappedOffset(getSNum());
+}
+
+void ProgSnapshot::getParamEntry(ParamEntry& pe)
+{
+  getStrList(pe.params);
+  getStrList(pe.funcParams);
+  pe.asgn = getWholeStmt();
+  pe.lhs = getBool();
+  pe.kind = (ParamKind)getNum();
+  pe.type = getType();
+  pe.regType = getType();
+  unsigned n = getCount();
+  for (unsigned i=0; i < n && !bad; i++)
+    pe.regIdx.insert(getSNum());
+  pe.mark = getSNum();
+}
+
+/*==============================================================================
+ * FUNCTION:		ProgSnapshot::loadDict
+ * OVERVIEW:		Load an SSL dictionary saved by saveDict()
+ * PARAMETERS:		dict - the dictionary to fill in; it must be empty (i.e. just reset())
+ *					hash - the hash of the SSL file that the dictionary is wanted for
+ *					fname - the name of the file to load from
+ * RETURNS:			False if there is no such file, or it is not for this build or this SSL file, or is corrupt. The
+ *					dictionary is then reset again
+ *============================================================================*/
+bool ProgSnapshot::loadDict(RTLInstDict& dict, unsigned hash, const char* fname)
+{
+  if (!map(fname))
+    return false;
+  if (size < DICT_HEADER_LEN || memcmp(base, dictMagic, SNAP_MAGIC_LEN) != 0 ||
+      get32(base + SNAP_MAGIC_LEN) != SNAPSHOT_VERSION || get32(base + SNAP_MAGIC_LEN + 4) != SSLDICT_VERSION ||
+      get32(base + SNAP_MAGIC_LEN + 8) != hash || get32(base + SNAP_MAGIC_LEN + 12) != buildFingerprint())
+    {
+      unmap();
+      return false;
+    }
+  unsigned dictOff = get32(base + SNAP_MAGIC_LEN + 16);
+  unsigned poolOff = get32(base + SNAP_MAGIC_LEN + 20);
+  bad = dictOff < DICT_HEADER_LEN || dictOff > poolOff || poolOff > size;
+  pool.clear();
+  procs.clear();
+  bbs.clear();
+  rtls.clear();
+  if (!bad)
+    getPool(poolOff);
+
+  in = base + dictOff;
+  inEnd = base + poolOff;
+  unsigned n = bad ? 0 : getCount();
+  unsigned i;
+  for (i=0; i < n && !bad; i++)
+    {
+      const std::string& name = getString();
+      dict.RegMap[name] = getSNum();
+    }
+  n = bad ? 0 : getCount();
+  for (i=0; i < n && !bad; i++)
+    {
+      int idx = getSNum();
+      getRegister(dict.DetRegMap[idx]);
+    }
+  n = bad ? 0 : getCount();
+  for (i=0; i < n && !bad; i++)
+    {
+      const std::string& name = getString();
+      getRegister(dict.SpecialRegMap[name]);
+    }
+  n = bad ? 0 : getCount();
+  for (i=0; i < n && !bad; i++)
+    dict.ParamSet.insert(getString());
+  n = bad ? 0 : getCount();
+  for (i=0; i < n && !bad; i++)
+    {
+      const std::string& name = getString();
+      getParamEntry(dict.DetParamMap[name]);
+    }
+  n = bad ? 0 : getCount();
+  for (i=0; i < n && !bad; i++)
+    {
+      const std::string& from = getString();
+      dict.fastMap[from] = getString();
+    }
+  dict.bigEndian = getBool();
+  n = bad ? 0 : getCount();
+  for (i=0; i < n && !bad; i++)
+    {
+      TableEntry& te = dict.idict[getString()];
+      getStrList(te.params);
+      getRTL(&te.rtl);
+      te.flags = getSNum();
+    }
+  if (getBool())
+    {
+      dict.fetchExecCycle = new RTL();
+      getRTL(dict.fetchExecCycle);
+    }
+
+  unmap();
+  if (bad)
+    {
+      LOG << fname << " is corrupt; the SSL file is parsed instead\n";
+      dict.reset();
+      return false;
+    }
+  return true;
+}
+
+/*==============================================================================
+ * FUNCTION:		ProgSnapshot::hashFile
+ * OVERVIEW:		Hash the contents of a file (32 bit FNV-1a)
+ * PARAMETERS:		fname - the name of the file
+ *					hash - set to the hash
+ * RETURNS:			False if the file can't be read
+ *============================================================================*/
+bool ProgSnapshot::hashFile(const char* fname, unsigned& hash)
+{
+  FILE* f = fopen(fname, "rb");
+  if (f == NULL)
+    return false;
+  hash = 2166136261u;
+  unsigned char buf[8192];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+    for (size_t i=0; i < n; i++)
+      hash = (hash ^ buf[i]) * 16777619u;
+  bool ok = !ferror(f);
+  fclose(f);
+  return ok;
+}
+
+Prog* ProgSnapshot::load(const char* fname, bool lazy)
+{
+  if (!map(fname))
+    return NULL;
+  if (size < SNAP_HEADER_LEN || memcmp(base, snapMagic, SNAP_MAGIC_LEN) != 0)
+    {
+      std::cerr << fname << " is not a snapshot\n";
+      unmap();
+      return NULL;
+    }
+  unsigned version = get32(base + SNAP_MAGIC_LEN);
+  unsigned progOff = get32(base + SNAP_MAGIC_LEN + 4);
+  unsigned bodiesOff = get32(base + SNAP_MAGIC_LEN + 8);
+  unsigned poolOff = get32(base + SNAP_MAGIC_LEN + 12);
+  if (version != SNAPSHOT_VERSION)
+    {
+      std::cerr << fname << " is a version " << version << " snapshot; this version of boomerang needs version " <<
+                SNAPSHOT_VERSION << "\n";
+      unmap();
+      return NULL;
+    }
+  bad = progOff < SNAP_HEADER_LEN || progOff > bodiesOff || bodiesOff > poolOff || poolOff > size;
+  pool.clear();
+  procs.clear();
+  procNums.clear();
+  clusters.clear();
+  directory.clear();
+  pendingDefs.clear();
+
+  // The string pool first, since everything else refers to it
+  if (!bad)
+    getPool(poolOff);
+
+  prog = new Prog();
+  in = base + progOff;
+  inEnd = base + bodiesOff;
+  if (!bad)
+    {
+      prog->m_name = getString();
+      prog->m_path = getString();
+      prog->m_iNumberedProc = getSNum();
+      // The directory of procs
+      unsigned n = getCount();
+      unsigned i;
+      for (i=0; i < n && !bad; i++)
+        {
+          ProcEntry pe;
+          bool user = getBool();
+          pe.offset = bodiesOff + getNum();
+          pe.length = getNum();
+          pe.loaded = false;
+          if (pe.offset > poolOff || pe.length > poolOff - pe.offset || (!user && pe.length))
+            bad = true;
+          Proc* p;
+          if (user)
+            {
+              UserProc* up = new UserProc();
+              up->cfg = new Cfg();
+              up->cfg->setProc(up);
+              up->DFGcount = 0;
+              p = up;
+            }
+          else
+            p = new LibProc();
+          procs.push_back(p);
+          procNums[p] = procs.size();
+          directory.push_back(pe);
+        }
+
+      n = getCount();
+      for (i=0; i < n && !bad; i++)
+        {
+          unsigned char kind = getByte();
+          const char* name = getString().c_str();
+          Cluster* parent = getCluster();
+          Cluster* c;
+          if (kind == SC_CLASS)
+            {
+              Class* cl = new Class(name);
+              Type* ty = getType();
+              if (ty && ty->isCompound())
+                cl->type = (CompoundType*)ty;
+              c = cl;
+            }
+          else if (kind == SC_MODULE)
+            c = new Module(name);
+          else
+            c = new Cluster(name);
+          if (parent)
+            parent->addChild(c);
+          clusters.push_back(c);
+        }
+      if (clusters.empty())
+        bad = true;
+      else
+        prog->m_rootCluster = clusters[0];
+
+      n = getCount();
+      for (i=0; i < n && !bad; i++)
+        {
+          const char* name = getString().c_str();
+          ADDRESS addr = getNum();
+          prog->globals.insert(new Global(getType(), addr, name));
+        }
+      getDataIntervals(prog->globalMap);
+
+      for (i=0; i < procs.size() && !bad; i++)
+        getProcHeader(procs[i]);
+    }
+
+  for (unsigned i=0; i < procs.size() && !bad; i++)
+    if (!procs[i]->isLib())
+      {
+        if (!lazy)
+          getProcBody(i+1);
+        else if (directory[i].length)
+          ((UserProc*)procs[i])->bodyPending = true;
+      }
+
+  if (bad)
+    {
+      std::cerr << fname << " is corrupt\n";
+      unmap();
+      return NULL;
+    }
+
+  for (unsigned i=0; i < procs.size(); i++)
+    {
+      Proc* p = procs[i];
+      prog->m_procs.push_back(p);
+      prog->m_procLabels[p->getNativeAddress()] = p;
+      if (!p->isLib())
+        ((UserProc*)p)->cfg->setProc((UserProc*)p);
+      Boomerang::get()->alert_load(p);
+    }
+  if (lazy)
+    {
+      prog->lazyLoader = this;
+      LOG << "loaded the headers of " << (int)procs.size() << " procedures from " << fname << "\n";
+    }
+  else
+    {
+      unmap();
+      LOG << "loaded " << (int)procs.size() << " procedures from " << fname << "\n";
+    }
+
+  // Reattach the binary file, which is needed to continue decompiling. Don't use Prog::setFrontEnd(), since that
+  // would make a new root cluster
+  FrontEnd* pFE = FrontEnd::Load(prog->m_name.c_str(), prog);
+  if (pFE == NULL && prog->m_path != prog->m_name)
+    pFE = FrontEnd::Load(prog->m_path.c_str(), prog);
+  if (pFE)
+    {
+      prog->pFE = pFE;
+      prog->pBF = pFE->getBinaryFile();
+    }
+  else
+    std::cerr << "warning: cannot load " << prog->m_name << ", which " << fname << " was made from\n";
+  return prog;
+}
+
+// Read the body of proc (from the Prog loaded lazily by this object)
+void ProgSnapshot::loadBody(UserProc* proc)
+{
+  proc->bodyPending = false;
+  std::map<Proc*, unsigned>::iterator it = procNums.find(proc);
+  if (it == procNums.end() || base == NULL)
+    {
+      LOG << "no body to load for " << proc->getName() << "\n";
+      return;
+    }
+  getProcBody(it->second);
+  if (bad)
+    {
+      std::cerr << "the body of " << proc->getName() << " is corrupt in the snapshot\n";
+      LOG << "the body of " << proc->getName() << " is corrupt in the snapshot\n";
+      bad = false;						// The other bodies may still be fine
+    }
+  else if (VERBOSE)
+    LOG << "loaded the body of " << proc->getName() << "\n";
+}
+
+void ProgSnapshot::loadAll()
+{
+  for (unsigned i=0; i < procs.size(); i++)
+    if (!procs[i]->isLib() && ((UserProc*)procs[i])->bodyPending)
+      loadBody((UserProc*)procs[i]);
+}
@@ -0,0 +1,126 @@
+/*
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+/*==============================================================================
+ * FILE:	   proofcache.cpp
+ * OVERVIEW:   Implementation of the ProofCache class, the program wide memo of proven queries
+ *============================================================================*/
+
+#include <cassert>
+
+#include "proofcache.h"
+#include "exp.h"
+#include "proc.h"
+
+ProofCache::ProofCache() : lookups(0), hits(0), stale(0), proverCalls(0)
+{
+}
+
+// Must be consistent with the various operator==s: anything that operator== may consider equal (e.g. a RefExp with
+// a NULL definition and one defined by an implicit assignment) must hash to the same value
+unsigned ProofCache::hash(Exp* e)
+{
+  OPER op = e->getOper();
+  unsigned h = (unsigned)op * 2654435761u;
+  switch (op)
+    {
+    case opIntConst:
+      h ^= (unsigned)((Const*)e)->getInt();
+      break;
+    case opStrConst:
+    {
+      for (const char* p = ((Const*)e)->getStr(); *p; p++)
+        h = h * 31 + *p;
+      break;
+    }
+    case opSubscript:
+      // The definition is deliberately not hashed; see above
+      return hash(((RefExp*)e)->getSubExp1()) * 17 + 1;
+    case opTypedExp:
+      // operator== compares the type as well, but equal types will still collide, which is fine
+      return hash(((TypedExp*)e)->getSubExp1()) * 19 + 2;
+    default:
+      break;
+    }
+  switch (e->getArity())
+    {
+    case 3:
+      h = h * 31 + hash(((Ternary*)e)->getSubExp3());
+      // Fall through
+    case 2:
+      h = h * 31 + hash(((Binary*)e)->getSubExp2());
+      // Fall through
+    case 1:
+      h = h * 31 + hash(((Unary*)e)->getSubExp1());
+      break;
+    default:
+      break;
+    }
+  return h;
+}
+
+bool ProofCache::lookup(UserProc* proc, Exp* query)
+{
+  lookups++;
+  std::map<Key, std::list<Entry> >::iterator mm = memo.find(Key(proc, hash(query)));
+  if (mm == memo.end())
+    return false;
+  unsigned ssaGen = proc->getSSAGeneration();
+  std::list<Entry>& entries = mm->second;
+  for (std::list<Entry>::iterator it = entries.begin(); it != entries.end(); )
+    {
+      if (it->ssaGen != ssaGen)
+        {
+          // Out of date; the statements referenced from the query may not even exist any more
+          stale++;
+          it = entries.erase(it);
+          continue;
+        }
+      if (*it->query == *query)
+        {
+          hits++;
+          return true;
+        }
+      ++it;
+    }
+  if (entries.empty())
+    memo.erase(mm);
+  return false;
+}
+
+void ProofCache::store(UserProc* proc, Exp* query)
+{
+  Entry entry;
+  entry.query = query;
+  entry.ssaGen = proc->getSSAGeneration();
+  memo[Key(proc, hash(query))].push_back(entry);
+}
+
+void ProofCache::forget(UserProc* proc)
+{
+  // The keys of one proc are contiguous, since the proc is the first member of the key
+  std::map<Key, std::list<Entry> >::iterator first = memo.lower_bound(Key(proc, 0));
+  std::map<Key, std::list<Entry> >::iterator last = first;
+  while (last != memo.end() && last->first.first == proc)
+    ++last;
+  memo.erase(first, last);
+}
+
+void ProofCache::clear()
+{
+  memo.clear();
+}
+
+void ProofCache::printStatistics(std::ostream& os)
+{
+  unsigned entries = 0;
+  std::map<Key, std::list<Entry> >::iterator mm;
+  for (mm = memo.begin(); mm != memo.end(); ++mm)
+    entries += mm->second.size();
+  os << "proof memo: " << lookups << " lookups, " << hits << " hits, " << stale <<
+     " stale entries discarded, " << entries << " entries; " << proverCalls << " prover invocations\n";
+}
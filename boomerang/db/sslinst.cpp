@@ -48,7 +48,9 @@
 #include "proc.h"
 #include "prog.h"
 #include "sslparser.h"
+#include "progsnapshot.h"
 #include "boomerang.h"
+#include "log.h"
 // For some reason, MSVC 5.00 complains about use of undefined types a lot
 #if defined(_MSC_VER) && _MSC_VER <= 1100
 #include "signature.h"		// For MSVC 5.00
@@ -179,6 +181,9 @@ RTLInstDict::~RTLInstDict()
  * FUNCTION:		RTLInstDict::readSSLFile
  * OVERVIEW:		Read and parse the SSL file, and initialise the expanded instruction dictionary (this object).
  *					This also reads and sets up the register map and flag functions.
+ *					With -Bc <dir>, the parsed dictionary is saved in dir (e.g. as pentium.ssl.dict), and loaded from
+ *					there instead while the SSL file and the decompiler are unchanged, which saves lexing, parsing and
+ *					building the templates every time that the decompiler starts (see ProgSnapshot::saveDict())
  * PARAMETERS:		SSLFileName - the name of the file containing the SSL specification.
  * RETURNS:			the file was successfully read
  *============================================================================*/
@@ -189,6 +194,22 @@ bool RTLInstDict::readSSLFile(const std::string& SSLFileName)
   // Clear all state
   reset();
 
+  unsigned hash;
+  std::string dictFileName;
+  const std::string& cacheDir = Boomerang::get()->dictCacheDir;
+  bool haveHash = !cacheDir.empty() && ProgSnapshot::hashFile(SSLFileName.c_str(), hash);
+  if (haveHash)
+    {
+      std::string::size_type slash = SSLFileName.find_last_of("/\\");
+      dictFileName = cacheDir + SSLFileName.substr(slash == std::string::npos ? 0 : slash + 1) + ".dict";
+    }
+  if (haveHash && !Boomerang::get()->debugDecoder && ProgSnapshot().loadDict(*this, hash, dictFileName.c_str()))
+    {
+      if (VERBOSE)
+        LOG << "loaded the dictionary for " << SSLFileName.c_str() << " from " << dictFileName.c_str() << "\n";
+      return true;
+    }
+
   // Attempt to Parse the SSL file
   SSLParser theParser(SSLFileName,
 #ifdef DEBUG_SSLPARSER
@@ -202,10 +223,15 @@ bool RTLInstDict::readSSLFile(const std::string& SSLFileName)
   addRegister( "%CTI", -1, 1, false );
   addRegister( "%NEXT", -1, 32, false );
 
-  theParser.yyparse(*this);
+  bool parsed = theParser.yyparse(*this) == 0;
 
   fixupParams();
 
+  // Only a complete dictionary is saved, so that any syntax errors are reported every time. Not being able to save it
+  // (e.g. the SSL file is installed read only) only costs time
+  if (parsed && haveHash && !ProgSnapshot().saveDict(*this, hash, dictFileName.c_str()) && VERBOSE)
+    LOG << "cannot save the dictionary for " << SSLFileName.c_str() << " to " << dictFileName.c_str() << "\n";
+
   if (Boomerang::get()->debugDecoder)
       {
         std::cout << "\n=======Expanded RTL template dictionary=======\n";
@@ -216,6 +242,40 @@ bool RTLInstDict::readSSLFile(const std::string& SSLFileName)
   return true;
 }
 
+/*==============================================================================
+ * FUNCTION:		RTLInstDict::getDict
+ * OVERVIEW:		Get the dictionary for an SSL file, reading it only the first time. Parsing the SSL file is a
+ *					large part of starting up, so this matters when several programs are decoded (e.g. batch mode)
+ * PARAMETERS:		SSLFileName - the name of the file containing the SSL specification.
+ * RETURNS:			the dictionary; empty if the file could not be read (and then not kept, so it is read again)
+ *============================================================================*/
+static std::map<std::string, RTLInstDict*> sslDicts;		// The dictionaries kept by getDict()
+
+RTLInstDict* RTLInstDict::getDict(const std::string& SSLFileName)
+{
+  std::map<std::string, RTLInstDict*>::iterator it = sslDicts.find(SSLFileName);
+  if (it != sslDicts.end())
+    return it->second;
+  RTLInstDict* dict = new RTLInstDict();
+  if (dict->readSSLFile(SSLFileName))
+    sslDicts[SSLFileName] = dict;
+  return dict;
+}
+
+/*==============================================================================
+ * FUNCTION:		RTLInstDict::freeDicts
+ * OVERVIEW:		Delete the dictionaries kept by getDict(), e.g. at the end of a batch. The decoders that used them
+ *					must have been deleted already
+ * PARAMETERS:		<none>
+ * RETURNS:			<nothing>
+ *============================================================================*/
+void RTLInstDict::freeDicts()
+{
+  for (std::map<std::string, RTLInstDict*>::iterator it = sslDicts.begin(); it != sslDicts.end(); ++it)
+    delete it->second;
+  sslDicts.clear();
+}
+
 /*==============================================================================
  * FUNCTION:		RTLInstDict::addRegister
  * OVERVIEW:		Add a new register definition to the dictionary
@@ -409,6 +469,47 @@ std::pair<std::string,unsigned> RTLInstDict::getSignature(const char* name)
   return ret;
 }
 
+/*==============================================================================
+ * FUNCTION:		 RTLInstDict::getInstructionId
+ * OVERVIEW:		 Returns the id of the instruction named name (which is converted as in getSignature()). Ids are
+ *					 allocated as instructions are first seen, and are cached by the address of name
+ * PARAMETERS:		 name - instruction name
+ * RETURNS:			 The id (an index into idTable), or -1 if not even NOP is in the dictionary
+ *============================================================================*/
+int RTLInstDict::getInstructionId(const char* name)
+{
+  std::map<const char*, int>::iterator nn = nameToId.find(name);
+  if (nn != nameToId.end())
+    return nn->second;
+
+  // First time this name is seen. Convert it as for getSignature
+  char *opcode = new char[strlen(name) + 1];
+  upperStr(name, opcode);
+  std::remove(opcode,opcode+strlen(opcode)+1,'.');
+  std::map<std::string,TableEntry>::iterator it = idict.find(opcode);
+  delete [] opcode;
+  if (it == idict.end())
+    {
+      std::cerr << "Error: no entry for `" << name << "' in RTL dictionary\n";
+      it = idict.find("NOP");		// At least, don't cause segfault
+      if (it == idict.end())
+        return -1;
+    }
+
+  // Several names (e.g. "LAR.od" and "LARod") can map to the same entry; give them the same id
+  int id;
+  std::vector<TableEntry*>::iterator tt = std::find(idTable.begin(), idTable.end(), &it->second);
+  if (tt != idTable.end())
+    id = tt - idTable.begin();
+  else
+    {
+      id = idTable.size();
+      idTable.push_back(&it->second);
+    }
+  nameToId[name] = id;
+  return id;
+}
+
 /*==============================================================================
  * FUNCTION:		 RTLInstDict::partialType
  * OVERVIEW:		 Scan the Exp* pointed to by exp; if its top level operator indicates even a partial type, then set
@@ -464,6 +565,12 @@ std::list<Statement*>* RTLInstDict::instantiateRTL(std::string& name, ADDRESS na
   return instantiateRTL( entry.rtl, natPC, entry.params, actuals );
 }
 
+std::list<Statement*>* RTLInstDict::instantiateRTL(int id, ADDRESS natPC, std::vector<Exp*>& actuals)
+{
+  TableEntry& entry = *idTable[id];
+  return instantiateRTL( entry.rtl, natPC, entry.params, actuals );
+}
+
 /*==============================================================================
  * FUNCTION:		 RTLInstDict::instantiateRTL
  * OVERVIEW:		 Returns an instance of a register transfer list for the parameterized rtlist with the given formals
@@ -714,5 +821,7 @@ void RTLInstDict::reset()
   AliasMap.clear();
   fastMap.clear();
   idict.clear();
+  idTable.clear();
+  nameToId.clear();
   fetchExecCycle = 0;
 }
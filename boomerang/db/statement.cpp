@@ -824,15 +824,10 @@ bool Statement::canPropagateToExp(Exp*e)
 // Return true if any change; set convert if an indirect call statement is converted to direct (else unchanged)
 // destCounts is a set of maps from location to number of times it is used this proc
 // usedByDomPhi is a set of subscripted locations used in phi statements
-static int progress = 0;
 bool Statement::propagateTo(bool& convert, std::map<Exp*, int, lessExpStar>* destCounts /* = NULL */,
                             LocationSet* usedByDomPhi /* = NULL */, bool force /* = false */)
 {
-  if (++progress > 1000)
-    {
-      std::cerr << 'p' << std::flush;
-      progress = 0;
-    }
+  Boomerang::get()->showProgress('p', 1000);
   bool change;
   int changes = 0;
   // int sp = proc->getSignature()->getStackRegister(proc->getProg());
@@ -278,19 +278,18 @@ bool UsedLocsFinder::visit(Location* e, bool& override)
 {
   if (!memOnly)
     used->insert(e);				// All locations visited are used
-  if (e->isMemOf())
+  if (e->isMemOf() && memOnly)
     {
       // Example: m[r28{10} - 4]	we use r28{10}
       Exp* child = e->getSubExp1();
       // Care! Need to turn off the memOnly flag for work inside the m[...], otherwise everything will get ignored
-      bool wasMemOnly = memOnly;
       memOnly = false;
       child->accept(this);
-      memOnly = wasMemOnly;
+      memOnly = true;
       override = true;					// Already looked inside child
     }
   else
-    override = false;
+    override = false;					// Without memOnly, the walk can just go on inside m[...]
   return true;						// Continue looking for other locations
 }
 
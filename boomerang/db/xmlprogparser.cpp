@@ -2373,6 +2373,7 @@ void XMLProgParser::persistToXML(std::ostream &out, LibProc *proc)
 
 void XMLProgParser::persistToXML(std::ostream &out, UserProc *proc)
 {
+  proc->loadBody();
   out << "<userproc id=\"" << (int)proc << "\"";
   out << " address=\"" << (int)proc->address << "\"";
   out << " status=\"" << (int)proc->status << "\"";
@@ -25,6 +25,9 @@
 
 #ifndef NO_GARBAGE_COLLECTOR
 #include "gc.h"
+#else
+#include <cstdlib>
+#include <new>
 #endif
 
 void init_dfa();			// Prototypes for
@@ -50,6 +53,8 @@ int main(int argc, const char* argv[])
 	that we can't be bothered collecting, especially standard STL objects */
 void* operator new(size_t n)
 {
+  Boomerang::numAllocations++;		// For -Bj
+  Boomerang::numAllocatedBytes += n;	// For -bm
 #ifdef DONT_COLLECT_STL
   return GC_malloc_uncollectable(n);	// Don't collect, but mark
 #else
@@ -64,6 +69,22 @@ void operator delete(void* p)
   // #else do nothing!
 #endif
 }
+#else
+/* Without the garbage collector, these are only here to count the allocations (for -Bj) */
+void* operator new(size_t n)
+{
+  Boomerang::numAllocations++;
+  Boomerang::numAllocatedBytes += n;
+  void* p = malloc(n ? n : 1);
+  if (p == NULL)
+    throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p)
+{
+  free(p);
+}
 #endif
 #endif
 
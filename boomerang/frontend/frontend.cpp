@@ -27,6 +27,7 @@
  */
 
 #include <cassert>
+#include <ctime>
 #if defined(_MSC_VER) && _MSC_VER <= 1200
 #pragma warning(disable:4786)
 #endif
@@ -68,9 +69,12 @@
  *				  pbff: pointer to a BinaryFileFactory object (so the library can be unloaded)
  * RETURNS:		  <N/a>
  *============================================================================*/
-FrontEnd::FrontEnd(BinaryFile *pBF, Prog* prog, BinaryFileFactory* pbff) : pBF(pBF), pbff(pbff), prog(prog)
+FrontEnd::FrontEnd(BinaryFile *pBF, Prog* prog, BinaryFileFactory* pbff) : pBF(pBF), pbff(pbff), prog(prog),
+	lastSection(NULL)
 {}
 
+std::map<std::string, std::list<Signature*> > FrontEnd::residentSignatures;
+
 // Static function to instantiate an appropriate concrete front end
 FrontEnd* FrontEnd::instantiate(BinaryFile *pBF, Prog* prog, BinaryFileFactory* pbff) {
 	switch(pBF->GetMachine()) {
@@ -253,6 +257,7 @@ std::vector<ADDRESS> FrontEnd::getEntryPoints()
 }
 
 void FrontEnd::decode(Prog* prog, bool decodeMain, const char *pname) {
+	ContextScope scope(prog->getContext());
 	if (pname)
 		prog->setName(pname);
 
@@ -306,6 +311,7 @@ void FrontEnd::decode(Prog* prog, bool decodeMain, const char *pname) {
 
 // Somehow, a == NO_ADDRESS has come to mean decode anything not already decoded
 void FrontEnd::decode(Prog *prog, ADDRESS a) {
+	ContextScope scope(prog->getContext());
 	if (a != NO_ADDRESS) {
 		prog->setNewProc(a);
 		if (VERBOSE)
@@ -372,14 +378,61 @@ void FrontEnd::decodeFragment(UserProc* proc, ADDRESS a) {
 }
 
 DecodeResult& FrontEnd::decodeInstruction(ADDRESS pc) {
-	if (pBF->GetSectionInfoByAddr(pc) == NULL) {
+	if (lastSection == NULL || pc < lastSection->uNativeAddr ||
+			pc - lastSection->uNativeAddr >= lastSection->uSectionSize)
+		lastSection = pBF->GetSectionInfoByAddr(pc);
+	if (lastSection == NULL) {
 		LOG << "ERROR: attempted to decode outside any known segment " << pc << "\n";
 		static DecodeResult invalid;
 		invalid.reset();
 		invalid.valid = false;
 		return invalid;
 	}
-	return decoder->decodeInstruction(pc, pBF->getTextDelta());
+	// The decoder may only fetch from the section containing pc
+	int delta = pBF->getTextDelta();
+	bool overran;
+	DecodeResult& inst = decoder->decodeInSection(pc, delta,
+		lastSection->uNativeAddr + lastSection->uSectionSize + delta, overran);
+	if (overran) {
+		LOG << "ERROR: instruction at " << pc << " runs past the end of section " << lastSection->pSectionName <<
+			"\n";
+		inst.valid = false;
+	}
+	return inst;
+}
+
+void FrontEnd::benchmarkDecoder(std::ostream& os, int runs) {
+	bool savedDebug = Boomerang::get()->debugDecoder;
+	Boomerang::get()->debugDecoder = false;
+	for (int i = 0; i < pBF->GetNumSections(); i++) {
+		PSectionInfo pSect = pBF->GetSectionInfo(i);
+		if (!pSect->bCode || pSect->uSectionSize == 0)
+			continue;
+		int numInsts = 0, numInvalid = 0;
+		clock_t start = clock();
+		for (int run = 0; run < runs; run++) {
+			numInsts = numInvalid = 0;
+			ADDRESS a = pSect->uNativeAddr;
+			ADDRESS end = pSect->uNativeAddr + pSect->uSectionSize;
+			while (a < end) {
+				DecodeResult& inst = decodeInstruction(a);
+				numInsts++;
+				if (!inst.valid || inst.numBytes <= 0) {
+					// Resynchronise at the next byte
+					numInvalid++;
+					a++;
+				} else
+					a += inst.numBytes;
+			}
+		}
+		double secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+		os << pSect->pSectionName << ": " << std::dec << pSect->uSectionSize << " bytes, " << numInsts <<
+			" instructions (" << numInvalid << " invalid), " << runs << " runs in " << secs << " s";
+		if (secs > 0)
+			os << " (" << (long)(numInsts * (double)runs / secs) << " instructions/s)";
+		os << "\n";
+	}
+	Boomerang::get()->debugDecoder = savedDebug;
 }
 
 /*==============================================================================
@@ -390,6 +443,21 @@ DecodeResult& FrontEnd::decodeInstruction(ADDRESS pc) {
  * RETURNS:		   <nothing>
  *============================================================================*/
 void FrontEnd::readLibrarySignatures(const char *sPath, callconv cc) {
+	platform plat = getFrontEndId();
+	// In batch mode, the signatures of each file are parsed once and kept. Each program gets its own copies, since
+	// the signatures of library procs are changed in place (e.g. by type analysis), and all the calls of one program
+	// share them (see getLibSignature())
+	std::ostringstream key;
+	bool keep = Boomerang::get()->keepResident;
+	if (keep) {
+		key << sPath << " " << plat << " " << cc;
+		std::map<std::string, std::list<Signature*> >::iterator rr = residentSignatures.find(key.str());
+		if (rr != residentSignatures.end()) {
+			cloneResidentSignatures(rr->second, sPath);
+			return;
+		}
+	}
+
 	std::ifstream ifs;
 
 	ifs.open(sPath);
@@ -401,21 +469,55 @@ void FrontEnd::readLibrarySignatures(const char *sPath, callconv cc) {
 
 	AnsiCParser *p = new AnsiCParser(ifs, false);
 	
-	platform plat = getFrontEndId();
 	p->yyparse(plat, cc);
 
 	for (std::list<Signature*>::iterator it = p->signatures.begin(); it != p->signatures.end(); it++) {
 #if 0
 		std::cerr << "readLibrarySignatures from " << sPath << ": " << (*it)->getName() << "\n";
 #endif
-		librarySignatures[(*it)->getName()] = *it;
 		(*it)->setSigFile(sPath);
+		if (!keep)
+			librarySignatures[(*it)->getName()] = *it;
+	}
+	if (keep) {
+		residentSignatures[key.str()] = p->signatures;
+		cloneResidentSignatures(p->signatures, sPath);
 	}
 
 	delete p;
 	ifs.close();
 }
 
+/*==============================================================================
+ * FUNCTION:	   FrontEnd::cloneResidentSignatures
+ * OVERVIEW:	   Add copies of signatures kept in residentSignatures to the library signatures of this program
+ * PARAMETERS:	   sigs: the signatures
+ *				   sPath: the file that they were read from
+ * RETURNS:		   <nothing>
+ *============================================================================*/
+void FrontEnd::cloneResidentSignatures(std::list<Signature*>& sigs, const char *sPath) {
+	for (std::list<Signature*>::iterator it = sigs.begin(); it != sigs.end(); it++) {
+		Signature *sig = (*it)->clone();
+		sig->setSigFile(sPath);			// Not all the clone() functions copy it
+		librarySignatures[sig->getName()] = sig;
+	}
+}
+
+/*==============================================================================
+ * FUNCTION:	   FrontEnd::freeResidentSignatures
+ * OVERVIEW:	   Delete the signatures kept for later programs, e.g. at the end of a batch. Each program has its own
+ *				   copies, so this can be done while programs still exist
+ * PARAMETERS:	   <none>
+ * RETURNS:		   <nothing>
+ *============================================================================*/
+void FrontEnd::freeResidentSignatures() {
+	std::map<std::string, std::list<Signature*> >::iterator rr;
+	for (rr = residentSignatures.begin(); rr != residentSignatures.end(); rr++)
+		for (std::list<Signature*>::iterator it = rr->second.begin(); it != rr->second.end(); it++)
+			delete *it;
+	residentSignatures.clear();
+}
+
 Signature *FrontEnd::getDefaultSignature(const char *name)
 {
 	Signature *signature = NULL;
@@ -53,7 +53,7 @@ void MIPSDecoder::unused(int x)
 MIPSDecoder::MIPSDecoder(Prog* prog) : NJMCDecoder(prog)
 {
   std::string file = Boomerang::get()->getProgPath() + "frontend/machine/mips/mips.ssl";
-  RTLDict.readSSLFile(file.c_str());
+  RTLDict = RTLInstDict::getDict(file);
 }
 
 // For now...
@@ -803,7 +803,7 @@ DWord SparcDecoder::getDword(ADDRESS lc)
 SparcDecoder::SparcDecoder(Prog* prog) : NJMCDecoder(prog)
 {
 	std::string file = Boomerang::get()->getProgPath() + "frontend/machine/sparc/sparc.ssl";
-	RTLDict.readSSLFile(file.c_str());
+	RTLDict = RTLInstDict::getDict(file);
 }
 
 // For now...
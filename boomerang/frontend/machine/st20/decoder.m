@@ -343,7 +343,7 @@ DWord ST20Decoder::getDword (unsigned lc)
 ST20Decoder::ST20Decoder() : NJMCDecoder(prog)
 {
 	std::string file = Boomerang::get()->getProgPath() + "frontend/machine/st20/st20.ssl";
-	RTLDict.readSSLFile(file.c_str());
+	RTLDict = RTLInstDict::getDict(file);
 }
 
 // For now...
@@ -25,6 +25,7 @@
 #endif
 
 #include <stdarg.h>			// For varargs
+#include <string.h>			// For memcpy
 #include "rtl.h"
 #include "decoder.h"
 #include "exp.h"
@@ -49,9 +50,38 @@
  * PARAMETERS:	   prog: Pointer to the Prog object
  * RETURNS:		   N/A
  *============================================================================*/
-NJMCDecoder::NJMCDecoder(Prog* prog) : prog(prog)
+NJMCDecoder::NJMCDecoder(Prog* prog) : prog(prog), copyShift(0), RTLDict(NULL)
 {}
 
+/*==============================================================================
+ * FUNCTION:	   NJMCDecoder::decodeInSection
+ * OVERVIEW:	   Decodes the instruction at pc, as decodeInstruction() does, without fetching from beyond the end of
+ *					the section that pc is in. There is one check per instruction: if all the bytes that the decoder
+ *					could fetch are in the section, the image is decoded directly; otherwise a copy of the rest of the
+ *					section, padded with zeros, is decoded instead.
+ * PARAMETERS:	   pc - the native address of the instruction
+ *				   delta - the difference between the native and the host address of the instruction
+ *				   hostEnd - the host address of the end of the section
+ *				   overran - set to true if the instruction runs past the end of the section, else false
+ * RETURNS:		   the result of decodeInstruction()
+ *============================================================================*/
+DecodeResult& NJMCDecoder::decodeInSection(ADDRESS pc, int delta, ADDRESS hostEnd, bool& overran)
+{
+	overran = false;
+	ADDRESS hostPC = pc + delta;
+	if (hostEnd - hostPC >= MAX_FETCH)
+		return decodeInstruction(pc, delta);
+	unsigned left = hostEnd - hostPC;
+	memset(sectionTail, 0, sizeof(sectionTail));
+	memcpy(sectionTail, (void*)hostPC, left);
+	copyShift = (ADDRESS)sectionTail - hostPC;
+	DecodeResult& inst = decodeInstruction(pc, delta + copyShift);
+	copyShift = 0;
+	if (inst.numBytes > (int)left)
+		overran = true;
+	return inst;
+}
+
 /*==============================================================================
  * FUNCTION:	   NJMCDecoder::instantiate
  * OVERVIEW:	   Given an instruction name and a variable list of expressions representing the actual operands of
@@ -63,10 +93,14 @@ NJMCDecoder::NJMCDecoder(Prog* prog) : prog(prog)
  * RETURNS:		   an instantiated list of Exps
  *============================================================================*/
 std::list<Statement*>* NJMCDecoder::instantiate(ADDRESS pc, const char* name, ...) {
-	// Get the signature of the instruction and extract its parts
-	std::pair<std::string,unsigned> sig = RTLDict.getSignature(name);
-	std::string opcode = sig.first;
-	unsigned numOperands = sig.second;
+	// Get the id of the instruction. Since name is a literal in the generated decoders, this is a string lookup only
+	// the first time that each name is seen
+	int id = RTLDict->getInstructionId(name);
+	if (id == -1) {
+		std::cerr << "ERROR: unknown instruction " << name << " at 0x" << std::hex << pc << std::dec << ", ignoring.\n";
+		return NULL;
+	}
+	unsigned numOperands = RTLDict->getNumOperands(id);
 
 	// Put the operands into a vector
 	std::vector<Exp*> actuals(numOperands);
@@ -94,7 +128,7 @@ std::list<Statement*>* NJMCDecoder::instantiate(ADDRESS pc, const char* name, ..
 		std::cout << std::endl;
 	}
 
-	std::list<Statement*>* instance = RTLDict.instantiateRTL(opcode, pc, actuals);
+	std::list<Statement*>* instance = RTLDict->instantiateRTL(id, pc, actuals);
 
 	return instance;
 }
@@ -109,12 +143,12 @@ std::list<Statement*>* NJMCDecoder::instantiate(ADDRESS pc, const char* name, ..
  * RETURNS:		   an instantiated list of Exps
  *============================================================================*/
 Exp* NJMCDecoder::instantiateNamedParam(char* name, ...) {
-	if (RTLDict.ParamSet.find(name) == RTLDict.ParamSet.end()) {
+	if (RTLDict->ParamSet.find(name) == RTLDict->ParamSet.end()) {
 		std::cerr << "No entry for named parameter '" << name << "'\n";
 		return 0;
 	}
-	assert(RTLDict.DetParamMap.find(name) != RTLDict.DetParamMap.end());
-	ParamEntry &ent = RTLDict.DetParamMap[name];
+	assert(RTLDict->DetParamMap.find(name) != RTLDict->DetParamMap.end());
+	ParamEntry &ent = RTLDict->DetParamMap[name];
 	if (ent.kind != PARAM_ASGN && ent.kind != PARAM_LAMBDA ) {
 		std::cerr << "Attempt to instantiate expressionless parameter '" << name << "'\n";
 		return 0;
@@ -149,11 +183,11 @@ Exp* NJMCDecoder::instantiateNamedParam(char* name, ...) {
  *============================================================================*/
 void NJMCDecoder::substituteCallArgs(char *name, Exp*& exp, ...)
 {
-	if (RTLDict.ParamSet.find(name) == RTLDict.ParamSet.end()) {
+	if (RTLDict->ParamSet.find(name) == RTLDict->ParamSet.end()) {
 		std::cerr << "No entry for named parameter '" << name << "'\n";
 		return;
 	}
-	ParamEntry &ent = RTLDict.DetParamMap[name];
+	ParamEntry &ent = RTLDict->DetParamMap[name];
 	/*if (ent.kind != PARAM_ASGN && ent.kind != PARAM_LAMBDA) {
 		std::cerr << "Attempt to instantiate expressionless parameter '" << name << "'\n";
 		return;
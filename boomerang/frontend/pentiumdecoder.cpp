@@ -61947,7 +61947,7 @@ SWord PentiumDecoder::getWord (unsigned lc)
 DWord PentiumDecoder::getDword (unsigned lc)
 /* get4Bytes - returns the next 4-Byte word from image pointed to by lc. */
 {
-	lastDwordLc = lc - prog->getTextDelta();
+	lastDwordLc = lc - copyShift - prog->getTextDelta();
 	return (DWord)(*(Byte *)lc + (*(Byte *)(lc+1) << 8) + (*(Byte *)(lc+2) << 16) + (*(Byte *)(lc+3) << 24));
 }
 
@@ -61961,7 +61961,7 @@ DWord PentiumDecoder::getDword (unsigned lc)
 PentiumDecoder::PentiumDecoder(Prog* prog) : NJMCDecoder(prog)
 {
 	std::string file = Boomerang::get()->getProgPath() + "frontend/machine/pentium/pentium.ssl";
-	RTLDict.readSSLFile(file.c_str());
+	RTLDict = RTLInstDict::getDict(file);
 }
 
 // For now...
@@ -4633,7 +4633,7 @@ DWord PPCDecoder::getDword(ADDRESS lc)
 PPCDecoder::PPCDecoder(Prog* prog) : NJMCDecoder(prog)
 {
   std::string file = Boomerang::get()->getProgPath() + "frontend/machine/ppc/ppc.ssl";
-  RTLDict.readSSLFile(file.c_str());
+  RTLDict = RTLInstDict::getDict(file);
 }
 
 // For now...
@@ -138,9 +138,16 @@ class BinaryFileFactory
 #else
   void*		dlHandle;		// Needed for UnLoading the library
 #endif
+  // With keepLoaded, the loader libraries are not unloaded by UnLoad(), and are reused for later files (batch mode)
+  static bool	keepLoaded;
+  static std::map<std::string, void*> loadedLibs;
 public:
   BinaryFile	*Load( const char *sName );
   void		UnLoad();
+  static void	setKeepLoaded(bool keep)
+  {
+    keepLoaded = keep;
+  }
 private:
   /*
    * Perform simple magic on the file by the given name in order to determine the appropriate type, and then return an
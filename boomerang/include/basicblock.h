@@ -609,6 +609,7 @@ public:
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
   void		addOutEdge(PBB bb)
   {
     m_OutEdges.push_back(bb);
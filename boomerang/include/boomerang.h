@@ -114,6 +114,8 @@ class Boomerang
 {
 private:
   static Boomerang *boomerang;
+  /// The context of the decompilation running now, if it is not the global one (see ContextScope)
+  static Boomerang *current;
   /// String with the path to the boomerang executable.
   std::string	progPath;
   /// The path where all output files are created.
@@ -122,6 +124,12 @@ private:
   Log			*logger;
   /// The watchers which are interested in this decompilation.
   std::set<Watcher*> watchers;
+  /// The phases of the current decompilation that have been timed so far (for -Bj), with their wall times in ms
+  std::vector<std::pair<const char*, unsigned> > benchPhases;
+  /// Wall clock when the last of benchPhases was started
+  unsigned	benchPhaseStart;
+  /// Steps of the long running phases so far, by the character that shows their progress (see showProgress())
+  int			progressCounts[128];
 
 
   /* Documentation about a function should be at one place only
@@ -134,21 +142,29 @@ private:
   int			splitLine(char *line, char ***pargv);
   int			parseCmd(int argc, const char **argv);
   int			cmdLine();
+  void		benchPhase(const char *name);
+  void		writeBenchStats(const char *fname, Prog *prog);
+  int			batchDecompileOne(const char *fname);
+  int			forkBatchWorker(const std::vector<std::string> &files, unsigned first, unsigned step, int &fd);
 
 
   Boomerang();
+  friend class ContextScope;
+public:
   /// The destructor is virtual to force this object to be created on the heap (with \em new).
   virtual			~Boomerang()
   {}
-public:
   /**
-   * \return The global boomerang object. It will be created if it didn't already exist.
+   * \return The context of the decompilation running now. This is the global boomerang object,
+   * which will be created if it didn't already exist, unless another context was made current with a ContextScope.
    */
   static Boomerang *get()
   {
+    if (current) return current;
     if (!boomerang) boomerang = new Boomerang();
     return boomerang;
   }
+  Boomerang	*newContext();
 
   static	const char*		getVersionStr();
   Log			&log();
@@ -185,11 +201,14 @@ public:
 
   Prog		*loadAndDecode(const char *fname, const char *pname = NULL);
   int			decompile(const char *fname, const char *pname = NULL);
+  int			batchDecompile(const char *listFile);
   /// Add a Watcher to the set of Watchers for this Boomerang object.
   void		addWatcher(Watcher *watcher)
   {
     watchers.insert(watcher);
   }
+  bool		saveProg(Prog *prog, const char *fname = NULL);
+  Prog		*loadProg(const char *fname);
   void		persistToXML(Prog *prog);
   Prog		*loadFromXML(const char *fname);
 
@@ -303,6 +322,15 @@ public:
   virtual void		alert_decompile_debug_point(UserProc *p, const char *description);
 
   void		logTail();
+  /// Count a step of the long running phase shown by \a c, and show \a c on \a os every \a every steps
+  void		showProgress(char c, int every, std::ostream &os = std::cerr)
+  {
+    if (++progressCounts[c & 0x7F] >= every)
+      {
+        progressCounts[c & 0x7F] = 0;
+        os << c << std::flush;
+      }
+  }
 
   // Command line flags
   bool		vFlag;
@@ -348,6 +376,7 @@ public:
   bool		loadBeforeDecompile;
   bool		saveBeforeDecompile;
   bool		noProve;
+  bool		noProofMemo;
   bool		noChangeSignatures;
   bool		conTypeAnalysis;
   bool		dfaTypeAnalysis;
@@ -358,6 +387,39 @@ public:
   bool		assumeABI;			///< Assume ABI compliance
   bool		experimental;		///< Activate experimental code. Caution!
   int			minsToStopAfter;
+  int			procTimeBudget;		///< Wall time in seconds each UserProc may use (0 for no limit)
+  int			phaseTimeBudget;	///< Wall time in seconds each phase of a UserProc may use (0 for no limit)
+  int			procStmtBudget;		///< Statements each UserProc may process (0 for no limit)
+  int			procMemBudget;		///< Kilobytes each UserProc may allocate (0 for no limit)
+  int			decoderBenchRuns;	///< Decode the code sections this many times, report the speed, and stop
+  std::string	benchStatsFile;		///< Write the time of each phase, peak memory etc to this file (JSON) if not empty
+  static unsigned long numAllocations;	///< Calls to operator new so far (if counted by the driver; see driver.cpp)
+  static unsigned long numAllocatedBytes;	///< Bytes requested from operator new so far (likewise)
+  bool		internTypes;		///< Share one immutable object for each simple type (see Type::intern())
+  std::string	batchFile;			///< Decompile each of the programs listed in this file, if not empty (-Bf)
+  int			batchWorkers;		///< Number of worker processes for batchFile
+  bool		keepResident;		///< Keep loaders, SSL dictionaries and library signatures for later programs
+  std::string	dictCacheDir;		///< Save parsed SSL dictionaries in this directory (ending in /), if not empty (-Bc)
+};
+
+/**
+ * Makes a context the current one (the object that Boomerang::get() returns) for the lifetime of this object, and then
+ * restores the previous one. Everything that starts a decompilation or a part of one makes the context of its Prog
+ * current like this, so that Progs with different contexts keep their own options and logger when they are
+ * decompiled in turn (see Boomerang::newContext()).
+ */
+class ContextScope
+{
+  Boomerang	*previous;
+public:
+  ContextScope(Boomerang *ctx) : previous(Boomerang::current)
+  {
+    Boomerang::current = ctx;
+  }
+  ~ContextScope()
+  {
+    Boomerang::current = previous;
+  }
 };
 
 #define VERBOSE				(Boomerang::get()->vFlag)
@@ -0,0 +1,127 @@
+/*
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+/*==============================================================================
+ * FILE:	   budget.h
+ * OVERVIEW:   Cooperative decompilation budgets for a single UserProc. A budget limits the wall time, the number of
+ *				statements processed and the number of bytes allocated by a procedure, in total and per phase.
+ *				Allocations are counted by the operator new of the driver (see driver.cpp), so they are cumulative
+ *				(memory freed later is not subtracted), and are counted the same way with or without the collector.
+ *				Nothing is ever interrupted: the decompiler polls isExceeded() at convenient points and degrades
+ *				gracefully (skips further passes, uses a cheaper type analysis, emits the decoded RTL).
+ *============================================================================*/
+
+#ifndef __BUDGET_H__
+#define __BUDGET_H__
+
+#include <iostream>
+#include <string>
+
+/// The phases of the decompilation of one procedure that are accounted separately
+enum BudgetPhase
+{
+  PHASE_NONE = -1,
+  PHASE_EARLY,				///< initialiseDecompile() and earlyDecompile()
+  PHASE_MIDDLE,				///< middleDecompile()
+  PHASE_FINAL,				///< remUnusedStmtEtc(), including the local type analysis
+  PHASE_GLOBAL,				///< Whole program passes (global type analysis, range analysis)
+  NUM_BUDGET_PHASES
+};
+
+class ProcBudget
+{
+  bool		exceeded;						///< Latched: once exceeded, always exceeded
+  BudgetPhase	curPhase;					///< Phase being accounted now, or PHASE_NONE
+  BudgetPhase	exceededPhase;				///< Phase that was active when the budget ran out
+  unsigned	phaseStartMs;					///< Wall clock when curPhase was entered
+  unsigned long phaseStartBytes;			///< Bytes allocated so far when curPhase was entered
+  unsigned	phaseMs[NUM_BUDGET_PHASES];		///< Wall time spent in each phase so far
+  unsigned long phaseBytes[NUM_BUDGET_PHASES];	///< Bytes allocated in each phase so far
+  int			stmts;						///< Statements processed (summed over all passes)
+  std::string	reason;						///< Human readable description of the exceeded limit
+  std::string	decodedRtl;					///< The RTL as decoded (only kept when some limit is set)
+
+public:
+  ProcBudget();
+
+  /// Start accounting for phase ph. Any phase already active is closed first, and returned
+  BudgetPhase	enterPhase(BudgetPhase ph);
+  /// Stop accounting for the current phase (if any)
+  void		leavePhase();
+  void		addStatements(int n)
+  {
+    stmts += n;
+  }
+
+  /// Poll the limits set with the -b switches. Returns true if any limit has been exceeded (now or earlier)
+  bool		isExceeded();
+  /// As above, but don't poll; just return the latched result
+  bool		wasExceeded()
+  {
+    return exceeded;
+  }
+  BudgetPhase	getExceededPhase()
+  {
+    return exceededPhase;
+  }
+  const char*	getReason()
+  {
+    return reason.c_str();
+  }
+
+  /// The decoded RTL is saved by initialiseDecompile() when any limit is set, so that it can be emitted with the
+  /// code if the budget runs out in any later phase
+  void		setDecodedRTL(const std::string& rtl)
+  {
+    decodedRtl = rtl;
+  }
+  const std::string& getDecodedRTL()
+  {
+    return decodedRtl;
+  }
+
+  unsigned	getTotalMs();
+  unsigned long getTotalBytes();
+  int			getNumStatements()
+  {
+    return stmts;
+  }
+
+  void		print(std::ostream& os);
+
+  static const char* getPhaseName(BudgetPhase ph);
+  /// True if any of the -b limits is set
+  static bool	isLimited();
+  /// Wall clock in milliseconds (arbitrary origin)
+  static unsigned	wallMillis();
+  /// Bytes allocated with operator new since the start, or 0 if the driver doesn't count them
+  static unsigned long bytesAllocated();
+  /// Peak resident set size of the process in kilobytes, or 0 if this can't be determined on this platform
+  static long	peakResidentKBytes();
+};
+
+/// Accounts the lifetime of this object to a phase of a ProcBudget; handy for functions with several returns.
+/// Scopes can nest (e.g. when middleDecompile() restarts the decompilation); the enclosing phase is resumed at the end
+class BudgetPhaseScope
+{
+  ProcBudget&	budget;
+  BudgetPhase	prevPhase;
+public:
+  BudgetPhaseScope(ProcBudget& b, BudgetPhase ph) : budget(b)
+  {
+    prevPhase = budget.enterPhase(ph);
+  }
+  ~BudgetPhaseScope()
+  {
+    if (prevPhase == PHASE_NONE)
+      budget.leavePhase();
+    else
+      budget.enterPhase(prevPhase);
+  }
+};
+
+#endif	// #ifndef __BUDGET_H__
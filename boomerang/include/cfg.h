@@ -67,6 +67,33 @@ class Parameter;
 // A type for the ADDRESS to BB map
 typedef std::map<ADDRESS, PBB, std::less<ADDRESS> >	  MAPBB;
 
+/*==============================================================================
+ * The members of the loop being structured (see Cfg::structLoops()), by their position in the ordering. They all lie
+ * between the latch and the header, so only that interval is stored, one bit per node; the bits are reused for each
+ * loop, so the cost is in proportion to the extent of the loop rather than to the size of the whole CFG.
+ *============================================================================*/
+class LoopNodes
+{
+  int			first;							// Ordering of the first node of the interval
+  std::vector<bool> bits;
+public:
+  LoopNodes() : first(0) { }
+  // Start a new loop, with no members yet, spanning the orderings lo to hi
+  void		reset(int lo, int hi)
+  {
+    first = lo;
+    bits.assign(hi >= lo ? hi - lo + 1 : 0, false);
+  }
+  void		insert(int ord)
+  {
+    bits[ord - first] = true;
+  }
+  bool		operator[](int ord) const
+  {
+    return ord >= first && ord - first < (int)bits.size() && bits[ord - first];
+  }
+};
+
 /*==============================================================================
  * Control Flow Graph class. Contains all the BasicBlock objects for a procedure.  These BBs contain all the RTLs for
  * the procedure, so by traversing the Cfg, one traverses the whole procedure.
@@ -83,6 +110,13 @@ class Cfg
    */
   std::list<PBB> m_listBB;
 
+  /*
+   * Worklist of the BBs with computed jumps or calls that have not been resolved yet, in the order that they were
+   * created. May contain BBs that have since changed type; these are dropped by decodeIndirectJmp(). Only tells
+   * whether there is anything to analyse; the BBs themselves are analysed in the order of m_listBB.
+   */
+  std::list<PBB> m_indirectBBs;
+
   /*
    * Ordering of BBs for control flow structuring
    */
@@ -463,9 +497,9 @@ public:
   void		structConds();
   void		structLoops();
   void		checkConds();
-  void		determineLoopType(PBB header, bool* &loopNodes);
-  void		findLoopFollow(PBB header, bool* &loopNodes);
-  void		tagNodesInLoop(PBB header, bool* &loopNodes);
+  void		determineLoopType(PBB header, LoopNodes& loopNodes);
+  void		findLoopFollow(PBB header, LoopNodes& loopNodes);
+  void		tagNodesInLoop(PBB header, LoopNodes& loopNodes);
 
   void		removeUnneededLabels(HLLCode *hll);
   void		generateDotFile(std::ofstream& of);
@@ -536,8 +570,11 @@ protected:
   void	addBB(PBB bb)
   {
     m_listBB.push_back(bb);
+    if (bb->getType() == COMPJUMP || bb->getType() == COMPCALL)
+      m_indirectBBs.push_back(bb);
   }
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;				/* Cfg */
 
@@ -95,6 +95,7 @@ class Cluster
   protected:
 
     friend class XMLProgParser;
+    friend class ProgSnapshot;
   };
 
 class Module : public Cluster
@@ -121,6 +122,8 @@ class Class : public Cluster
     {
       return true;
     }
+
+    friend class ProgSnapshot;
   };
 
 #endif /*__CLUSTER_H__*/
@@ -259,6 +259,8 @@ public:
    * Search and replace all occurrences
    */
   void		searchReplaceAll(Exp* from, Exp* to, bool& change);
+
+  friend class ProgSnapshot;
 }
 ;		// class DefCollector
 
@@ -362,6 +364,8 @@ public:
   }
   void		fromSSAform(UserProc* proc, Statement* def);	// Translate out of SSA form
   bool		operator==(UseCollector& other);
+
+  friend class ProgSnapshot;
 }
 ;		// class UseCollector
 
@@ -126,7 +126,7 @@ class NJMCDecoder
 
     RTLInstDict& getRTLDict()
     {
-      return RTLDict;
+      return *RTLDict;
     }
 
     void		computedJump(const char* name, int size, Exp* dest, ADDRESS pc, std::list<Statement*>* stmts,
@@ -140,8 +140,28 @@ class NJMCDecoder
       return prog;
     }
 
+    /*
+     * As decodeInstruction(), but no byte is fetched from at or beyond hostEnd (the host address of the end of the
+     * section being decoded). Sets overran if the instruction would run past hostEnd
+     */
+    DecodeResult& decodeInSection(ADDRESS pc, int delta, ADDRESS hostEnd, bool& overran);
+
+    /*
+     * No decoder fetches more than this many bytes from the start of an instruction (the longest Pentium
+     * instruction is 15 bytes)
+     */
+    enum { MAX_FETCH = 16 };
+
   protected:
 
+    /*
+     * The fetch routines of the generated decoders read the image directly, without checks. Near the end of a
+     * section, decodeInSection() decodes a zero padded copy of the rest of the section instead; copyShift is then
+     * the distance from the bytes in the image to the copy (and otherwise zero)
+     */
+    Byte		sectionTail[2*MAX_FETCH];
+    int			copyShift;
+
     /*
      * Given an instruction name and a variable list of Exps representing the actual operands of the instruction,
      * use the RTL template dictionary to return the list of Statements representing the semantics of the
@@ -181,8 +201,8 @@ class NJMCDecoder
     Exp*		dis_Reg(int regNum);
 
     // Public dictionary of instruction patterns, and other information summarised from the SSL file
-    // (e.g. source machine's endianness)
-    RTLInstDict	RTLDict;
+    // (e.g. source machine's endianness). Shared by all decoders for the same SSL file (see RTLInstDict::getDict())
+    RTLInstDict*	RTLDict;
   };
 
 // Function used to guess whether a given pc-relative address is the start of a function
@@ -386,8 +386,8 @@ public:
   // Mostly not for public use. Search for subexpression matches.
   static	void		doSearch(Exp* search, Exp*& pSrc, std::list<Exp**>& li, bool once);
 
-  // As above.
-  virtual void		doSearchChildren(Exp* search, std::list<Exp**>& li, bool once);
+  // As above. Push (references to) the children that are searched on todo, last first
+  virtual void		pushSearchChildren(std::vector<Exp**>& todo);
 
   /// Propagate all possible assignments to components of this expression.
   Exp*		propagateAll();
@@ -492,8 +492,12 @@ public:
   virtual Exp*		genConstraints(Exp* result);
 
   // Visitation
-  // Note: best to have accept() as pure virtual, so you don't forget to implement it for new subclasses of Exp
-  virtual bool		accept(ExpVisitor* v) = 0;
+  // accept(ExpVisitor*) walks the expression with an explicit stack (todo) rather than by recursion, so that deeply
+  // nested expressions can't overflow the machine stack. visitNode() visits one node, and unless the visitor
+  // overrides it, pushes the children on todo, last first. Returns false to stop the walk
+  bool		accept(ExpVisitor* v);
+  // Note: best to have these pure virtual, so you don't forget to implement them for new subclasses of Exp
+  virtual bool		visitNode(ExpVisitor* v, std::vector<Exp*>& todo) = 0;
   virtual Exp*		accept(ExpModifier* v) = 0;
   void		fixLocationProc(UserProc* p);
   UserProc*	findProc();
@@ -529,6 +533,7 @@ public:
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;		// class Exp
 
@@ -640,7 +645,8 @@ public:
   virtual Exp*		genConstraints(Exp* restrictTo);
 
   // Visitation
-  virtual bool		accept(ExpVisitor* v);
+  using Exp::accept;
+  virtual bool		visitNode(ExpVisitor* v, std::vector<Exp*>& todo);
   virtual Exp*		accept(ExpModifier* v);
 
   virtual bool 		match(const char *pattern, std::map<std::string, Exp*> &bindings);
@@ -659,6 +665,7 @@ public:
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;		// class Const
 
@@ -690,7 +697,8 @@ public:
   }
 
   // Visitation
-  virtual bool		accept(ExpVisitor* v);
+  using Exp::accept;
+  virtual bool		visitNode(ExpVisitor* v, std::vector<Exp*>& todo);
   virtual Exp*		accept(ExpModifier* v);
 
   virtual	Type*		ascendType();
@@ -700,6 +708,7 @@ public:
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;		// class Terminal
 
@@ -756,7 +765,7 @@ public:
   virtual bool 		match(const char *pattern, std::map<std::string, Exp*> &bindings);
 
   // Search children
-  void 			doSearchChildren(Exp* search, std::list<Exp**>& li, bool once);
+  void 			pushSearchChildren(std::vector<Exp**>& todo);
 
   // Do the work of simplifying this expression
   virtual Exp*		polySimplify(bool& bMod);
@@ -768,7 +777,8 @@ public:
   virtual Exp*		genConstraints(Exp* restrictTo);
 
   // Visitation
-  virtual bool		accept(ExpVisitor* v);
+  using Exp::accept;
+  virtual bool		visitNode(ExpVisitor* v, std::vector<Exp*>& todo);
   virtual Exp*		accept(ExpModifier* v);
 
   virtual	Type*		ascendType();
@@ -776,6 +786,7 @@ public:
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;	// class Unary
 
@@ -832,7 +843,7 @@ public:
   virtual bool 		match(const char *pattern, std::map<std::string, Exp*> &bindings);
 
   // Search children
-  void		doSearchChildren(Exp* search, std::list<Exp**>& li, bool once);
+  void		pushSearchChildren(std::vector<Exp**>& todo);
 
   // Do the work of simplifying this expression
   virtual Exp*		polySimplify(bool& bMod);
@@ -844,7 +855,8 @@ public:
   virtual Exp*		genConstraints(Exp* restrictTo);
 
   // Visitation
-  virtual bool		accept(ExpVisitor* v);
+  using Exp::accept;
+  virtual bool		visitNode(ExpVisitor* v, std::vector<Exp*>& todo);
   virtual Exp*		accept(ExpModifier* v);
 
   virtual	Type*		ascendType();
@@ -855,6 +867,7 @@ private:
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;	// class Binary
 
@@ -905,7 +918,7 @@ public:
   Exp*&		refSubExp3();
 
   // Search children
-  void		doSearchChildren(Exp* search, std::list<Exp**>& li, bool once);
+  void		pushSearchChildren(std::vector<Exp**>& todo);
 
   virtual Exp*		polySimplify(bool& bMod);
   Exp*		simplifyArith();
@@ -915,7 +928,8 @@ public:
   virtual Exp* genConstraints(Exp* restrictTo);
 
   // Visitation
-  virtual bool	accept(ExpVisitor* v);
+  using Exp::accept;
+  virtual bool	visitNode(ExpVisitor* v, std::vector<Exp*>& todo);
   virtual Exp*	accept(ExpModifier* v);
 
   virtual bool 		match(const char *pattern, std::map<std::string, Exp*> &bindings);
@@ -925,6 +939,7 @@ public:
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;	// class Ternary
 
@@ -974,7 +989,8 @@ public:
   virtual Exp*		polySimplify(bool& bMod);
 
   // Visitation
-  virtual bool		accept(ExpVisitor* v);
+  using Exp::accept;
+  virtual bool		visitNode(ExpVisitor* v, std::vector<Exp*>& todo);
   virtual Exp*		accept(ExpModifier* v);
 
   virtual	Type*		ascendType();
@@ -982,6 +998,7 @@ public:
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;		// class TypedExp
 
@@ -1005,11 +1022,13 @@ public:
   }
 
   // Visitation
-  virtual bool		accept(ExpVisitor* v);
+  using Exp::accept;
+  virtual bool		visitNode(ExpVisitor* v, std::vector<Exp*>& todo);
   virtual Exp*		accept(ExpModifier* v);
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;		// class FlagDef
 
@@ -1063,7 +1082,8 @@ public:
   bool		isImplicitDef();
 
   // Visitation
-  virtual bool		accept(ExpVisitor* v);
+  using Exp::accept;
+  virtual bool		visitNode(ExpVisitor* v, std::vector<Exp*>& todo);
   virtual Exp*		accept(ExpModifier* v);
 
   virtual	Type*		ascendType();
@@ -1073,6 +1093,7 @@ protected:
   RefExp() : Unary(opSubscript), def(NULL)
   { }
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;		// class RefExp
 
@@ -1110,11 +1131,13 @@ public:
 //virtual Exp		*match(Exp *pattern);
 
   // Visitation
-  virtual bool		accept(ExpVisitor* v);
+  using Exp::accept;
+  virtual bool		visitNode(ExpVisitor* v, std::vector<Exp*>& todo);
   virtual Exp*		accept(ExpModifier* v);
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;	// class TypeVal
 
@@ -1170,12 +1193,14 @@ public:
   virtual void		getDefinitions(LocationSet& defs);
 
   // Visitation
-  virtual bool		accept(ExpVisitor* v);
+  using Exp::accept;
+  virtual bool		visitNode(ExpVisitor* v, std::vector<Exp*>& todo);
   virtual Exp*		accept(ExpModifier* v);
   virtual bool 		match(const char *pattern, std::map<std::string, Exp*> &bindings);
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
   Location(OPER op) : Unary(op), proc(NULL)
   { }
 };	// class Location
@@ -120,10 +120,16 @@ class FrontEnd
     TargetQueue	targetQueue;
     // Public map from function name (string) to signature.
     std::map<std::string, Signature*> librarySignatures;
+    // The signatures read from each signature file (keyed by file, platform and calling convention), kept for later
+    // programs when Boomerang::keepResident is set
+    static std::map<std::string, std::list<Signature*> > residentSignatures;
+    void		cloneResidentSignatures(std::list<Signature*>& sigs, const char *sPath);
     // Map from address to meaningful name
     std::map<ADDRESS, std::string> refHints;
     // Map from address to previously decoded RTLs for decoded indirect control transfer instructions
     std::map<ADDRESS, RTL*> previouslyDecoded;
+    // The section containing the last instruction decoded (usually contains the next one as well)
+    PSectionInfo lastSection;
   public:
     /*
      * Constructor. Takes some parameters to save passing these around a lot
@@ -177,6 +183,12 @@ class FrontEnd
 
     virtual DecodeResult& decodeInstruction(ADDRESS pc);
 
+    /*
+     * Microbenchmark for the decoder: decode every instruction of the code sections, runs times, and report the
+     * decoding rate to os
+     */
+    void		benchmarkDecoder(std::ostream& os, int runs);
+
     virtual void extraProcessCall(CallStatement *call, std::list<RTL*> *BB_rtls)
     { }
 
@@ -192,6 +204,8 @@ class FrontEnd
      * Read library signatures from a file.
      */
     void		readLibrarySignatures(const char *sPath, callconv cc);
+    // Delete the signatures kept in residentSignatures
+    static void	freeResidentSignatures();
     // read from a catalog
     void		readLibraryCatalog(const char *sPath);
     // read from default catalog
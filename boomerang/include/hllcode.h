@@ -25,6 +25,7 @@
 
 #include <iostream>
 #include <vector>
+#include <map>
 #include <assert.h>
 #include <statement.h>		// For CallStatement::RetLocs
 
@@ -137,15 +138,22 @@ class HLLCode
   }
 ;		// class HLLCode
 
+/*
+ * The nodes of the candidate ASTs of UserProc::getAST(). A candidate shares all the nodes of the tree that it was
+ * made from, except those on the paths from the root to the nodes that were changed (see substitute()), so nodes
+ * must not be changed once they are in a tree, and trees can only be deleted together (see deleteTrees()).
+ */
 class SyntaxNode
   {
   protected:
     PBB		pbb;
     int		nodenum;
     int		score;
+    int		value;			// evaluate(this), or -1 if not known yet
     SyntaxNode *correspond; // corresponding node in previous state
     bool	notGoto;
     int		depth;
+    std::map<PBB, SyntaxNode*> *index;	// Results of findNode() so far, if this is the root of a tree
 
   public:
     SyntaxNode();
@@ -187,6 +195,8 @@ class SyntaxNode
                                          SyntaxNode *cur = NULL) = 0;
 
     int		getScore();
+    // The value of the tree with this root, i.e. the score without the depth
+    int		getValue();
     void	addToScore(int n)
     {
       score = getScore() + n;
@@ -201,13 +211,25 @@ class SyntaxNode
     }
 
     virtual SyntaxNode *clone() = 0;
-    virtual SyntaxNode *replace(SyntaxNode *from, SyntaxNode *to) = 0;
+    // Return this tree with from replaced by to (or removed, if to is NULL and from is in a block). Only the nodes on
+    // the path to from are copied, the rest are shared, and this tree is not changed. Returns this if from is not
+    // in it
+    virtual SyntaxNode *substitute(SyntaxNode *from, SyntaxNode *to) = 0;
     SyntaxNode *getCorrespond()
     {
       return correspond;
     }
+    // Append the children of this node to children
+    virtual void	getChildren(std::vector<SyntaxNode*> &children) = 0;
+    // Forget the children, without deleting them
+    virtual void	dropChildren() = 0;
+    // Delete all the nodes of the given trees, except those of the tree keep
+    static void	deleteTrees(std::vector<SyntaxNode*> &trees, SyntaxNode *keep);
 
     virtual SyntaxNode *findNodeFor(PBB bb) = 0;
+    // As findNodeFor(), for this root of a tree; the results are remembered until clearIndex()
+    SyntaxNode *findNode(PBB bb);
+    void	clearIndex();
     virtual void	printAST(SyntaxNode *root, std::ostream &os) = 0;
     virtual int		evaluate(SyntaxNode *root) = 0;
     virtual void	addSuccessors(SyntaxNode *root, std::vector<SyntaxNode*> &successors)
@@ -289,7 +311,11 @@ class BlockSyntaxNode : public SyntaxNode
     }
 
     virtual SyntaxNode *clone();
-    virtual SyntaxNode *replace(SyntaxNode *from, SyntaxNode *to);
+    // A new block with the same (shared) statements
+    BlockSyntaxNode *copy();
+    virtual SyntaxNode *substitute(SyntaxNode *from, SyntaxNode *to);
+    virtual void	getChildren(std::vector<SyntaxNode*> &children);
+    virtual void	dropChildren();
 
     virtual SyntaxNode *findNodeFor(PBB bb);
     virtual void	printAST(SyntaxNode *root, std::ostream &os);
@@ -328,7 +354,9 @@ class IfThenSyntaxNode : public SyntaxNode
     }
 
     virtual SyntaxNode *clone();
-    virtual SyntaxNode *replace(SyntaxNode *from, SyntaxNode *to);
+    virtual SyntaxNode *substitute(SyntaxNode *from, SyntaxNode *to);
+    virtual void	getChildren(std::vector<SyntaxNode*> &children);
+    virtual void	dropChildren();
 
     virtual SyntaxNode *getEnclosingLoop(SyntaxNode *pFor, SyntaxNode *cur = NULL)
     {
@@ -400,7 +428,9 @@ class IfThenElseSyntaxNode : public SyntaxNode
 
 
     virtual SyntaxNode *clone();
-    virtual SyntaxNode *replace(SyntaxNode *from, SyntaxNode *to);
+    virtual SyntaxNode *substitute(SyntaxNode *from, SyntaxNode *to);
+    virtual void	getChildren(std::vector<SyntaxNode*> &children);
+    virtual void	dropChildren();
 
     void	setCond(Exp *e)
     {
@@ -457,7 +487,9 @@ class PretestedLoopSyntaxNode : public SyntaxNode
     }
 
     virtual SyntaxNode *clone();
-    virtual SyntaxNode *replace(SyntaxNode *from, SyntaxNode *to);
+    virtual SyntaxNode *substitute(SyntaxNode *from, SyntaxNode *to);
+    virtual void	getChildren(std::vector<SyntaxNode*> &children);
+    virtual void	dropChildren();
 
     void	setCond(Exp *e)
     {
@@ -509,7 +541,9 @@ class PostTestedLoopSyntaxNode : public SyntaxNode
     }
 
     virtual SyntaxNode *clone();
-    virtual SyntaxNode *replace(SyntaxNode *from, SyntaxNode *to);
+    virtual SyntaxNode *substitute(SyntaxNode *from, SyntaxNode *to);
+    virtual void	getChildren(std::vector<SyntaxNode*> &children);
+    virtual void	dropChildren();
 
     void	setCond(Exp *e)
     {
@@ -563,7 +597,9 @@ class InfiniteLoopSyntaxNode : public SyntaxNode
     }
 
     virtual SyntaxNode *clone();
-    virtual SyntaxNode *replace(SyntaxNode *from, SyntaxNode *to);
+    virtual SyntaxNode *substitute(SyntaxNode *from, SyntaxNode *to);
+    virtual void	getChildren(std::vector<SyntaxNode*> &children);
+    virtual void	dropChildren();
 
     void	setBody(SyntaxNode *n)
     {
@@ -35,6 +35,7 @@
 #include "dataflow.h"			// For class UseCollector
 #include "statement.h"			// For embedded ReturnStatement pointer, etc
 #include "boomerang.h"			// For USE_DOMINANCE_NUMS etc
+#include "budget.h"				// For ProcBudget
 
 class Prog;
 class UserProc;
@@ -97,6 +98,7 @@ public:
   {
     return prog;
   }
+
   void		setProg(Prog *p)
   {
     prog = p;
@@ -210,13 +212,10 @@ public:
   void		setProvenTrue(Exp* fact);
 
   /**
-   * Get the callers
+   * Get the callers. The bodies of the procs they are in are read first (see UserProc::loadBody())
    * Note: the callers will be in a random order (determined by memory allocation)
    */
-  std::set<CallStatement*>& getCallers()
-  {
-    return callerSet;
-  }
+  std::set<CallStatement*>& getCallers();
 
   /**
    * Add to the set of callers
@@ -290,6 +289,7 @@ protected:
   Cluster		*cluster;						///< Cluster this procedure is contained within.
 
   friend class XMLProgParser;
+  friend class ProgSnapshot;
   Proc() : visited(false), prog(NULL), signature(NULL), address(0), m_firstCaller(NULL), m_firstCallerAddr(0),
     cluster(NULL)
   { }
@@ -332,6 +332,7 @@ public:
 protected:
 
   friend class XMLProgParser;
+  friend class ProgSnapshot;
   LibProc() : Proc()
   { }
 };		// class LibProc
@@ -371,6 +372,17 @@ class UserProc : public Proc
    */
   ProcStatus	status;
 
+  /**
+   * True if this procedure was loaded lazily from a snapshot (see ProgSnapshot), and its body (Cfg, statements,
+   * locals, etc) has not been read yet. loadBody() reads it. It is called only where the body is reached from outside:
+   * the accessors that hand out parts of it (getCFG(), getEntryBB(), getStatements(), getParameters(),
+   * getModifieds(), getTheReturnStatement(), getCallees()), the queries that other procs or the Prog make about it
+   * (containsAddr(), isNoReturn()), getCallers() (for the procs of the calls), and the operations started on a proc
+   * as a whole (decompile(), generateCode(), print(), printCallGraphXML()). Everything else, e.g. the symbol and local
+   * lookups, is only reached from the body itself or from one of these, so it can use the members directly.
+   */
+  bool		bodyPending;
+
   /*
    * Somewhat DEPRECATED now. Eventually use the localTable.
    * This map records the names and types for local variables. It should be a subset of the symbolMap, which also
@@ -397,6 +409,15 @@ public:
 private:
   SymbolMap	symbolMap;
 
+  /**
+   * Indexes of the symbol map; only insertSymbol(), eraseSymbol() and clearSymbols() change symbolMap, and they
+   * keep these up to date. symbolsByName has the expressions mapped to each local, by the name of the local.
+   * symbolsByOffset has the entries for stack locations, i.e. of the form m[sp{-} - K] (but the register isn't
+   * checked), by their offset -K.
+   */
+  std::map<std::string, std::vector<Exp*> > symbolsByName;
+  std::multimap<int, std::pair<Exp*, Exp*> > symbolsByOffset;
+
   /**
    * The local "symbol table", which is aware of overlaps
    */
@@ -458,6 +479,18 @@ private:
   /// function to do safe adding.
   void addToStackMap(int c, Type *ty);
 
+  /**
+   * Resources used so far while decompiling this procedure, and whether the limits set with the -b switches have
+   * been exceeded
+   */
+  ProcBudget	budget;
+
+  /**
+   * Incremented whenever the statements of this procedure change in a way that may affect what can be proved
+   * about it (renaming, propagation, insertion or removal of statements, etc). See class ProofCache
+   */
+  unsigned	ssaGeneration;
+
 public:
 
   UserProc(Prog *prog, std::string& name, ADDRESS address);
@@ -478,9 +511,22 @@ public:
    */
   Cfg*		getCFG()
   {
+    loadBody();
     return cfg;
   }
 
+  /**
+   * Read the body of this procedure now, if it is still in the snapshot it was loaded from
+   */
+  void		loadBody()
+  {
+    if (bodyPending) readBody();
+  }
+  bool		isBodyPending()
+  {
+    return bodyPending;
+  }
+
   /**
    * Returns a pointer to the DataFlow object.
    */
@@ -540,6 +586,23 @@ public:
   }
   void		setStatus(ProcStatus s);
 
+  ProcBudget&	getBudget()
+  {
+    return budget;
+  }
+  /// Poll the budget; log the first time it is found to be exceeded. Returns true if over budget
+  bool		isOverBudget();
+
+  /// Note that the SSA form has changed; invalidates what the ProofCache knows about this procedure
+  void		ssaChanged()
+  {
+    ssaGeneration++;
+  }
+  unsigned	getSSAGeneration()
+  {
+    return ssaGeneration;
+  }
+
   /// code generation
   void		generateCode(HLLCode *hll);
 
@@ -680,7 +743,7 @@ public:
   void		eliminateDuplicateArgs();
 
 private:
-  void		searchRegularLocals(OPER minusOrPlus, bool lastPass, int sp, StatementList& stmts);
+  void		searchRegularLocals(bool lastPass, int sp, StatementList& stmts);
 public:
   bool		removeNullStatements();
   bool		removeDeadStatements();
@@ -718,6 +781,10 @@ public:
 
   void		conTypeAnalysis();
   void		dfaTypeAnalysis();
+  /// Meet the types of the arguments and results of the calls in this procedure with the parameter and return types of
+  /// the callees (interprocedural type analysis). Callees whose types changed are added to \a changedCallees.
+  /// Returns true if any types in this procedure changed
+  bool		meetCallTypes(std::set<UserProc*>& changedCallees);
   /// Trim parameters to procedure calls with ellipsis (...). Also add types for ellipsis parameters, if any
   /// Returns true if any signature types so added.
   bool		ellipsisProcessing();
@@ -774,10 +841,12 @@ public:
   void		makeParamsImplicit();
   StatementList& getParameters()
   {
+    loadBody();
     return parameters;
   }
   StatementList& getModifieds()
   {
+    loadBody();
     return theReturnStatement->getModifieds();
   }
 
@@ -799,6 +868,13 @@ private:
    */
   void		checkMemSize(Exp* e);
 
+  /**
+   * Add, remove one, or remove all the entries of symbolMap, keeping its indexes up to date
+   */
+  void		insertSymbol(Exp* from, Exp* to);
+  void		eraseSymbol(SymbolMap::iterator it);
+  void		clearSymbols();
+
 public:
   /**
    * Return an expression that is equivilent to e in terms of local variables.  Creates new locals as needed.
@@ -892,6 +968,7 @@ public:
    */
   std::list<Proc*>& getCallees()
   {
+    loadBody();
     return calleeList;
   }
 
@@ -968,9 +1045,11 @@ private:
   /// STMT_RET. If no return statement, this will be NULL.
   ReturnStatement* theReturnStatement;
   int			DFGcount;
+  void		readBody();
 public:
   ADDRESS		getTheReturnAddr()
   {
+    loadBody();
     return theReturnStatement == NULL ? NO_ADDRESS : theReturnStatement->getRetAddr();
   }
   void		setTheReturnAddr(ReturnStatement* s, ADDRESS r)
@@ -981,6 +1060,7 @@ public:
   }
   ReturnStatement* getTheReturnStatement()
   {
+    loadBody();
     return theReturnStatement;
   }
   bool		filterReturns(Exp* e);			///< Decide whether to filter out e (return true) or keep it
@@ -991,6 +1071,7 @@ public:
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
   UserProc();
   void		setCFG(Cfg *c)
   {
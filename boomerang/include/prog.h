@@ -26,6 +26,7 @@
 #include "frontend.h"
 #include "type.h"
 #include "cluster.h"
+#include "proofcache.h"
 
 class RTLInstDict;
 class Proc;
@@ -36,6 +37,8 @@ class Statement;
 class StatementSet;
 class Cluster;
 class XMLProgParser;
+class ProgSnapshot;
+class Boomerang;
 
 typedef std::map<ADDRESS, Proc*, std::less<ADDRESS> > PROGMAP;
 
@@ -76,6 +79,7 @@ protected:
   Global() : type(NULL), uaddr(0), nam("")
   { }
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;		// class Global
 
@@ -93,6 +97,11 @@ public:
   void		remProc(UserProc* proc);		// Remove the given UserProc
   void        removeProc(const char *name);
   char*		getName();						// Get the name of this program
+  // The context (options, logger and watchers) of the decompilation of this program; the one current when it was made
+  Boomerang*	getContext()
+  {
+    return context;
+  }
   const char *getPath()
   {
     return m_path.c_str();
@@ -168,6 +177,10 @@ public:
   // Do the main non-global decompilation steps
   void		decompile();
 
+  // Read the body of a UserProc that was loaded lazily from a snapshot, or the bodies of all such UserProcs
+  void		loadProcBody(UserProc* proc);
+  void		loadAllProcBodies();
+
   // All that used to be done in UserProc::decompile, but now done globally: propagation, recalc DFA, remove null
   // and unused statements, compressCfg, process constants, promote signature, simplify a[m[]].
   void		decompileProcs();
@@ -199,6 +212,15 @@ public:
   // Range analysis
   void		rangeAnalysis();
 
+  // Report the procedures that exceeded their decompilation budget (if any budget was set)
+  void		printBudgetSummary(std::ostream &os);
+
+  // The memo of proven and disproven queries, shared by all procedures
+  ProofCache&	getProofCache()
+  {
+    return proofCache;
+  }
+
   // Generate dotty file
   void		generateDotFile();
 
@@ -398,8 +420,12 @@ protected:
   DataIntervalMap globalMap;			// Map from address to DataInterval (has size, name, type)
   int			m_iNumberedProc;		// Next numbered proc will use this
   Cluster		*m_rootCluster;			// Root of the cluster tree
+  ProofCache	proofCache;				// Memo of the results of UserProc::prove()
+  ProgSnapshot* lazyLoader;			// The snapshot that the bodies of some procs are still to be read from, or NULL
+  Boomerang*	context;				// See getContext()
 
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;	// class Prog
 
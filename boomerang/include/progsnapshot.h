@@ -0,0 +1,211 @@
+/*
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+/*==============================================================================
+ * FILE:	   progsnapshot.h
+ * OVERVIEW:   Saving and loading the state of a Prog in a compact binary format. This is much faster than the XML
+ *				format of XMLProgParser (which is kept for interchange), and the files are a fraction of the size.
+ *
+ *				A snapshot consists of a fixed header, the program section (a directory of all procedures, clusters,
+ *				globals, and the signatures of the procedures), the bodies of the UserProcs (CFG, RTLs and
+ *				statements), and finally a pool of all the strings and types used, which the other sections refer to
+ *				by number. Every object that can be referred to from elsewhere gets a number instead of being
+ *				written out again: procedures, clusters and types are numbered over the whole program (so a type
+ *				shared by several owners is shared again when it is read, and a type can refer to itself through a
+ *				pointer), while BBs, RTLs and statements are numbered within their procedure. A statement is
+ *				referred to by the number of its procedure and its own number; each body starts with a table of the
+ *				kinds of its statements, so that the statements of a procedure can all be created before any of them
+ *				is read. All numbers are written as variable length unsigned integers (7 bits per byte), so the
+ *				format is independent of the word size and byte order of the host.
+ *
+ *				The same encoding is used for precompiled SSL dictionaries (see RTLInstDict::readSSLFile()): a
+ *				header with a different magic number and the hash of the SSL file that the dictionary was parsed
+ *				from, then the dictionary section (registers, parameters, and the RTL templates of the instructions)
+ *				and the pool.
+ *============================================================================*/
+
+#ifndef __PROGSNAPSHOT_H__
+#define __PROGSNAPSHOT_H__
+
+#include <string>
+#include <vector>
+#include <map>
+#include <list>
+#include "types.h"
+
+class Prog;
+class Proc;
+class UserProc;
+class Cluster;
+class Statement;
+class StatementList;
+class DefCollector;
+class Assign;
+class BasicBlock;
+class RTL;
+class Exp;
+class Type;
+class Signature;
+class DataIntervalMap;
+class RTLInstDict;
+class Register;
+class ParamEntry;
+
+#define SNAPSHOT_VERSION	2		// Increment whenever the format changes; older snapshots are then rejected
+#define SSLDICT_VERSION		2		// Likewise for the dictionary section, or the output of the SSL parser
+
+class ProgSnapshot
+{
+public:
+  ProgSnapshot();
+  ~ProgSnapshot();
+
+  /// Save prog to the file fname. Returns false if the file could not be written
+  bool		save(Prog* prog, const char* fname);
+  /**
+   * Load a Prog from the file fname. Returns NULL if it can't be read, or is not a snapshot of this version.
+   * If lazy is true, only the directory of procedures and their headers are read; the bodies of the UserProcs are read
+   * the first time that they are needed (see UserProc::loadBody()). The file stays mapped until then, and the new Prog
+   * takes over this object, and deletes it when it is deleted itself.
+   */
+  Prog*		load(const char* fname, bool lazy = false);
+  /// Read the body of proc, which must be from the Prog last loaded lazily
+  void		loadBody(UserProc* proc);
+  /// Read all the bodies not yet read
+  void		loadAll();
+  /// True if fname starts like a snapshot (of any version)
+  static bool	isSnapshot(const char* fname);
+
+  /// Save dict, as parsed from an SSL file with the given hash (see hashFile()), to the file fname
+  bool		saveDict(RTLInstDict& dict, unsigned hash, const char* fname);
+  /// Load dict (which must be empty) from the file fname. Returns false if it can't be read, or was not saved by this
+  /// build of the decompiler from an SSL file with the given hash
+  bool		loadDict(RTLInstDict& dict, unsigned hash, const char* fname);
+  /// Hash the contents of the file fname, to tell when a saved dictionary is out of date. False if it can't be read
+  static bool	hashFile(const char* fname, unsigned& hash);
+
+private:
+  // Writing
+  std::vector<unsigned char>* out;					///< The section being written
+  std::map<std::string, unsigned> stringIds;
+  std::vector<std::string> strings;
+  std::map<Proc*, unsigned> procIds;					///< From 1; 0 is the NULL proc
+  std::map<Cluster*, unsigned> clusterIds;
+  std::map<Statement*, std::pair<unsigned, unsigned> > stmtIds;	///< Proc number, and number within the proc
+  std::map<BasicBlock*, unsigned> bbIds;				///< Numbers of the BBs of the proc being written
+  std::map<RTL*, unsigned> rtlIds;					///< ... and of its RTLs
+  std::map<Type*, unsigned> typeIds;					///< From 1; 0 is the NULL type
+  std::vector<Type*> typeList;						///< The inverse of typeIds; the types to write in the pool
+  unsigned	danglingRefs;							///< References to statements that are not in any proc
+
+  void		putByte(unsigned char b)
+  {
+    out->push_back(b);
+  }
+  void		putNum(unsigned n);
+  void		putSNum(int n);
+  void		putQWord(QWord n);
+  void		putDouble(double d);
+  void		putString(const std::string& s);
+  void		putBool(bool b)
+  {
+    putByte(b ? 1 : 0);
+  }
+  void		putProc(Proc* p);
+  void		putStmt(Statement* s);
+  void		putStmtList(StatementList& sl);
+  void		putBB(BasicBlock* bb);
+  void		putType(Type* ty);
+  void		putTypeDef(Type* ty);
+  void		putExp(Exp* e);
+  void		putSignature(Signature* sig);
+  void		putDefCollector(DefCollector& col);
+  void		putDataIntervals(DataIntervalMap& dim);
+  void		putCluster(Cluster* c);
+  void		putProcHeader(Proc* p);
+  void		putProcBody(UserProc* proc, std::vector<Statement*>& stmts);
+  void		putStatement(Statement* s);
+  void		putBasicBlock(BasicBlock* bb);
+  void		putPool();
+  void		putStrList(std::list<std::string>& sl);
+  void		putWholeStmt(Statement* s);
+  void		putRTL(RTL* rtl);
+  void		putRegister(Register& reg);
+  void		putParamEntry(ParamEntry& pe);
+  void		numberStatements(UserProc* proc, std::vector<Statement*>& stmts);
+  void		numberStatement(Statement* s, unsigned procNum, std::vector<Statement*>& stmts);
+
+  // Reading
+  const unsigned char* base;						///< The whole file
+  unsigned	size;
+  bool		mapped;									///< True if base is mapped, false if allocated
+  const unsigned char* in;							///< Current position
+  const unsigned char* inEnd;						///< End of the current section
+  bool		bad;									///< Set when the input is found to be corrupt
+  Prog*		prog;
+  std::vector<std::string> pool;
+  std::vector<Type*> types;							///< The types of the pool; NULL until first referred to
+  std::vector<unsigned> typeOffsets;					///< Offset of the definition of each type from typeDefs
+  const unsigned char* typeDefs;
+  std::vector<Proc*> procs;
+  std::map<Proc*, unsigned> procNums;				///< The inverse of procs (for lazy loading)
+  std::vector<Cluster*> clusters;
+  struct ProcEntry
+  {
+    unsigned	offset;								///< Of the body (0 for LibProcs)
+    unsigned	length;
+    bool		loaded;
+    std::vector<Statement*> stmts;					///< Empty until needed, then all the statements (unread)
+  };
+  std::vector<ProcEntry> directory;
+  std::vector<BasicBlock*> bbs;						///< BBs of the proc being read
+  std::vector<RTL*> rtls;
+  std::list<std::pair<DefCollector*, Assign*> > pendingDefs;	///< Can only be inserted once the Assign is read
+
+  bool		map(const char* fname);
+  void		unmap();
+  unsigned char getByte()
+  {
+    if (in < inEnd) return *in++;
+    bad = true;
+    return 0;
+  }
+  unsigned	getNum();
+  unsigned	getCount();								///< A number of following items, checked against the input left
+  int			getSNum();
+  QWord		getQWord();
+  double		getDouble();
+  const std::string& getString();
+  bool		getBool()
+  {
+    return getByte() != 0;
+  }
+  Proc*		getProc();
+  Statement*	getStmt();
+  void		getStmtList(StatementList& sl);
+  BasicBlock*	getBB();
+  Type*		getType();
+  void		getTypeDef(unsigned i);
+  Exp*		getExp();
+  Signature*	getSignature();
+  void		getDefCollector(DefCollector& col);
+  void		getDataIntervals(DataIntervalMap& dim);
+  Cluster*	getCluster();
+  void		getProcHeader(Proc* p);
+  void		makeStatements(unsigned procNum);
+  void		getProcBody(unsigned procNum);
+  void		getStatement(Statement* s);
+  void		getBasicBlock(BasicBlock* bb);
+  void		getPool(unsigned poolOff);
+  void		getStrList(std::list<std::string>& sl);
+  Statement*	getWholeStmt();
+  void		getRTL(RTL* rtl);
+  void		getRegister(Register& reg);
+  void		getParamEntry(ParamEntry& pe);
+};
+
+#endif	// #ifndef __PROGSNAPSHOT_H__
@@ -0,0 +1,70 @@
+/*
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+/*==============================================================================
+ * FILE:	   proofcache.h
+ * OVERVIEW:   A program wide memo of the queries proved by UserProc::prove(), with statistics of the lookups and of
+ *				the invocations of the prover.
+ *				An entry is only valid while the SSA form of its procedure is unchanged (see UserProc::ssaChanged()).
+ *				Queries that could not be proved are not remembered: a later change to the statements of the
+ *				procedure or of its callees may make them provable, and not every such change calls ssaChanged().
+ *============================================================================*/
+
+#ifndef __PROOFCACHE_H__
+#define __PROOFCACHE_H__
+
+#include <iostream>
+#include <list>
+#include <map>
+
+class Exp;
+class UserProc;
+
+class ProofCache
+{
+  struct Entry
+  {
+    Exp*		query;						///< Copy of the query, as passed to prove()
+    unsigned	ssaGen;						///< UserProc::getSSAGeneration() when the query was proved
+  };
+  typedef std::pair<UserProc*, unsigned> Key;	// The procedure, and the hash of the query
+  std::map<Key, std::list<Entry> > memo;
+
+  // Statistics
+  unsigned	lookups;						///< Calls to lookup()
+  unsigned	hits;							///< Lookups answered from the memo
+  unsigned	stale;							///< Entries found but discarded because their proc has changed
+  unsigned	proverCalls;					///< Calls to the prover from UserProc::prove()
+
+public:
+  ProofCache();
+
+  /// Look up query for proc. Returns true if it has been proved, and the proc has not changed since
+  bool		lookup(UserProc* proc, Exp* query);
+  /// Remember that query has been proved for proc. The memo keeps query, so it must not be changed afterwards
+  void		store(UserProc* proc, Exp* query);
+  /// Count a top level invocation of the prover (whether or not the memo is in use)
+  void		countProverCall()
+  {
+    proverCalls++;
+  }
+  unsigned	getNumProverCalls()
+  {
+    return proverCalls;
+  }
+  /// Forget what is known about proc (e.g. when it is removed from the program)
+  void		forget(UserProc* proc);
+  /// Forget everything
+  void		clear();
+
+  void		printStatistics(std::ostream& os);
+
+  /// Hash an expression; equal expressions (operator==) hash to the same value. Not suitable for wildcards
+  static unsigned hash(Exp* e);
+};
+
+#endif	// #ifndef __PROOFCACHE_H__
@@ -188,6 +188,7 @@ class RTL
   protected:
 
     friend class XMLProgParser;
+    friend class ProgSnapshot;
   };
 
 
@@ -274,12 +275,28 @@ class RTLInstDict
     // dictionary.
     bool	readSSLFile(const std::string& SSLFileName);
 
+    // The dictionary for the given SSL file, read on the first call and shared by all later callers (i.e. the
+    // decoders). The dictionary is not changed by instantiating RTLs (the templates are copied), so this is safe
+    static RTLInstDict* getDict(const std::string& SSLFileName);
+    // Delete the dictionaries kept by getDict(), when no decoder uses them any more
+    static void	freeDicts();
+
     // Reset the object to "undo" a readSSLFile()
     void	reset();
 
     // Return the signature of the given instruction.
     std::pair<std::string,unsigned> getSignature(const char* name);
 
+    // Return a small integer that identifies the instruction with the given (decoder) name, as for getSignature(),
+    // or -1 if the dictionary is empty. Only the first lookup of a name involves any string operations; after that,
+    // the name is found by its address, so name must never be modified (it is a literal in the generated decoders).
+    int		getInstructionId(const char* name);
+    // The number of operands taken by the instruction with the given id
+    unsigned	getNumOperands(int id)
+    {
+      return idTable[id]->params.size();
+    }
+
     // Appends an RTL to an idict entry, or Adds it to idict if an entry does not already exist. A non-zero return
     // indicates failure.
     int appendToDict(std::string &n, std::list<std::string>& p, RTL& rtl);
@@ -287,6 +304,8 @@ class RTLInstDict
     // Given an instruction name and list of actual parameters, return an instantiated RTL for the corresponding
     // instruction entry.
     std::list<Statement*>* instantiateRTL(std::string& name, ADDRESS natPC, std::vector<Exp*>& actuals);
+    // As above, but for the instruction with the given id (from getInstructionId())
+    std::list<Statement*>* instantiateRTL(int id, ADDRESS natPC, std::vector<Exp*>& actuals);
     // As above, but takes an RTL & param list directly rather than doing a table lookup by name.
     std::list<Statement*>* instantiateRTL(RTL& rtls, ADDRESS natPC, std::list<std::string> &params,
                                           std::vector<Exp*>& actuals);
@@ -339,6 +358,10 @@ class RTLInstDict
     // The actual dictionary.
     std::map<std::string, TableEntry, std::less<std::string> > idict;
 
+    // The idict entries by instruction id, and a map from decoder name (by address) to instruction id
+    std::vector<TableEntry*> idTable;
+    std::map<const char*, int> nameToId;
+
     // An RTL describing the machine's basic fetch-execute cycle
     RTL *fetchExecCycle;
 
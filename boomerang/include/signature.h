@@ -90,6 +90,7 @@ class Parameter
 
   protected:
     friend		class XMLProgParser;
+    friend		class ProgSnapshot;
     Parameter() : type(NULL), name(""), exp(NULL)
     { }
   };		// class Parameter
@@ -110,6 +111,7 @@ class Return
     Return() : type(NULL), exp(NULL)
     { }
     friend class XMLProgParser;
+    friend class ProgSnapshot;
   }
 ;		// class Return
 
@@ -392,6 +394,7 @@ class Signature
 
   protected:
     friend class XMLProgParser;
+    friend class ProgSnapshot;
     Signature() : name(""), rettype(NULL), ellipsis(false), preferedReturn(NULL), preferedName("")
     { }
     void		appendParameter(Parameter *p)
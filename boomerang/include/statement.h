@@ -503,6 +503,7 @@ public:
   bool		mayAlias(Exp *e1, Exp *e2, int size);
 
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;		// class Statement
 
@@ -627,6 +628,7 @@ public:
   void		dfaTypeAnalysis(bool& ch);
 
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;		// class Assignment
 
@@ -735,6 +737,7 @@ public:
   bool match(const char *pattern, std::map<std::string, Exp*> &bindings);
 
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;	// class Assign
 
@@ -865,6 +868,7 @@ public:
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;		// class PhiAssign
 
@@ -997,6 +1001,7 @@ public:
   virtual void		dfaTypeAnalysis(bool& ch);
 
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;	// class BoolAssign
 
@@ -1044,6 +1049,7 @@ public:
   virtual	void		simplify();
   virtual	void		print(std::ostream& os, bool html = false);
 
+  friend class ProgSnapshot;
 }
 ;	// class ImpRefStatement
 
@@ -1122,6 +1128,7 @@ public:
   virtual bool		usesExp(Exp*);
 
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;		// class GotoStatement
 
@@ -1286,6 +1293,7 @@ public:
   void		dfaTypeAnalysis(bool& ch);
 
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;		// class BranchStatement
 
@@ -1299,7 +1307,8 @@ struct SWITCH_INFO
   char		chForm;			// Switch form: 'A', 'O', 'R', 'H', or 'F' etc
   int			iLower;			// Lower bound of the switch variable
   int			iUpper;			// Upper bound for the switch variable
-  ADDRESS		uTable;			// Native address of the table, or ptr to array of values for form F
+  ADDRESS		uTable;			// Native address of the table (not form F)
+  int*		pValues;		// The case values, in the order of the out edges (form F only)
   int			iNumTable;		// Number of entries in the table (form H only)
   int			iOffset;		// Distance from jump to table (form R only)
   //int		delta;			// Host address - Native address
@@ -1345,6 +1354,7 @@ public:
   virtual void		simplify();
 
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;		// class CaseStatement
 
@@ -1567,6 +1577,7 @@ protected:
     arguments.append(as);
   }
   friend	class		XMLProgParser;
+  friend	class		ProgSnapshot;
 }
 ;		// class CallStatement
 
@@ -1721,6 +1732,7 @@ public:
   // void		specialProcessing();
 
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;	// class ReturnStatement
 
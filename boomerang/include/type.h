@@ -77,8 +77,22 @@ class Type
 {
 protected:
   eType		id;
+  // True if this is the one shared instance of its type in the interned type universe (see intern()). Interned
+  // types must never be modified; meetWith() works on a copy if it would have to change one
+  bool		interned;
+  Type*		meetInterned(Type* other, bool& ch, bool bHighestPtr);
+  // Changed whenever a type may have changed size in place (a sized type resized, an array's base or length changed,
+  // a member added to a compound or union, or a named type defined). Compounds keep their offsets until it changes
+  static	unsigned sizeGeneration;
+  static void			sizeChanged()
+  {
+    sizeGeneration++;
+  }
 private:
   static	std::map<std::string, Type*> namedTypes;
+  static	std::map<std::string, Type*> internedTypes;
+  typedef std::pair<std::pair<Type*, Type*>, bool> MeetKey;		// this, other, bHighestPtr
+  static	std::map<MeetKey, std::pair<Type*, bool> > meetMemo;	// Result and change of meeting two interned types
 
 public:
   // Constructors
@@ -92,6 +106,15 @@ public:
   static void			addNamedType(const char *name, Type *type);
   static Type			*getNamedType(const char *name);
 
+  // Return the shared, immutable instance equal to ty, which must be newly allocated and is not used afterwards.
+  // Only void, boolean, char, sized integer and float types, and pointers to these, are interned; anything else
+  // (and everything if interning is turned off) is returned unchanged
+  static Type*		intern(Type* ty);
+  bool		isInterned() const
+  {
+    return interned;
+  }
+
   // Return type for given temporary variable name
   static Type*		getTempType(const std::string &name);
   static Type*		parseType(const char *str); // parse a C type
@@ -272,6 +295,7 @@ public:
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;	// class Type
 
@@ -301,6 +325,7 @@ public:
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 };
 
 class FuncType : public Type
@@ -343,6 +368,7 @@ public:
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 };
 
 class IntegerType : public Type
@@ -374,6 +400,9 @@ public:
   virtual unsigned	getSize() const;			// Get size in bits
   virtual void		setSize(int sz)
   {
+    assert(!interned);
+    if (size != sz)
+      sizeChanged();
     size = sz;
   }
   // Is it signed? 0=unknown, pos=yes, neg = no
@@ -388,11 +417,13 @@ public:
   // A hint for signedness
   void		bumpSigned(int sg)
   {
+    assert(!interned);
     signedness += sg;
   }
   // Set absolute signedness
   void		setSigned(int sg)
   {
+    assert(!interned);
     signedness = sg;
   }
   // Get the signedness
@@ -411,6 +442,7 @@ public:
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;	// class IntegerType
 
@@ -437,6 +469,9 @@ public:
   virtual unsigned	getSize() const;
   virtual void		setSize(int sz)
   {
+    assert(!interned);
+    if (size != sz)
+      sizeChanged();
     size = sz;
   }
 
@@ -449,6 +484,7 @@ public:
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;	// class FloatType
 
@@ -478,6 +514,7 @@ public:
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 };
 
 class CharType : public Type
@@ -506,6 +543,7 @@ public:
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 };
 
 class PointerType : public Type
@@ -550,6 +588,7 @@ public:
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;	// class PointerType
 
@@ -579,6 +618,8 @@ public:
   }
   void		setLength(unsigned n)
   {
+    if (length != n)
+      sizeChanged();
     length = n;
   }
   bool		isUnbounded() const;
@@ -603,6 +644,7 @@ public:
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
   ArrayType() : Type(eArray), base_type(NULL), length(0)
   { }
 };	// class ArrayType
@@ -644,6 +686,7 @@ public:
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;		// class NamedType
 
@@ -655,6 +698,28 @@ private:
   std::vector<std::string> names;
   int			nextGenericMemberNum;
   bool		generic;
+
+  // Layout index, built on demand. offsets[i] is the bit offset of member i, and offsets[types.size()] is the size
+  // of the whole compound. nameIndex maps each member name to the index of its first member.
+  // Members can change size in place (e.g. IntegerType::setSize(), or meetWith() in type analysis) without the
+  // compound knowing, so unless every member has a fixed size (see buildLayout()), the offsets are summed again
+  // when Type::sizeGeneration has changed since they were last built
+  mutable std::vector<unsigned> offsets;
+  mutable std::map<std::string, unsigned> nameIndex;
+  mutable bool layoutValid;				// False after the members or their names have changed
+  mutable bool fixedSizes;				// True if every member had a fixed size when the layout was built
+  mutable unsigned offsetsGeneration;		// The value of sizeGeneration when the offsets were built
+  void		buildLayout() const;
+  void		buildOffsets() const;
+  void		checkLayout() const
+  {
+    if (!layoutValid)
+      buildLayout();
+    else if (!fixedSizes && offsetsGeneration != sizeGeneration)
+      buildOffsets();
+  }
+  unsigned	memberAt(unsigned n) const;		// Index of the member containing bit offset n; types.size() if none
+  int			memberNamed(const char* nam) const;	// Index of the first member called nam; -1 if none
 public:
   CompoundType(bool generic = false);
   virtual				~CompoundType();
@@ -670,6 +735,8 @@ public:
     if ( t ) n = t;
     types.push_back(n);
     names.push_back(str);
+    layoutValid = false;
+    sizeChanged();
   }
   unsigned	getNumTypes()
   {
@@ -722,6 +789,7 @@ public:
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;	// class CompoundType
 
@@ -778,6 +846,7 @@ public:
 
 protected:
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;	// class UnionType
 
@@ -803,6 +872,8 @@ public:
   virtual unsigned	getSize() const;
   virtual void		setSize(unsigned sz)
   {
+    if (size != sz)
+      sizeChanged();
     size = sz;
   }
   virtual bool		isSize() const
@@ -818,6 +889,7 @@ public:
   virtual bool		isCompatible(Type* other, bool all);
 
   friend class XMLProgParser;
+  friend class ProgSnapshot;
 }
 ;	// class SizeType
 
@@ -844,6 +916,7 @@ public:
   void		setBaseType(Type *b)
   {
     base_type = b;
+    sizeChanged();
   }
 
   virtual unsigned	getSize() const
@@ -888,6 +961,7 @@ public:
   void		setBaseType(Type *b)
   {
     base_type = b;
+    sizeChanged();
   }
 
   virtual unsigned	getSize() const
@@ -956,6 +1030,8 @@ private:
   void enterComponent(DataIntervalEntry* pdie, ADDRESS addr, const char* name, Type* ty, bool forced);
   void replaceComponents(ADDRESS addr, const char* name, Type* ty, bool forced);
   void checkMatching(DataIntervalEntry* pdie, ADDRESS addr, const char* name, Type* ty, bool forced);
+
+  friend class ProgSnapshot;
 };
 
 // Not part of the Type class, but logically belongs with it:
@@ -22,6 +22,9 @@
 
 #include <iostream>
 
+bool BinaryFileFactory::keepLoaded = false;
+std::map<std::string, void*> BinaryFileFactory::loadedLibs;
+
 BinaryFile *BinaryFileFactory::Load(const char *sName)
 {
   BinaryFile *pBF = getInstanceFor(sName);
@@ -144,13 +147,20 @@ BinaryFile* BinaryFileFactory::getInstanceFor(const char *sName)
   libName += ".so";
 #endif
 #endif
-  dlHandle = dlopen(libName.c_str(), RTLD_LAZY);
-  if (dlHandle == NULL)
+  if (loadedLibs.find(libName) != loadedLibs.end())
+    dlHandle = loadedLibs[libName];
+  else
     {
-      fprintf(stderr, "Could not open dynamic loader library %s\n", libName.c_str());
-      fprintf(stderr, "%s\n", dlerror());
-      fclose(f);
-      return NULL;
+      dlHandle = dlopen(libName.c_str(), RTLD_LAZY);
+      if (dlHandle == NULL)
+        {
+          fprintf(stderr, "Could not open dynamic loader library %s\n", libName.c_str());
+          fprintf(stderr, "%s\n", dlerror());
+          fclose(f);
+          return NULL;
+        }
+      if (keepLoaded)
+        loadedLibs[libName] = dlHandle;
     }
   // Use the handle to find the "construct" function
 #if 0	// HOST_OSX_10_2	// Not sure when the underscore is really needed
@@ -164,13 +174,20 @@ BinaryFile* BinaryFileFactory::getInstanceFor(const char *sName)
 #ifdef __MINGW32__
   libName = "lib/lib" + libName;
 #endif
-  hModule = LoadLibraryA(libName.c_str());
-  if (hModule == NULL)
+  if (loadedLibs.find(libName) != loadedLibs.end())
+    hModule = loadedLibs[libName];
+  else
     {
-      int err = GetLastError();
-      fprintf(stderr, "Could not open dynamic loader library %s (error #%d)\n", libName.c_str(), err);
-      fclose(f);
-      return NULL;
+      hModule = LoadLibraryA(libName.c_str());
+      if (hModule == NULL)
+        {
+          int err = GetLastError();
+          fprintf(stderr, "Could not open dynamic loader library %s (error #%d)\n", libName.c_str(), err);
+          fclose(f);
+          return NULL;
+        }
+      if (keepLoaded)
+        loadedLibs[libName] = hModule;
     }
   // Use the handle to find the "construct" function
   constructFcn pFcn = (constructFcn) GetProcAddress((HINSTANCE) hModule, "construct");
@@ -193,6 +210,8 @@ BinaryFile* BinaryFileFactory::getInstanceFor(const char *sName)
 
 void BinaryFileFactory::UnLoad()
 {
+  if (keepLoaded)
+    return;
 #ifdef _WIN32
   FreeLibrary((HINSTANCE) hModule);
 #else
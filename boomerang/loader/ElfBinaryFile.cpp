@@ -38,6 +38,7 @@
 #include <iostream>
 #include <cassert>
 #include <cstring>
+#include <algorithm>
 #include "config.h"
 #if defined(_MSC_VER) && _MSC_VER >= 1400
 #pragma warning(disable:4996)		// Warnings about e.g. _strdup deprecated in VS 2005
@@ -76,6 +77,8 @@ void ElfBinaryFile::Init()
   m_uPltMax = 0;
   m_iLastSize = 0;
   m_pImportStubs = 0;
+  m_SymTab.clear(); // The names point into the image
+  m_relocAddrs.clear();
 }
 
 // Hand decompiled from sparc library function
@@ -391,49 +394,54 @@ void ElfBinaryFile::AddSyms(int secIndex)
     }
   // Number of entries in the PLT:
   // int max_i_for_hack = siPlt ? (int)siPlt->uSectionSize / 0x10 : 0;
+  // The symbols are added in bulk, and sorted once at the end. The names point into the string table, except for
+  // those that need the "@@GLIBC_2.0" of Linux hacked off
+  m_SymTab.reserve(m_SymTab.size() + nSyms);
   // Index 0 is a dummy entry
   for (int i = 1; i < nSyms; i++)
     {
       ADDRESS val = (ADDRESS) elfRead4((int*) & m_pSym[i].st_value);
       int name = elfRead4(&m_pSym[i].st_name);
       if (name == 0) /* Silly symbols with no names */ continue;
-      std::string str(GetStrPtr(strIdx, name));
+      const char* str = GetStrPtr(strIdx, name);
       // Hack off the "@@GLIBC_2.0" of Linux, if present
-      unsigned pos;
-      if ((pos = str.find("@@")) != std::string::npos)
-        str.erase(pos);
-      std::map<ADDRESS, std::string>::iterator aa = m_SymTab.find(val);
-      // Ensure no overwriting (except functions)
-      if (aa == m_SymTab.end() || ELF32_ST_TYPE(m_pSym[i].st_info) == STT_FUNC)
+      const char* at = strstr(str, "@@");
+      if (at)
+        str = m_SymTab.save(std::string(str, at - str));
+      // Ensure no overwriting (except functions). Symbols whose address is adjusted below always overwrote, since the
+      // check was done on the unadjusted address
+      bool replace = ELF32_ST_TYPE(m_pSym[i].st_info) == STT_FUNC;
+      if (val == 0 && siPlt)   //&& i < max_i_for_hack) {
         {
-          if (val == 0 && siPlt)   //&& i < max_i_for_hack) {
-            {
-              // Special hack for gcc circa 3.3.3: (e.g. test/pentium/settest).  The value in the dynamic symbol table
-              // is zero!  I was assuming that index i in the dynamic symbol table would always correspond to index i
-              // in the .plt section, but for fedora2_true, this doesn't work. So we have to look in the .rel[a].plt
-              // section. Thanks, gcc!  Note that this hack can cause strange symbol names to appear
-              val = findRelPltOffset(i, addrRelPlt, sizeRelPlt, numRelPlt, addrPlt);
-            }
-          else if (e_type == E_REL)
+          // Special hack for gcc circa 3.3.3: (e.g. test/pentium/settest).  The value in the dynamic symbol table
+          // is zero!  I was assuming that index i in the dynamic symbol table would always correspond to index i
+          // in the .plt section, but for fedora2_true, this doesn't work. So we have to look in the .rel[a].plt
+          // section. Thanks, gcc!  Note that this hack can cause strange symbol names to appear
+          val = findRelPltOffset(i, addrRelPlt, sizeRelPlt, numRelPlt, addrPlt);
+          replace = true;
+        }
+      else if (e_type == E_REL)
+        {
+          int nsec = elfRead2(&m_pSym[i].st_shndx);
+          if (nsec >= 0 && nsec < m_iNumSections)
             {
-              int nsec = elfRead2(&m_pSym[i].st_shndx);
-              if (nsec >= 0 && nsec < m_iNumSections)
-                val += GetSectionInfo(nsec)->uNativeAddr;
+              val += GetSectionInfo(nsec)->uNativeAddr;
+              replace = true;
             }
+        }
 
 #define ECHO_SYMS 0
 #if		ECHO_SYMS
-          std::cerr << "Elf AddSym: about to add " << str << " to address " << std::hex << val << std::dec << "\n";
+      std::cerr << "Elf AddSym: about to add " << str << " to address " << std::hex << val << std::dec << "\n";
 #endif
-          m_SymTab[val] = str;
-        }
+      m_SymTab.add(val, str, replace);
     }
+  m_SymTab.sort();
   ADDRESS uMain = GetMainEntryPoint();
-  if (uMain != NO_ADDRESS && m_SymTab.find(uMain) == m_SymTab.end())
+  if (uMain != NO_ADDRESS && m_SymTab.find(uMain) == NULL)
     {
       // Ugh - main mustn't have the STT_FUNC attribute. Add it
-      std::string sMain("main");
-      m_SymTab[uMain] = sMain;
+      m_SymTab.set(uMain, "main");
     }
   return;
 }
@@ -531,19 +539,15 @@ void ElfBinaryFile::AddRelocsAsSyms(int relSecIdx)
       unsigned pos;
       if ((pos = str.find("@@")) != std::string::npos)
         str.erase(pos);
-      std::map<ADDRESS, std::string>::iterator it;
-      // Linear search!
-      for (it = m_SymTab.begin(); it != m_SymTab.end(); it++)
-        if ((*it).second == str)
-          break;
+      ADDRESS a = m_SymTab.find(str.c_str());
       // Add new extern
-      if (it == m_SymTab.end())
+      if (a == NO_ADDRESS)
         {
-          m_SymTab[next_extern] = str;
-          it = m_SymTab.find(next_extern);
+          a = next_extern;
+          m_SymTab.set(a, m_SymTab.save(str));
           next_extern += 4;
         }
-      writeNative4(val, (*it).first - val - 4);
+      writeNative4(val, a - val - 4);
     }
   return;
 }
@@ -552,10 +556,7 @@ void ElfBinaryFile::AddRelocsAsSyms(int relSecIdx)
 
 const char* ElfBinaryFile::SymbolByAddress(const ADDRESS dwAddr)
 {
-  std::map<ADDRESS, std::string>::iterator aa = m_SymTab.find(dwAddr);
-  if (aa == m_SymTab.end())
-    return 0;
-  return (char*) aa->second.c_str();
+  return m_SymTab.find(dwAddr);
 }
 
 bool ElfBinaryFile::ValueByName(const char* pName, SymValue* pVal, bool bNoTypeOK /* = false */)
@@ -925,46 +926,26 @@ size_t ElfBinaryFile::getImageSize()
 /*==============================================================================
  * FUNCTION:	  ElfBinaryFile::GetImportStubs
  * OVERVIEW:	  Get an array of addresses of imported function stubs
- *					This function relies on the fact that the symbols are sorted by address, and that Elf PLT
- *					entries have successive addresses beginning soon after m_PltMin
+ *					These are the symbols in the PLT, which is from m_uPltMin to m_uPltMax; m_uPltMin is always
+ *					the first
  * PARAMETERS:	  numImports - reference to integer set to the number of these
  * RETURNS:		  An array of native ADDRESSes
  *============================================================================*/
 ADDRESS* ElfBinaryFile::GetImportStubs(int& numImports)
 {
-  ADDRESS a = m_uPltMin;
-  int n = 0;
-  std::map<ADDRESS, std::string>::iterator aa = m_SymTab.find(a);
-  std::map<ADDRESS, std::string>::iterator ff = aa;
-  bool delDummy = false;
-  if (aa == m_SymTab.end())
-    {
-      // Need to insert a dummy entry at m_uPltMin
-      delDummy = true;
-      m_SymTab[a] = std::string();
-      ff = m_SymTab.find(a);
-      aa = ff;
-      aa++;
-    }
-  while ((aa != m_SymTab.end()) && (a < m_uPltMax))
-    {
-      n++;
-      a = aa->first;
-      aa++;
-    }
+  SymbolIndex::const_iterator first = m_SymTab.lowerBound(m_uPltMin);
+  SymbolIndex::const_iterator last = m_SymTab.lowerBound(m_uPltMax);
+  int n = last - first;
+  if (first == last || first->addr != m_uPltMin)
+    n++; // No symbol at m_uPltMin
   // Allocate an array of ADDRESSESes
+  delete [] m_pImportStubs;
   m_pImportStubs = new ADDRESS[n];
-  aa = ff; // Start at first
-  a = aa->first;
   int i = 0;
-  while ((aa != m_SymTab.end()) && (a < m_uPltMax))
-    {
-      m_pImportStubs[i++] = a;
-      a = aa->first;
-      aa++;
-    }
-  if (delDummy)
-    m_SymTab.erase(ff); // Delete dummy entry
+  if (first == last || first->addr != m_uPltMin)
+    m_pImportStubs[i++] = m_uPltMin;
+  for (; first != last; first++)
+    m_pImportStubs[i++] = first->addr;
   numImports = n;
   return m_pImportStubs;
 }
@@ -1249,13 +1230,18 @@ void ElfBinaryFile::applyRelocations()
                   unsigned symTabIndex = info >> 8;
                   int* pRelWord; // Pointer to the word to be relocated
                   if (e_type == E_REL)
-                    pRelWord = ((int*) (destHostOrigin + r_offset));
+                    {
+                      pRelWord = ((int*) (destHostOrigin + r_offset));
+                      m_relocAddrs.push_back(destNatOrigin + r_offset);
+                    }
                   else
                     {
                       if (r_offset == 0) continue;
                       SectionInfo* destSec = GetSectionInfoByAddr(r_offset);
                       pRelWord = (int*) (destSec->uHostAddr - destSec->uNativeAddr + r_offset);
                       destNatOrigin = 0;
+                      // As IsRelocationAt() has always done it
+                      m_relocAddrs.push_back(destSec->uNativeAddr + r_offset);
                     }
                   ADDRESS A, S = 0, P;
                   int nsec;
@@ -1298,7 +1284,7 @@ void ElfBinaryFile::applyRelocations()
                               //S = GetAddressByName(pName);
                               //if (S == (e_type == E_REL ? 0x8000000 : 0)) {
                               S = nextFakeLibAddr--; // Allocate a new fake address
-                              AddSymbol(S, pName);
+                              m_SymTab.set(S, pName);
                               //}
                             }
                           else if (e_type == E_REL)
@@ -1326,8 +1312,19 @@ void ElfBinaryFile::applyRelocations()
     default:
       break; // Not implemented
     }
+  // Sorted for IsRelocationAt()
+  std::sort(m_relocAddrs.begin(), m_relocAddrs.end());
+  m_relocAddrs.erase(std::unique(m_relocAddrs.begin(), m_relocAddrs.end()), m_relocAddrs.end());
 }
 
+// Called for every constant in the program (see Prog::addReloc), so the relocated addresses are collected once by
+// applyRelocations()
+bool ElfBinaryFile::IsRelocationAt(ADDRESS uNative)
+{
+  return std::binary_search(m_relocAddrs.begin(), m_relocAddrs.end(), uNative);
+}
+
+#if 0	// The linear search that m_relocAddrs replaces
 bool ElfBinaryFile::IsRelocationAt(ADDRESS uNative)
 {
   //int nextFakeLibAddr = -2;			// See R_386_PC32 below; -1 sometimes used for main
@@ -1394,6 +1391,7 @@ bool ElfBinaryFile::IsRelocationAt(ADDRESS uNative)
     }
   return false;
 }
+#endif
 
 const char *ElfBinaryFile::getFilenameSymbolFor(const char *sym)
 {
@@ -1529,14 +1527,14 @@ void ElfBinaryFile::getFunctionSymbols(std::map<std::string, std::map<ADDRESS, s
 
 void ElfBinaryFile::AddSymbol(ADDRESS uNative, const char *pName)
 {
-  m_SymTab[uNative] = pName;
+  m_SymTab.set(uNative, m_SymTab.save(pName));
 }
 
 void ElfBinaryFile::dumpSymbols()
 {
-  std::map<ADDRESS, std::string>::iterator it;
+  SymbolIndex::const_iterator it;
   std::cerr << std::hex;
   for (it = m_SymTab.begin(); it != m_SymTab.end(); ++it)
-    std::cerr << "0x" << it->first << " " << it->second << "        ";
+    std::cerr << "0x" << it->addr << " " << it->name << "        ";
   std::cerr << std::dec << "\n";
 }
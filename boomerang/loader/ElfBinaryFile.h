@@ -26,7 +26,7 @@
  *============================================================================*/
 
 #include "BinaryFile.h"
-#include "SymTab.h"					// For SymTab (probably unused)
+#include "SymTab.h"					// For SymbolIndex
 typedef std::map<ADDRESS, std::string, std::less<ADDRESS> > RelocMap;
 
 typedef struct
@@ -256,7 +256,7 @@ public:
 
   virtual std::map<ADDRESS, std::string> &getSymbols()
   {
-    return m_SymTab;
+    return m_SymTab.getMap();
   }
 
   virtual void getFunctionSymbols(std::map<std::string, std::map<ADDRESS, std::string> > &syms_in_file);
@@ -299,9 +299,10 @@ private:
   Elf32_Shdr* m_pShdrs; // Array of section header structs
   char* m_pStrings; // Pointer to the string section
   char m_elfEndianness; // 1 = Big Endian
-  std::map<ADDRESS, std::string> m_SymTab; // Map from address to symbol name; contains symbols from the
+  SymbolIndex m_SymTab; // Map from address to symbol name; contains symbols from the
   // various elf symbol tables, and possibly some symbols with fake
   // addresses
+  std::vector<ADDRESS> m_relocAddrs; // Sorted native addresses of the relocated words
   SymTab m_Reloc; // Object to store the reloc syms
   Elf32_Rel* m_pReloc; // Pointer to the relocation section
   Elf32_Sym* m_pSym; // Pointer to loaded symbol section
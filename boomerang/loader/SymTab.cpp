@@ -19,6 +19,8 @@
 */
 
 #include "SymTab.h"
+#include <algorithm>
+#include <cstring>
 
 SymTab::SymTab()
 {}
@@ -50,3 +52,167 @@ ADDRESS SymTab::find(const char* s)
   return ff->second;
 }
 
+
+/*==============================================================================
+ * SymbolIndex
+ *============================================================================*/
+
+namespace
+{
+  struct EntryAddrLess
+  {
+    bool operator()(const SymbolIndex::Entry& a, const SymbolIndex::Entry& b) const
+    {
+      return a.addr < b.addr;
+    }
+    bool operator()(const SymbolIndex::Entry& a, ADDRESS b) const
+    {
+      return a.addr < b;
+    }
+  };
+
+  struct IndexNameLess
+  {
+    const std::vector<SymbolIndex::Entry>& entries;
+    IndexNameLess(const std::vector<SymbolIndex::Entry>& e) : entries(e) { }
+    bool operator()(unsigned a, unsigned b) const
+    {
+      int cmp = strcmp(entries[a].name, entries[b].name);
+      return cmp < 0 || (cmp == 0 && a < b);
+    }
+    bool operator()(unsigned a, const char* b) const
+    {
+      return strcmp(entries[a].name, b) < 0;
+    }
+  };
+}
+
+void SymbolIndex::add(ADDRESS a, const char* name, bool replace)
+{
+  Entry e;
+  e.addr = a;
+  e.name = name;
+  e.replace = replace;
+  if (sorted && !entries.empty() && entries.back().addr >= a)
+    sorted = false;
+  entries.push_back(e);
+  changed();
+}
+
+void SymbolIndex::sort()
+{
+  if (sorted)
+    return;
+  // Stable, so that the entries for one address stay in the order they were added
+  std::stable_sort(entries.begin(), entries.end(), EntryAddrLess());
+  std::vector<Entry>::iterator out = entries.begin();
+  for (std::vector<Entry>::iterator it = entries.begin(); it != entries.end(); it++)
+    {
+      if (out != entries.begin() && (out-1)->addr == it->addr)
+        {
+          if (it->replace)
+            (out-1)->name = it->name;
+          continue;
+        }
+      *out++ = *it;
+    }
+  entries.erase(out, entries.end());
+  sorted = true;
+  changed();
+}
+
+SymbolIndex::const_iterator SymbolIndex::lowerBound(ADDRESS a) const
+{
+  return std::lower_bound(entries.begin(), entries.end(), a, EntryAddrLess());
+}
+
+void SymbolIndex::set(ADDRESS a, const char* name)
+{
+  if (!sorted)
+    {
+      add(a, name, true);
+      return;
+    }
+  std::vector<Entry>::iterator it = std::lower_bound(entries.begin(), entries.end(), a, EntryAddrLess());
+  if (it != entries.end() && it->addr == a)
+    it->name = name;
+  else
+    {
+      Entry e;
+      e.addr = a;
+      e.name = name;
+      e.replace = true;
+      entries.insert(it, e);
+    }
+  changed();
+}
+
+void SymbolIndex::remove(ADDRESS a)
+{
+  sort();
+  std::vector<Entry>::iterator it = std::lower_bound(entries.begin(), entries.end(), a, EntryAddrLess());
+  if (it != entries.end() && it->addr == a)
+    {
+      entries.erase(it);
+      changed();
+    }
+}
+
+const char* SymbolIndex::save(const char* name)
+{
+  saved.push_back(name);
+  return saved.back().c_str();
+}
+
+void SymbolIndex::clear()
+{
+  entries.clear();
+  saved.clear();
+  sorted = true;
+  changed();
+}
+
+const char* SymbolIndex::find(ADDRESS a)
+{
+  sort();
+  const_iterator it = lowerBound(a);
+  if (it == entries.end() || it->addr != a)
+    return NULL;
+  return it->name;
+}
+
+ADDRESS SymbolIndex::find(const char* name)
+{
+  sort();
+  if (byName.empty() && !entries.empty())
+    {
+      byName.reserve(entries.size());
+      for (unsigned i=0; i < entries.size(); i++)
+        byName.push_back(i);
+      std::sort(byName.begin(), byName.end(), IndexNameLess(entries));
+    }
+  // The lowest address with this name, as for a linear search
+  std::vector<unsigned>::iterator it = std::lower_bound(byName.begin(), byName.end(), name, IndexNameLess(entries));
+  if (it == byName.end() || strcmp(entries[*it].name, name) != 0)
+    return NO_ADDRESS;
+  return entries[*it].addr;
+}
+
+bool SymbolIndex::hasName(ADDRESS a, const char* name)
+{
+  const char* n = find(a);
+  return n && strcmp(n, name) == 0;
+}
+
+std::map<ADDRESS, std::string>& SymbolIndex::getMap()
+{
+  if (!mapValid)
+    {
+      sort();
+      amap.clear();
+      for (const_iterator it = entries.begin(); it != entries.end(); it++)
+        amap.insert(amap.end(), std::pair<ADDRESS, std::string>(it->addr, it->name));
+      mapValid = true;
+    }
+  return amap;
+}
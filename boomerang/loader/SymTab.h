@@ -29,6 +29,8 @@
 #include "types.h"
 #include <map>
 #include <string>
+#include <vector>
+#include <list>
 
 class SymTab
 {
@@ -54,6 +56,86 @@ public:
   }
 };
 
+/*==============================================================================
+ * SymbolIndex is the symbol table of the ELF and Win32 loaders, which can have tens of thousands of symbols. It is a
+ * vector of (address, name) entries sorted by address, built in bulk: add() the symbols in any order, then sort().
+ * The names are not copied; they normally point into the string tables of the loaded image, which must outlive the
+ * index. Names that are made up by the loader must be copied with save() first.
+ * When add() gives an address more than once, the first entry is kept, unless a later one was added with replace set.
+ *============================================================================*/
+class SymbolIndex
+{
+public:
+  struct Entry
+  {
+    ADDRESS		addr;
+    const char*	name;
+    bool		replace;				// Only used until sorted
+  };
+  typedef std::vector<Entry>::const_iterator const_iterator;
+
+private:
+  std::vector<Entry> entries;			// Sorted by address, one per address, unless unsorted
+  bool		sorted;
+  std::vector<unsigned> byName;		// Indices of entries, sorted by name (then address); empty if not built yet
+  std::list<std::string> saved;		// Storage for the names given to save()
+  std::map<ADDRESS, std::string> amap;	// For getMap()
+  bool		mapValid;
+
+  void		changed()
+  {
+    byName.clear();
+    mapValid = false;
+  }
+  const_iterator lowerBound(ADDRESS a) const;
+
+public:
+  SymbolIndex() : sorted(true), mapValid(false) { }
+
+  void		reserve(unsigned n)
+  {
+    entries.reserve(n);
+  }
+  void		add(ADDRESS a, const char* name, bool replace = true);	// Add an entry; sort() before lookups
+  void		sort();									// Sort by address, and remove duplicates
+  void		set(ADDRESS a, const char* name);		// Add or replace the entry for a, keeping the order
+  void		remove(ADDRESS a);
+  const char*	save(const char* name);				// A copy of name that lives as long as the index
+  const char*	save(const std::string& name)
+  {
+    return save(name.c_str());
+  }
+  void		clear();
+
+  const char*	find(ADDRESS a);						// Find an entry by address; NULL if none
+  ADDRESS		find(const char* name);					// Find an entry by name; NO_ADDRESS if none
+  bool		hasName(ADDRESS a, const char* name);	// True if a is called name
+
+  // Iteration in address order
+  const_iterator begin()
+  {
+    sort();
+    return entries.begin();
+  }
+  const_iterator end()
+  {
+    return entries.end();
+  }
+  const_iterator lowerBound(ADDRESS a)				// The first entry at or after a
+  {
+    sort();
+    return ((const SymbolIndex*)this)->lowerBound(a);
+  }
+  unsigned	size()
+  {
+    sort();
+    return entries.size();
+  }
+
+  // The entries as a map, as returned by BinaryFile::getSymbols(). Built on demand, and valid until the next change
+  std::map<ADDRESS, std::string>& getMap();
+};
+
 #ifndef NULL
 #define NULL 0          // Normally in stdio.h, it seems!
 #endif
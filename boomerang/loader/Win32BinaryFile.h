@@ -16,6 +16,7 @@
 #define __WIN32BINARYFILE_H_
 
 #include "BinaryFile.h"
+#include "SymTab.h"
 #include <string>
 
 /* $Revision: 1.20 $
@@ -232,7 +233,7 @@ public:
 
   virtual std::map<ADDRESS, std::string> &getSymbols()
   {
-    return dlprocptrs;
+    return dlprocptrs.getMap();
   }
 
   bool		hasDebugInfo()
@@ -255,7 +256,7 @@ private:
   DWord*		m_pRelocTable;			// The relocation table
   char *		base;					// Beginning of the loaded image
   // Map from address of dynamic pointers to library procedure names:
-  std::map<ADDRESS, std::string> dlprocptrs;
+  SymbolIndex	dlprocptrs;
   const char	*m_pFileName;
   bool		haveDebugInfo;
   bool        mingw_main;
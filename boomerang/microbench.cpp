@@ -0,0 +1,315 @@
+/*
+ * See the file "LICENSE.TERMS" for information on usage and
+ * redistribution of this file, and for a DISCLAIMER OF ALL
+ * WARRANTIES.
+ *
+ */
+
+/*==============================================================================
+ * FILE:	   microbench.cpp
+ * OVERVIEW:   Microbenchmarks of the core operations on expressions and statements, which dominate the profiles of
+ *				the decompiler: building, cloning, comparing and hashing Exps, simplify(), LocationSet operations,
+ *				and RTLInstDict::instantiateRTL() for common Pentium instructions.
+ *
+ *				Usage: MicroBench [-r reps] [-s scale] [<boomerang dir> [<benchmark>]]
+ *				As for UnitTester, the first argument is the directory with the frontend/machine files. Every
+ *				benchmark does a fixed amount of work (times scale) on fixed inputs, and is repeated reps times; the
+ *				best and the median time per operation are reported. The check column is computed from the results
+ *				of the operations, and must not change when an optimisation is measured.
+ *
+ *				Nothing is freed: expressions are garbage collected (or leaked without the collector), as in the
+ *				rest of the decompiler.
+ *============================================================================*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <list>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include "config.h"
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#else
+#include <direct.h>
+#endif
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+#include "types.h"
+#include "exp.h"
+#include "managed.h"
+#include "statement.h"
+#include "rtl.h"
+#include "proofcache.h"
+#include "boomerang.h"
+#include "log.h"
+
+static unsigned check;			// The results of the operations are folded into this, so that none can be optimised away
+
+// Expressions used by several benchmarks; see setUp()
+static Exp* largeExp;			// m[(r28 - 4) + r24 * 4] + (r25 & 255)
+static Exp* largeCopy;			// A clone of largeExp
+static Exp* largeOther;			// As largeExp, but differs in the last leaf
+static std::vector<Exp*> simplifyCases;
+static std::vector<Exp*> locs;	// 64 distinct locations
+static LocationSet evenLocs, oddLocs;
+
+// Instructions for instantiateRTL
+static RTLInstDict* pentDict;
+struct InstCase
+{
+  int		id;
+  std::vector<Exp*> actuals;
+};
+static std::vector<InstCase> instCases;
+
+static double microSeconds()
+{
+#if defined(_WIN32)
+  LARGE_INTEGER freq, now;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&now);
+  return (double)now.QuadPart * 1e6 / (double)freq.QuadPart;
+#else
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1e6 + tv.tv_usec;
+#endif
+}
+
+static Exp* memPlus(int reg, int off)
+{
+  return Location::memOf(new Binary(opPlus, Location::regOf(reg), new Const(off)));
+}
+
+static void addInst(const char* name, Exp* a = NULL, Exp* b = NULL)
+{
+  InstCase ic;
+  ic.id = pentDict->getInstructionId(name);
+  if (a) ic.actuals.push_back(a);
+  if (b) ic.actuals.push_back(b);
+  if (ic.id == -1 || pentDict->getNumOperands(ic.id) != ic.actuals.size())
+    {
+      std::cerr << "skipping instruction " << name << ": not in the SSL file, or wrong number of operands\n";
+      return;
+    }
+  instCases.push_back(ic);
+}
+
+static void setUp()
+{
+  largeExp = new Binary(opPlus,
+                        Location::memOf(new Binary(opPlus,
+                                        new Binary(opMinus, Location::regOf(28), new Const(4)),
+                                        new Binary(opMult, Location::regOf(24), new Const(4)))),
+                        new Binary(opBitAnd, Location::regOf(25), new Const(255)));
+  largeCopy = largeExp->clone();
+  largeOther = largeExp->clone();
+  ((Binary*)largeOther)->setSubExp2(new Binary(opBitAnd, Location::regOf(25), new Const(254)));
+
+  // Canonical arithmetic and memof patterns, as left by the decoder and by propagation
+  simplifyCases.push_back(new Binary(opMinus, new Binary(opPlus, Location::regOf(24), new Const(4)), new Const(4)));
+  simplifyCases.push_back(new Binary(opPlus, new Binary(opMult, Location::regOf(24), new Const(1)), new Const(0)));
+  simplifyCases.push_back(Location::memOf(new Binary(opPlus,
+                                          new Binary(opMinus, Location::regOf(28), new Const(8)), new Const(4))));
+  simplifyCases.push_back(new Binary(opPlus, new Binary(opPlus, Location::regOf(28), new Const(8)), new Const(4)));
+  simplifyCases.push_back(new Unary(opAddrOf, memPlus(28, -4)));
+  simplifyCases.push_back(new Binary(opBitXor, Location::regOf(24), Location::regOf(24)));
+  simplifyCases.push_back(new Binary(opMinus, new Const(0),
+                                     new Binary(opMinus, Location::regOf(24), Location::regOf(25))));
+  simplifyCases.push_back(Location::memOf(new Binary(opPlus, new Binary(opPlus,
+                                          new Binary(opMult, Location::regOf(26), new Const(4)), new Const(8)),
+                                          new Binary(opMinus, Location::regOf(28), new Const(12)))));
+
+  int i;
+  for (i=0; i < 32; i++)
+    locs.push_back(Location::regOf(i));
+  for (i=1; i <= 32; i++)
+    locs.push_back(memPlus(28, -4 * i));
+  for (i=0; i < (int)locs.size(); i++)
+    (i & 1 ? oddLocs : evenLocs).insert(locs[i]);
+
+  pentDict = new RTLInstDict();
+  if (!pentDict->readSSLFile(Boomerang::get()->getProgPath() + "frontend/machine/pentium/pentium.ssl"))
+    {
+      std::cerr << "cannot read the Pentium SSL file; the instantiateRTL benchmark is skipped\n";
+      return;
+    }
+  addInst("MOVrmod", Location::regOf(24), memPlus(29, -8));
+  addInst("MOVmrod", memPlus(29, -8), Location::regOf(24));
+  addInst("ADDrmod", Location::regOf(24), Location::regOf(25));
+  addInst("ADDiodb", Location::regOf(28), new Const(16));
+  addInst("PUSHod", Location::regOf(29));
+  addInst("CALL.Jvod", new Const(0x8048400));
+}
+
+static void benchConstruct(unsigned n)
+{
+  for (unsigned i=0; i < n; i++)
+    check += memPlus(28, i & 0xff)->getOper();
+}
+
+static void benchClone(unsigned n)
+{
+  for (unsigned i=0; i < n; i++)
+    check += largeExp->clone()->getSubExp1()->getOper();
+}
+
+static void benchEqual(unsigned n)
+{
+  for (unsigned i=0; i < n; i++)
+    check += (*largeExp == *largeCopy) + (*largeExp == *largeOther);
+}
+
+static void benchLess(unsigned n)
+{
+  for (unsigned i=0; i < n; i++)
+    check += (*largeExp < *largeOther) + (*largeOther < *largeExp);
+}
+
+static void benchHash(unsigned n)
+{
+  for (unsigned i=0; i < n; i++)
+    check += ProofCache::hash(largeExp);
+}
+
+static void benchSimplify(unsigned n)
+{
+  unsigned num = simplifyCases.size();
+  for (unsigned i=0; i < n; i++)
+    {
+      Exp* e = simplifyCases[i % num]->clone();
+      check += e->simplify()->getOper();
+    }
+}
+
+static void benchLocSetInsert(unsigned n)
+{
+  for (unsigned i=0; i < n; i++)
+    {
+      LocationSet ls;
+      for (unsigned j=0; j < locs.size(); j++)
+        ls.insert(locs[(j * 37 + i) % locs.size()]);
+      check += ls.size();
+    }
+}
+
+static void benchLocSetExists(unsigned n)
+{
+  for (unsigned i=0; i < n; i++)
+    check += evenLocs.exists(locs[i % locs.size()]);
+}
+
+static void benchLocSetUnion(unsigned n)
+{
+  for (unsigned i=0; i < n; i++)
+    {
+      LocationSet ls(evenLocs);
+      ls.makeUnion(oddLocs);
+      check += ls.size();
+    }
+}
+
+static void benchInstantiate(unsigned n)
+{
+  unsigned num = instCases.size();
+  if (num == 0)
+    return;
+  for (unsigned i=0; i < n; i++)
+    {
+      InstCase& ic = instCases[i % num];
+      std::list<Statement*>* stmts = pentDict->instantiateRTL(ic.id, 0x8048000 + i, ic.actuals);
+      check += stmts->size();
+      delete stmts;
+    }
+}
+
+struct Benchmark
+{
+  const char*	name;
+  void		(*func)(unsigned n);
+  unsigned	ops;						///< Operations per repetition (before scaling)
+};
+
+static Benchmark benchmarks[] =
+{
+  {"ExpConstruct", benchConstruct, 200000},
+  {"ExpClone", benchClone, 200000},
+  {"ExpEqual", benchEqual, 500000},
+  {"ExpLess", benchLess, 500000},
+  {"ExpHash", benchHash, 500000},
+  {"ExpSimplify", benchSimplify, 100000},		// Includes a clone of each case, see ExpClone
+  {"LocationSetInsert", benchLocSetInsert, 5000},
+  {"LocationSetExists", benchLocSetExists, 500000},
+  {"LocationSetUnion", benchLocSetUnion, 5000},
+  {"InstantiateRTL", benchInstantiate, 100000},
+  {NULL, NULL, 0}
+};
+
+int main(int argc, char* argv[])
+{
+  int reps = 5;
+  double scale = 1.0;
+  int i = 1;
+  for (; i < argc && argv[i][0] == '-'; i++)
+    {
+      if (i+1 == argc)
+        break;
+      if (argv[i][1] == 'r')
+        reps = atoi(argv[++i]);
+      else if (argv[i][1] == 's')
+        scale = atof(argv[++i]);
+      else
+        break;
+    }
+  if (i < argc && argv[i][0] == '-')
+    {
+      std::cerr << "usage: " << argv[0] << " [-r reps] [-s scale] [<boomerang dir> [<benchmark>]]\n";
+      return 1;
+    }
+  if (reps < 1)
+    reps = 1;
+  if (i < argc)
+    chdir(argv[i++]);
+  const char* only = i < argc ? argv[i] : NULL;
+
+  Boomerang::get()->setLogger(new NullLogger());
+  setUp();
+
+  std::cout << std::left << std::setw(20) << "benchmark" << std::right << std::setw(10) << "ops" <<
+            std::setw(12) << "best ns/op" << std::setw(14) << "median ns/op" << std::setw(12) << "check" << "\n";
+  bool found = false;
+  for (Benchmark* b = benchmarks; b->name; b++)
+    {
+      if (only && strcmp(only, b->name) != 0)
+        continue;
+      found = true;
+      unsigned ops = (unsigned)(b->ops * scale);
+      if (ops == 0)
+        ops = 1;
+      b->func(ops / 10 + 1);					// Warm up the caches and the allocator
+      std::vector<double> times;
+      for (int r=0; r < reps; r++)
+        {
+          check = 0;
+          double start = microSeconds();
+          b->func(ops);
+          times.push_back((microSeconds() - start) * 1000.0 / ops);
+        }
+      std::sort(times.begin(), times.end());
+      std::cout << std::left << std::setw(20) << b->name << std::right << std::setw(10) << ops <<
+                std::fixed << std::setprecision(1) << std::setw(12) << times[0] << std::setw(14) <<
+                times[times.size()/2] << std::setw(12) << check << "\n";
+    }
+  if (!found)
+    {
+      std::cerr << "no benchmark called " << only << "\n";
+      return 1;
+    }
+  return 0;
+}
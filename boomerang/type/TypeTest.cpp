@@ -137,9 +137,76 @@ void TypeTest::testCompound() {
     actual = p;
     CPPUNIT_ASSERT_EQUAL(expected, actual);
 
+    // The offset of rcPaint is 8, and 8+C is C into it
+    CPPUNIT_ASSERT_EQUAL(8u*8, ty->asCompound()->getOffsetTo("rcPaint"));
+    CPPUNIT_ASSERT_EQUAL(0x0Cu*8, ty->asCompound()->getOffsetRemainder((8 + 0x0C)*8));
+
     delete pFE;
 }
 
+/*==============================================================================
+ * FUNCTION:		TypeTest::testCompoundLayout
+ * OVERVIEW:		Test that the member offsets of a CompoundType follow changes
+ *					to its members, including members that change size in place
+ *============================================================================*/
+void TypeTest::testCompoundLayout() {
+    // Splitting a member must be seen by later lookups
+    CompoundType ct;
+    ct.addType(new IntegerType(32), "a");
+    ct.addType(new IntegerType(32), "b");
+    CPPUNIT_ASSERT_EQUAL(64u, ct.getSize());
+    ct.setTypeAtOffset(0, new CharType());
+    ct.setNameAtOffset(8, "c");
+    CPPUNIT_ASSERT_EQUAL(64u, ct.getSize());
+    CPPUNIT_ASSERT_EQUAL(8u, ct.getOffsetTo("c"));
+    CPPUNIT_ASSERT_EQUAL(32u, ct.getOffsetTo("b"));
+    CPPUNIT_ASSERT_EQUAL(std::string("b"), std::string(ct.getNameAtOffset(40)));
+
+    // So must a member that changes size in place
+    CompoundType cs;
+    IntegerType* a = new IntegerType(16);
+    cs.addType(a, "a");
+    cs.addType(new IntegerType(32), "b");
+    CPPUNIT_ASSERT_EQUAL(16u, cs.getOffsetTo("b"));
+    a->setSize(32);
+    CPPUNIT_ASSERT_EQUAL(32u, cs.getOffsetTo("b"));
+    CPPUNIT_ASSERT_EQUAL(64u, cs.getSize());
+    CPPUNIT_ASSERT_EQUAL(std::string("b"), std::string(cs.getNameAtOffset(40)));
+    bool ch = false;
+    a->meetWith(new IntegerType(64), ch, false);
+    CPPUNIT_ASSERT(ch);
+    CPPUNIT_ASSERT_EQUAL(64u, cs.getOffsetTo("b"));
+    CPPUNIT_ASSERT_EQUAL(96u, cs.getSize());
+
+    // ... or a member of a member
+    CompoundType outer;
+    CompoundType* inner = new CompoundType();
+    IntegerType* x = new IntegerType(8);
+    inner->addType(x, "x");
+    ArrayType* arr = new ArrayType(new CharType(), 4);
+    outer.addType(inner, "in");
+    outer.addType(arr, "arr");
+    outer.addType(new IntegerType(32), "last");
+    CPPUNIT_ASSERT_EQUAL(8u, outer.getOffsetTo("arr"));
+    CPPUNIT_ASSERT_EQUAL(40u, outer.getOffsetTo("last"));
+    x->setSize(16);
+    CPPUNIT_ASSERT_EQUAL(16u, outer.getOffsetTo("arr"));
+    inner->addType(new IntegerType(16), "y");
+    CPPUNIT_ASSERT_EQUAL(32u, outer.getOffsetTo("arr"));
+    arr->setLength(8);
+    CPPUNIT_ASSERT_EQUAL(96u, outer.getOffsetTo("last"));
+    CPPUNIT_ASSERT_EQUAL(128u, outer.getSize());
+    CPPUNIT_ASSERT_EQUAL(std::string("last"), std::string(outer.getNameAtOffset(100)));
+
+    // A named type only has a size once it is defined
+    CompoundType cn;
+    cn.addType(new NamedType("TypeTestLayout"), "n");
+    cn.addType(new IntegerType(32), "after");
+    CPPUNIT_ASSERT_EQUAL(0u, cn.getOffsetTo("after"));
+    Type::addNamedType("TypeTestLayout", new IntegerType(16));
+    CPPUNIT_ASSERT_EQUAL(16u, cn.getOffsetTo("after"));
+}
+
 /*==============================================================================
  * FUNCTION:		TypeTest::testDataInterval
  * OVERVIEW:		Test the DataIntervalMap class
@@ -5,6 +5,7 @@ class TypeTest : public CPPUNIT_NS::TestFixture {
     CPPUNIT_TEST(testTypeLong);
     CPPUNIT_TEST(testNotEqual);
     CPPUNIT_TEST(testCompound);
+    CPPUNIT_TEST(testCompoundLayout);
     CPPUNIT_TEST(testDataInterval);
     CPPUNIT_TEST(testDataIntervalOverlaps);
     CPPUNIT_TEST_SUITE_END();
@@ -17,6 +18,7 @@ protected:
     void testTypeLong();
     void testNotEqual();
     void testCompound();
+    void testCompoundLayout();
 
     void testDataInterval();
     void testDataIntervalOverlaps();
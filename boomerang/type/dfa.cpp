@@ -49,6 +49,7 @@ int max(int a, int b)
 #endif
 
 #define DFA_ITER_LIMIT 20
+#define DFA_CHEAP_ITER_LIMIT 3			// Iteration limit when the proc is over its budget
 
 // m[idx*K1 + K2]; leave idx wild
 static Exp* scaledArrayPat = Location::memOf(
@@ -75,7 +76,6 @@ void init_dfa()
 }
 
 
-static int progress = 0;
 void UserProc::dfaTypeAnalysis()
 {
   Boomerang::get()->alert_decompile_debug_point(this, "before dfa type analysis");
@@ -89,14 +89,18 @@ void UserProc::dfaTypeAnalysis()
   int iter;
   for (iter = 1; iter <= DFA_ITER_LIMIT; iter++)
     {
+      if (iter > DFA_CHEAP_ITER_LIMIT && isOverBudget())
+        {
+          LOG << "### WARNING: abandoning dfaTypeAnalysis of procedure " << getName() << " after " <<
+              DFA_CHEAP_ITER_LIMIT << " iterations (over budget) ###\n";
+          ch = false;		// Don't warn about the iteration limit as well
+          break;
+        }
+      budget.addStatements(stmts.size());
       ch = false;
       for (it = stmts.begin(); it != stmts.end(); it++)
         {
-          if (++progress >= 2000)
-            {
-              progress = 0;
-              std::cerr << "t" << std::flush;
-            }
+          Boomerang::get()->showProgress('t', 2000);
           bool thisCh = false;
           (*it)->dfaTypeAnalysis(thisCh);
           if (thisCh)
@@ -414,6 +418,106 @@ void UserProc::dfaTypeAnalysis()
   Boomerang::get()->alert_decompile_debug_point(this, "after dfa type analysis");
 }
 
+// A copy of ty to install at the other end of a call boundary, so that the caller and callee don't share a Type object
+// that one of them may later change in place. Interned types are never changed, so they can be shared
+static Type* farType(Type* ty)
+{
+  if (ty->isInterned())
+    return ty;
+  return ty->clone();
+}
+
+// Meet the types at one end of a call boundary with those at the other end. Sets chHere or chThere if the meet differs
+// from that end's type. The result is never there's own Type object (but may be here's), so install farType() of it at
+// the far end
+static Type* meetBoundary(Type* here, Type* there, bool& chHere, bool& chThere)
+{
+  if (here == NULL)
+    here = new VoidType;
+  if (there == NULL)
+    there = new VoidType;
+  Type* ty = here->meetWith(there, chHere);
+  if (ty == there)
+    ty = farType(ty);			// E.g. a compound meet with a superstruct
+  if (!(*ty == *there))
+    chThere = true;
+  return ty;
+}
+
+// Meet the types at the boundaries of the calls in this procedure with those of the (user) callees: each argument with
+// the matching parameter of the callee, and each result of the call with the matching return of the callee. Callees
+// whose parameter or return types changed are added to changedCallees.
+// Returns true if the type of an argument or result changed
+bool UserProc::meetCallTypes(std::set<UserProc*>& changedCallees)
+{
+  bool ch = false;
+  StatementList stmts;
+  getStatements(stmts);
+  StatementList::iterator it;
+  for (it = stmts.begin(); it != stmts.end(); it++)
+    {
+      if (!(*it)->isCall()) continue;
+      CallStatement* call = (CallStatement*)*it;
+      Proc* dest = call->getDestProc();
+      if (dest == NULL || dest->isLib()) continue;
+      UserProc* callee = (UserProc*)dest;
+      bool calleeCh = false;
+
+      // As for CallStatement::dfaTypeAnalysis(), argument n is for parameter n of the callee
+      Signature* sig = callee->getSignature();
+      StatementList& args = call->getArguments();
+      StatementList::iterator aa;
+      int n = 0;
+      for (aa = args.begin(); aa != args.end() && n < (int)sig->getNumParams(); ++aa, ++n)
+        {
+          Assign* arg = (Assign*)*aa;
+          bool argCh = false, paramCh = false;
+          Type* ty = meetBoundary(arg->getType(), sig->getParamType(n), argCh, paramCh);
+          if (argCh)
+            arg->setType(ty);
+          if (paramCh)
+            sig->setParamType(n, farType(ty));
+          ch |= argCh;
+          calleeCh |= paramCh;
+        }
+
+      ReturnStatement* rs = call->getCalleeReturn();
+      if (rs)
+        {
+          StatementList& defines = call->getDefines();
+          StatementList::iterator dd;
+          ReturnStatement::iterator rr;
+          for (dd = defines.begin(); dd != defines.end(); ++dd)
+            {
+              Assignment* def = (Assignment*)*dd;
+              for (rr = rs->begin(); rr != rs->end(); ++rr)
+                {
+                  Assignment* ret = (Assignment*)*rr;
+                  if (!(*ret->getLeft() == *def->getLeft())) continue;
+                  bool defCh = false, retCh = false;
+                  Type* ty = meetBoundary(def->getType(), ret->getType(), defCh, retCh);
+                  if (defCh)
+                    def->setType(ty);
+                  if (retCh)
+                    ret->setType(farType(ty));
+                  ch |= defCh;
+                  calleeCh |= retCh;
+                  break;
+                }
+            }
+        }
+
+      if (calleeCh)
+        {
+          if (DEBUG_TA)
+            LOG << "call " << call->getNumber() << " in " << getName() << " changed the boundary types of " <<
+                callee->getName() << "\n";
+          changedCallees.insert(callee);
+        }
+    }
+  return ch;
+}
+
 // This is the core of the data-flow-based type analysis algorithm: implementing the meet operator.
 // In classic lattice-based terms, the TOP type is void; there is no BOTTOM type since we handle overconstraints with
 // unions.
@@ -443,6 +547,7 @@ Type* FuncType::meetWith(Type* other, bool& ch, bool bHighestPtr)
 
 Type* IntegerType::meetWith(Type* other, bool& ch, bool bHighestPtr)
 {
+  if (interned) return meetInterned(other, ch, bHighestPtr);
   if (other->resolvesToVoid()) return this;
   if (other->resolvesToInteger())
     {
@@ -458,7 +563,11 @@ Type* IntegerType::meetWith(Type* other, bool& ch, bool bHighestPtr)
       // Size. Assume 0 indicates unknown size
       unsigned oldSize = size;
       size = max(size, otherInt->size);
-      ch |= (size != oldSize);
+      if (size != oldSize)
+        {
+          ch = true;
+          sizeChanged();
+        }
       return this;
     }
   if (other->resolvesToSize())
@@ -467,6 +576,7 @@ Type* IntegerType::meetWith(Type* other, bool& ch, bool bHighestPtr)
         {
           // Doubt this will ever happen
           size = ((SizeType*)other)->getSize();
+          sizeChanged();
           return this;
         }
       if (size == ((SizeType*)other)->getSize()) return this;
@@ -474,6 +584,8 @@ Type* IntegerType::meetWith(Type* other, bool& ch, bool bHighestPtr)
       unsigned oldSize = size;
       size = max(size, ((SizeType*)other)->getSize());
       ch = size != oldSize;
+      if (ch)
+        sizeChanged();
       return this;
     }
   return createUnion(other, ch, bHighestPtr);
@@ -481,20 +593,29 @@ Type* IntegerType::meetWith(Type* other, bool& ch, bool bHighestPtr)
 
 Type* FloatType::meetWith(Type* other, bool& ch, bool bHighestPtr)
 {
+  if (interned) return meetInterned(other, ch, bHighestPtr);
   if (other->resolvesToVoid()) return this;
   if (other->resolvesToFloat())
     {
       FloatType* otherFlt = other->asFloat();
       unsigned oldSize = size;
       size = max(size, otherFlt->size);
-      ch |= size != oldSize;
+      if (size != oldSize)
+        {
+          ch = true;
+          sizeChanged();
+        }
       return this;
     }
   if (other->resolvesToSize())
     {
       unsigned otherSize = other->getSize();
       ch |= size != otherSize;
-      size = max(size, otherSize);
+      if (otherSize > size)
+        {
+          size = otherSize;
+          sizeChanged();
+        }
       return this;
     }
   return createUnion(other, ch, bHighestPtr);
@@ -525,6 +646,8 @@ Type* CharType::meetWith(Type* other, bool& ch, bool bHighestPtr)
 
 Type* PointerType::meetWith(Type* other, bool& ch, bool bHighestPtr)
 {
+  if (interned) return meetInterned(other, ch, bHighestPtr);
+  if (other == this) return this;					// Note: pointer comparison
   if (other->resolvesToVoid()) return this;
   if (other->resolvesToSize() && ((SizeType*)other)->getSize() == STD_SIZE) return this;
   if (other->resolvesToPointer())
@@ -586,6 +709,7 @@ Type* PointerType::meetWith(Type* other, bool& ch, bool bHighestPtr)
 
 Type* ArrayType::meetWith(Type* other, bool& ch, bool bHighestPtr)
 {
+  if (other == this) return this;
   if (other->resolvesToVoid()) return this;
   if (other->resolvesToArray())
     {
@@ -626,6 +750,7 @@ Type* NamedType::meetWith(Type* other, bool& ch, bool bHighestPtr)
 
 Type* CompoundType::meetWith(Type* other, bool& ch, bool bHighestPtr)
 {
+  if (other == this) return this;					// Not a change, even though it is its own superstruct
   if (other->resolvesToVoid()) return this;
   if (!other->resolvesToCompound())
     {
@@ -689,6 +814,7 @@ Type* UnionType::meetWith(Type* other, bool& ch, bool bHighestPtr)
       if (curr->isCompatibleWith(other))
         {
           it->type = curr->meetWith(other, ch, bHighestPtr);
+          sizeChanged();
           return this;
         }
     }
@@ -720,6 +846,8 @@ Type* SizeType::meetWith(Type* other, bool& ch, bool bHighestPtr)
           unsigned oldSize = size;
           size = max(size, ((SizeType*)other)->size);
           ch = size != oldSize;
+          if (ch)
+            sizeChanged();
         }
       return this;
     }
@@ -750,6 +878,7 @@ Type* UpperType::meetWith(Type* other, bool& ch, bool bHighestPtr)
         {
           ch = true;
           base_type = newBase;
+          sizeChanged();
         }
       return this;
     }
@@ -768,6 +897,7 @@ Type* LowerType::meetWith(Type* other, bool& ch, bool bHighestPtr)
         {
           ch = true;
           base_type = newBase;
+          sizeChanged();
         }
       return this;
     }
@@ -945,7 +1075,7 @@ void Assignment::dfaTypeAnalysis(bool& ch)
 void BranchStatement::dfaTypeAnalysis(bool& ch)
 {
   if (pCond)
-    pCond->descendType(new BooleanType(), ch, this);
+    pCond->descendType(Type::intern(new BooleanType()), ch, this);
   // Not fully implemented yet?
 }
 
@@ -1294,7 +1424,7 @@ void Binary::descendType(Type* parentType, bool& ch, Statement* s)
     case opGtrEqUns:
     case opLessEqUns:
     {
-      nt = new IntegerType(ta->getSize(), -1);			// Used as unsigned
+      nt = Type::intern(new IntegerType(ta->getSize(), -1));	// Used as unsigned
       ta = ta->meetWith(nt, ch);
       tb = tb->meetWith(nt, ch);
       subExp1->descendType(ta, ch, s);
@@ -1306,7 +1436,7 @@ void Binary::descendType(Type* parentType, bool& ch, Statement* s)
     case opGtrEq:
     case opLessEq:
     {
-      nt = new IntegerType(ta->getSize(), +1);			// Used as signed
+      nt = Type::intern(new IntegerType(ta->getSize(), +1));	// Used as signed
       ta = ta->meetWith(nt, ch);
       tb = tb->meetWith(nt, ch);
       subExp1->descendType(ta, ch, s);
@@ -1349,14 +1479,14 @@ void Binary::descendType(Type* parentType, bool& ch, Statement* s)
         }
 
       int parentSize = parentType->getSize();
-      ta = ta->meetWith(new IntegerType(parentSize, signedness), ch);
+      ta = ta->meetWith(Type::intern(new IntegerType(parentSize, signedness)), ch);
       subExp1->descendType(ta, ch, s);
       if (op == opShiftL || op == opShiftR || op == opShiftRA)
         // These operators are not symmetric; doesn't force a signedness on the second operand
         // FIXME: should there be a gentle bias twowards unsigned? Generally, you can't shift by negative
         // amounts.
         signedness = 0;
-      tb = tb->meetWith(new IntegerType(parentSize, signedness), ch);
+      tb = tb->meetWith(Type::intern(new IntegerType(parentSize, signedness)), ch);
       subExp2->descendType(tb, ch, s);
       break;
     }
@@ -1424,7 +1554,7 @@ void Unary::descendType(Type* parentType, bool& ch, Statement* s)
                 parentType->getSize() << "\n";
           // The index is integer type
           Exp* x = ((Binary*)leftOfPlus)->getSubExp1();
-          x->descendType(new IntegerType(parentType->getSize(), 0), ch, s);
+          x->descendType(Type::intern(new IntegerType(parentType->getSize(), 0)), ch, s);
           // K2 is of type <array of parentType>
           Const* constK2 = (Const*)((Binary*)subExp1)->getSubExp2();
           ADDRESS intK2 = (ADDRESS)constK2->getInt();
@@ -1493,7 +1623,7 @@ void Ternary::descendType(Type* parentType, bool& ch, Statement* s)
   switch (op)
     {
     case opFsize:
-      subExp3->descendType(new FloatType(((Const*)subExp1)->getInt()), ch, s);
+      subExp3->descendType(Type::intern(new FloatType(((Const*)subExp1)->getInt())), ch, s);
       break;
     case opZfill:
     case opSgnEx:
@@ -26,6 +26,8 @@
 
 #include <cassert>
 #include <cstring>
+#include <algorithm>
+#include <sstream>
 
 #include "types.h"
 #include "type.h"
@@ -61,7 +63,7 @@ bool Type::isCString()
  * PARAMETERS:		<none>
  * RETURNS:			<Not applicable>
  *============================================================================*/
-Type::Type(eType id) : id(id)
+Type::Type(eType id) : id(id), interned(false)
 {}
 
 VoidType::VoidType() : Type(eVoid)
@@ -84,6 +86,7 @@ CharType::CharType() : Type(eChar)
 
 void PointerType::setPointsTo(Type* p)
 {
+  assert(!interned);
   if (p == this)
     {
       // Note: comparing pointers
@@ -128,13 +131,15 @@ void ArrayType::setBaseType(Type* b)
       length = baseSize / newSize;				// Preserve same byte size for array
     }
   base_type = b;
+  sizeChanged();
 }
 
 
 NamedType::NamedType(const char *name) : Type(eNamed), name(name)
 {}
 
-CompoundType::CompoundType(bool generic /* = false */) : Type(eCompound), nextGenericMemberNum(1), generic(generic)
+CompoundType::CompoundType(bool generic /* = false */) : Type(eCompound), nextGenericMemberNum(1), generic(generic),
+  layoutValid(false), fixedSizes(false), offsetsGeneration(0)
 {}
 
 UnionType::UnionType() : Type(eUnion)
@@ -321,11 +326,8 @@ unsigned NamedType::getSize() const
 }
 unsigned CompoundType::getSize() const
 {
-  int n = 0;
-  for (unsigned i = 0; i < types.size(); i++)
-    // NOTE: this assumes no padding... perhaps explicit padding will be needed
-    n += types[i]->getSize();
-  return n;
+  checkLayout();
+  return offsets[types.size()];
 }
 unsigned UnionType::getSize() const
 {
@@ -345,118 +347,153 @@ unsigned SizeType::getSize() const
 
 
 
-Type *CompoundType::getType(const char *nam)
+// True if the size of ty can't change unless it is replaced by another Type object. Sized integers and floats can be
+// resized in place (unless interned), and the sizes of arrays, named types, compounds and unions depend on others.
+// A compound whose members all have fixed sizes never has to check Type::sizeGeneration
+static bool hasFixedSize(Type* ty)
+{
+  if (ty->isInterned())
+    return true;
+  switch (ty->getId())
+    {
+    case eVoid:
+    case eFunc:
+    case eBoolean:
+    case eChar:
+    case ePointer:
+      return true;
+    default:
+      return false;
+    }
+}
+
+// Rebuild the name index and the offset table. Called lazily when the members have changed since the last build.
+void CompoundType::buildLayout() const
 {
+  nameIndex.clear();
+  fixedSizes = true;
   for (unsigned i = 0; i < types.size(); i++)
-    if (names[i] == nam)
-      return types[i];
-  return NULL;
+    {
+      nameIndex.insert(std::pair<std::string, unsigned>(names[i], i));	// Keeps the first of any duplicates
+      if (!hasFixedSize(types[i]))
+        fixedSizes = false;
+    }
+  buildOffsets();
+  layoutValid = true;
 }
 
-// Note: n is a BIT offset
-Type *CompoundType::getTypeAtOffset(unsigned n)
+// NOTE: member sizes are summed without padding... perhaps explicit padding will be needed
+void CompoundType::buildOffsets() const
 {
+  unsigned num = types.size();
+  offsets.resize(num + 1);
   unsigned offset = 0;
-  for (unsigned i = 0; i < types.size(); i++)
+  for (unsigned i = 0; i < num; i++)
     {
-      if (offset <= n && n < offset + types[i]->getSize())
-        return types[i];
+      offsets[i] = offset;
       offset += types[i]->getSize();
     }
-  return NULL;
+  offsets[num] = offset;
+  offsetsGeneration = sizeGeneration;
+}
+
+// Note: n is a BIT offset. The result is the last member starting at or before n; since the offsets are sorted, and
+// any earlier members starting at the same offset have zero size, this is the one member that contains n
+unsigned CompoundType::memberAt(unsigned n) const
+{
+  checkLayout();
+  unsigned i = std::upper_bound(offsets.begin(), offsets.end(), n) - offsets.begin() - 1;
+  if (i > types.size()) i = types.size();		// Only possible if n is past the end and trailing members are empty
+  return i;
+}
+
+int CompoundType::memberNamed(const char* nam) const
+{
+  checkLayout();
+  std::map<std::string, unsigned>::const_iterator it = nameIndex.find(nam);
+  if (it == nameIndex.end())
+    return -1;
+  return it->second;
+}
+
+Type *CompoundType::getType(const char *nam)
+{
+  int i = memberNamed(nam);
+  if (i == -1)
+    return NULL;
+  return types[i];
+}
+
+// Note: n is a BIT offset
+Type *CompoundType::getTypeAtOffset(unsigned n)
+{
+  unsigned i = memberAt(n);
+  if (i == types.size())
+    return NULL;
+  return types[i];
 }
 
 // Note: n is a BIT offset
 void CompoundType::setTypeAtOffset(unsigned n, Type* ty)
 {
-  unsigned offset = 0;
-  for (unsigned i = 0; i < types.size(); i++)
+  unsigned i = memberAt(n);
+  if (i == types.size())
+    return;
+  unsigned oldsz = types[i]->getSize();
+  types[i] = ty;
+  if (ty->getSize() < oldsz)
     {
-      if (offset <= n && n < offset + types[i]->getSize())
+      types.push_back(types[types.size()-1]);
+      names.push_back(names[names.size()-1]);
+      for (unsigned n = types.size() - 1; n > i; n--)
         {
-          unsigned oldsz = types[i]->getSize();
-          types[i] = ty;
-          if (ty->getSize() < oldsz)
-            {
-              types.push_back(types[types.size()-1]);
-              names.push_back(names[names.size()-1]);
-              for (unsigned n = types.size() - 1; n > i; n--)
-                {
-                  types[n] = types[n-1];
-                  names[n] = names[n-1];
-                }
-              types[i+1] = new SizeType(oldsz - ty->getSize());
-              names[i+1] = "pad";
-            }
-          return;
+          types[n] = types[n-1];
+          names[n] = names[n-1];
         }
-      offset += types[i]->getSize();
+      types[i+1] = new SizeType(oldsz - ty->getSize());
+      names[i+1] = "pad";
     }
+  layoutValid = false;
+  sizeChanged();
 }
 
 void CompoundType::setNameAtOffset(unsigned n, const char *nam)
 {
-  unsigned offset = 0;
-  for (unsigned i = 0; i < types.size(); i++)
-    {
-      if (offset <= n && n < offset + types[i]->getSize())
-        {
-          names[i] = nam;
-          return;
-        }
-      offset += types[i]->getSize();
-    }
+  unsigned i = memberAt(n);
+  if (i == types.size())
+    return;
+  names[i] = nam;
+  layoutValid = false;
 }
 
 
 const char *CompoundType::getNameAtOffset(unsigned n)
 {
-  unsigned offset = 0;
-  for (unsigned i = 0; i < types.size(); i++)
-    {
-      //if (offset >= n && n < offset + types[i]->getSize())
-      if (offset <= n && n < offset + types[i]->getSize())
-        //return getName(offset == n ? i : i - 1);
-        return names[i].c_str();
-      offset += types[i]->getSize();
-    }
-  return NULL;
+  unsigned i = memberAt(n);
+  if (i == types.size())
+    return NULL;
+  return names[i].c_str();
 }
 
 unsigned CompoundType::getOffsetTo(unsigned n)
 {
-  unsigned offset = 0;
-  for (unsigned i = 0; i < n; i++)
-    {
-      offset += types[i]->getSize();
-    }
-  return offset;
+  assert(n <= types.size());
+  checkLayout();
+  return offsets[n];
 }
 
 unsigned CompoundType::getOffsetTo(const char *member)
 {
-  unsigned offset = 0;
-  for (unsigned i = 0; i < types.size(); i++)
-    {
-      if (names[i] == member)
-        return offset;
-      offset += types[i]->getSize();
-    }
-  return (unsigned)-1;
+  int i = memberNamed(member);
+  if (i == -1)
+    return (unsigned)-1;
+  return offsets[i];
 }
 
 unsigned CompoundType::getOffsetRemainder(unsigned n)
 {
-  unsigned r = n;
-  unsigned offset = 0;
-  for (unsigned i = 0; i < types.size(); i++)
-    {
-      offset += types[i]->getSize();
-      if (offset > n)
-        break;
-      r -= types[i]->getSize();
-    }
-  return r;
+  // The offset of n from the start of the member containing it, or from the end of the compound if past the end
+  return n - offsets[memberAt(n)];
 }
 
 /*==============================================================================
@@ -512,6 +549,7 @@ bool VoidType::operator==(const Type& other) const
 
 bool FuncType::operator==(const Type& other) const
 {
+  if (this == &other) return true;		// Note: pointer comparison
   if (!other.isFunc()) return false;
   // Note: some functions don't have a signature (e.g. indirect calls that have not yet been successfully analysed)
   if (signature == NULL) return ((FuncType&)other).signature == NULL;
@@ -522,6 +560,7 @@ static int pointerCompareNest = 0;
 bool PointerType::operator==(const Type& other) const
 {
 //	return other.isPointer() && (*points_to == *((PointerType&)other).points_to);
+  if (this == &other) return true;		// Note: pointer comparison
   if (!other.isPointer()) return false;
   if (++pointerCompareNest >= 20)
     {
@@ -535,6 +574,7 @@ bool PointerType::operator==(const Type& other) const
 
 bool ArrayType::operator==(const Type& other) const
 {
+  if (this == &other) return true;
   return other.isArray() && *base_type == *((ArrayType&)other).base_type &&
          ((ArrayType&)other).length == length;
 }
@@ -546,11 +586,12 @@ bool NamedType::operator==(const Type& other) const
 
 bool CompoundType::operator==(const Type& other) const
 {
+  if (this == &other) return true;
   const CompoundType &cother = (CompoundType&)other;
   if (other.isCompound() && cother.types.size() == types.size())
     {
       for (unsigned i = 0; i < types.size(); i++)
-        if (!(*types[i] == *cother.types[i]))
+        if (types[i] != cother.types[i] && !(*types[i] == *cother.types[i]))
           return false;
       return true;
     }
@@ -559,12 +600,13 @@ bool CompoundType::operator==(const Type& other) const
 
 bool UnionType::operator==(const Type& other) const
 {
+  if (this == &other) return true;
   const UnionType &uother = (UnionType&)other;
   std::list<UnionElement>::const_iterator it1, it2;
   if (other.isUnion() && uother.li.size() == li.size())
     {
       for (it1 = li.begin(), it2 = uother.li.begin(); it1 != li.end(); it1++, it2++)
-        if (!(*it1->type == *it2->type))
+        if (it1->type != it2->type && !(*it1->type == *it2->type))
           return false;
       return true;
     }
@@ -577,11 +619,13 @@ bool SizeType::operator==(const Type& other) const
 }
 bool UpperType::operator==(const Type& other) const
 {
+  if (this == &other) return true;
   return other.isUpper() && *base_type == *((UpperType&)other).base_type;
 }
 
 bool LowerType::operator==(const Type& other) const
 {
+  if (this == &other) return true;
   return other.isLower() && *base_type == *((LowerType&)other).base_type;
 }
 
@@ -1038,6 +1082,9 @@ void Type::dump()
 }
 
 std::map<std::string, Type*> Type::namedTypes;
+unsigned Type::sizeGeneration = 0;
+std::map<std::string, Type*> Type::internedTypes;
+std::map<Type::MeetKey, std::pair<Type*, bool> > Type::meetMemo;
 
 // named type accessors
 void Type::addNamedType(const char *name, Type *type)
@@ -1070,6 +1117,7 @@ void Type::addNamedType(const char *name, Type *type)
         {
           namedTypes[name] = type->clone();
         }
+      sizeChanged();						// Any NamedType of this name now has a size
     }
 }
 
@@ -1080,6 +1128,95 @@ Type *Type::getNamedType(const char *name)
   return NULL;
 }
 
+/*==============================================================================
+ * FUNCTION:		Type::intern
+ * OVERVIEW:		Hash-cons a newly allocated type, so that all equal types of the simple kinds share one object.
+ *					Only used when interning is enabled (-Ti)
+ * PARAMETERS:		ty - the new type; deleted if an equal type is already interned. A pointer is only interned if
+ *					  the type it points to is interned already
+ * RETURNS:			The interned type, or ty itself if it can't be interned
+ *============================================================================*/
+Type* Type::intern(Type* ty)
+{
+  if (!Boomerang::get()->internTypes || ty->interned)
+    return ty;
+  std::ostringstream ost;
+  switch (ty->id)
+    {
+    case eVoid:
+      ost << "v";
+      break;
+    case eBoolean:
+      ost << "b";
+      break;
+    case eChar:
+      ost << "c";
+      break;
+    case eInteger:
+    {
+      IntegerType* it = (IntegerType*)ty;
+      if (it->getSize() == 0)
+        return ty;					// Could still be given a size
+      // Only the sign of the signedness is significant
+      int sg = it->getSignedness();
+      it->setSigned(sg < 0 ? -1 : (sg > 0 ? 1 : 0));
+      ost << "i" << it->getSize() << ":" << it->getSignedness();
+      break;
+    }
+    case eFloat:
+      if (ty->getSize() == 0)
+        return ty;
+      ost << "f" << ty->getSize();
+      break;
+    case ePointer:
+    {
+      Type* pointsTo = ((PointerType*)ty)->getPointsTo();
+      if (!pointsTo->interned)
+        return ty;
+      ost << "p" << (void*)pointsTo;
+      break;
+    }
+    default:
+      return ty;
+    }
+  std::map<std::string, Type*>::iterator it = internedTypes.find(ost.str());
+  if (it != internedTypes.end())
+    {
+      delete ty;
+      return it->second;
+    }
+  ty->interned = true;
+  internedTypes[ost.str()] = ty;
+  return ty;
+}
+
+// meetWith() for an interned type, which can't be changed in place. Meets of two interned types are remembered
+Type* Type::meetInterned(Type* other, bool& ch, bool bHighestPtr)
+{
+  if (other == this)								// Note: pointer comparison
+    return this;
+  MeetKey key(std::pair<Type*, Type*>(this, other), bHighestPtr);
+  if (other->interned)
+    {
+      std::map<MeetKey, std::pair<Type*, bool> >::iterator mm = meetMemo.find(key);
+      if (mm != meetMemo.end())
+        {
+          ch |= mm->second.second;
+          return mm->second.first;
+        }
+    }
+  bool thisCh = false;
+  Type* ret = clone()->meetWith(other, thisCh, bHighestPtr);
+  if (!thisCh)
+    ret = this;									// Nothing new; keep sharing
+  else
+    ret = intern(ret);
+  if (other->interned && ret->interned)
+    meetMemo[key] = std::pair<Type*, bool>(ret, thisCh);
+  ch |= thisCh;
+  return ret;
+}
+
 void Type::dumpNames()
 {
   std::map<std::string, Type*>::iterator it;
@@ -1233,7 +1370,10 @@ Type *NamedType::resolvesTo() const
 void ArrayType::fixBaseType(Type *b)
 {
   if (base_type == NULL)
-    base_type = b;
+    {
+      base_type = b;
+      sizeChanged();
+    }
   else
     {
       assert(base_type->isArray());
@@ -1432,6 +1572,12 @@ bool CompoundType::isSubStructOf(Type* other)
 bool UnionType::findType(Type* ty)
 {
   std::list<UnionElement>::iterator it;
+  // Interned (and other shared) types are usually found by pointer, without any deep comparisons
+  for (it = li.begin(); it != li.end(); it++)
+    {
+      if (it->type == ty)
+        return true;
+    }
   for (it = li.begin(); it != li.end(); it++)
     {
       if (*it->type == *ty)
@@ -1813,6 +1959,7 @@ void UnionType::addType(Type *n, const char *str)
       ue.name = str;
       li.push_back(ue);
     }
+  sizeChanged();
 }
 
 // Update this compound to use the fact that offset off has type ty
@@ -1882,6 +2029,7 @@ void IntegerType::readMemo(Memo *mm, bool dec)
   IntegerTypeMemo *m = dynamic_cast<IntegerTypeMemo*>(mm);
   size = m->size;
   signedness = m->signedness;
+  sizeChanged();
 }
 
 class FloatTypeMemo : public Memo
@@ -1903,6 +2051,7 @@ void FloatType::readMemo(Memo *mm, bool dec)
 {
   FloatTypeMemo *m = dynamic_cast<FloatTypeMemo*>(mm);
   size = m->size;
+  sizeChanged();
 }
 
 class PointerTypeMemo : public Memo
@@ -1956,6 +2105,7 @@ void ArrayType::readMemo(Memo *mm, bool dec)
   ArrayTypeMemo *m = dynamic_cast<ArrayTypeMemo*>(mm);
   length = m->length;
   base_type = m->base_type;
+  sizeChanged();
 
   base_type->restoreMemo(m->mId, dec);
 }
@@ -2009,6 +2159,8 @@ void CompoundType::readMemo(Memo *mm, bool dec)
   CompoundTypeMemo *m = dynamic_cast<CompoundTypeMemo*>(mm);
   types = m->types;
   names = m->names;
+  layoutValid = false;
+  sizeChanged();
 
   for (std::vector<Type*>::iterator it = types.begin(); it != types.end(); it++)
     (*it)->restoreMemo(m->mId, dec);
@@ -2036,6 +2188,7 @@ void UnionType::readMemo(Memo *mm, bool dec)
 {
   UnionTypeMemo *m = dynamic_cast<UnionTypeMemo*>(mm);
   li = m->li;
+  sizeChanged();
 
   for (std::list<UnionElement>::iterator it = li.begin(); it != li.end(); it++)
     it->type->restoreMemo(m->mId, dec);